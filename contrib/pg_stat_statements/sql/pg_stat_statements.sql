@@ -284,6 +284,18 @@ SELECT query, calls, rows FROM pg_stat_statements ORDER BY query COLLATE "C";
 SELECT pg_stat_statements_reset(0,0,0);
 SELECT query, calls, rows FROM pg_stat_statements ORDER BY query COLLATE "C";
 
+--
+-- WAL usage
+--
+SELECT pg_stat_statements_reset();
+CREATE TABLE pgss_wal_test (a int);
+INSERT INTO pgss_wal_test SELECT generate_series(1, 10);
+UPDATE pgss_wal_test SET a = a + 1 WHERE a > 5;
+SELECT query, calls, rows, wal_records > 0 AS wal_records_generated
+  FROM pg_stat_statements WHERE query LIKE '%pgss_wal_test%'
+  ORDER BY query COLLATE "C";
+DROP TABLE pgss_wal_test;
+
 --
 -- cleanup
 --
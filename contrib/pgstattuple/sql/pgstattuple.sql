@@ -117,3 +117,17 @@ drop view test_view;
 drop foreign table test_foreign_table;
 drop server dummy_server;
 drop foreign data wrapper dummy;
+
+-- With autocleanup, an insertion leaves the cleanup of the pending list to
+-- autovacuum once it passes gin_pending_list_limit, but does it right away
+-- at twice the limit, so the list never grows past that: 2 * 64kB is 17
+-- pending pages at most.  gin_clean_pending_list() then flushes it.
+create table test_gin_pending (a int[]);
+create index test_gin_pending_idx on test_gin_pending using gin (a)
+    with (fastupdate = on, autocleanup = on, gin_pending_list_limit = 64);
+insert into test_gin_pending select array[g, g + 1] from generate_series(1, 10000) g;
+select pending_pages <= 17 as bounded from pgstatginindex('test_gin_pending_idx');
+select gin_clean_pending_list('test_gin_pending_idx') >= 0 as ok;
+select * from pgstatginindex('test_gin_pending_idx');
+select count(*) from test_gin_pending where a @> array[5000];
+drop table test_gin_pending;
@@ -176,12 +176,14 @@ brininsert(Relation idxRel, Datum *values, bool *nulls,
 		CHECK_FOR_INTERRUPTS();
 
 		/*
-		 * If auto-summarization is enabled and we just inserted the first
-		 * tuple into the first block of a new non-first page range, request a
-		 * summarization run of the previous range.
+		 * If we just inserted the first tuple into the first block of a new
+		 * non-first page range, the previous range is now full.  If it is
+		 * not summarized, count it in the index's statistics, and if
+		 * auto-summarization is enabled, request a summarization run of it.
+		 * Should the request not be recorded, autovacuum still finds the
+		 * range through the statistics counter.
 		 */
-		if (autosummarize &&
-			heapBlk > 0 &&
+		if (heapBlk > 0 &&
 			heapBlk == origHeapBlk &&
 			ItemPointerGetOffsetNumber(heaptid) == FirstOffsetNumber)
 		{
@@ -193,12 +195,12 @@ brininsert(Relation idxRel, Datum *values, bool *nulls,
 										 NULL, BUFFER_LOCK_SHARE, NULL);
 			if (!lastPageTuple)
 			{
-				bool		recorded;
+				pgstat_count_unsummarized_ranges(idxRel, 1);
 
-				recorded = AutoVacuumRequestWork(AVW_BRINSummarizeRange,
-												 RelationGetRelid(idxRel),
-												 lastPageRange);
-				if (!recorded)
+				if (autosummarize &&
+					!AutoVacuumRequestWork(AVW_BRINSummarizeRange,
+										   RelationGetRelid(idxRel),
+										   lastPageRange))
 					ereport(LOG,
 							(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
 							 errmsg("request for BRIN range summarization for index \"%s\" page %u was not recorded",
@@ -791,6 +793,7 @@ IndexBulkDeleteResult *
 brinvacuumcleanup(IndexVacuumInfo *info, IndexBulkDeleteResult *stats)
 {
 	Relation	heapRel;
+	double		numSummarized = 0;
 
 	/* No-op in ANALYZE ONLY mode */
 	if (info->analyze_only)
@@ -807,7 +810,18 @@ brinvacuumcleanup(IndexVacuumInfo *info, IndexBulkDeleteResult *stats)
 	brin_vacuum_scan(info->index, info->strategy);
 
 	brinsummarize(info->index, heapRel, BRIN_ALL_BLOCKRANGES, false,
-				  &stats->num_index_tuples, &stats->num_index_tuples);
+				  &numSummarized, &stats->num_index_tuples);
+	stats->num_index_tuples += numSummarized;
+
+	/*
+	 * Ranges left unsummarized since the last vacuum match every scan, so
+	 * report how many we found; a large number suggests enabling
+	 * autosummarize.
+	 */
+	ereport(info->message_level,
+			(errmsg("index \"%s\" now has %.0f summarized page ranges, %.0f newly summarized",
+					RelationGetRelationName(info->index),
+					stats->num_index_tuples, numSummarized)));
 
 	table_close(heapRel, AccessShareLock);
 
@@ -1365,6 +1379,7 @@ brinsummarize(Relation index, Relation heapRel, BlockNumber pageRange,
 
 			if (numSummarized)
 				*numSummarized += 1.0;
+			pgstat_count_unsummarized_ranges(index, -1);
 		}
 		else
 		{
@@ -1377,6 +1392,13 @@ brinsummarize(Relation index, Relation heapRel, BlockNumber pageRange,
 	if (BufferIsValid(buf))
 		ReleaseBuffer(buf);
 
+	/*
+	 * After a scan of the whole table, no full range is left unsummarized,
+	 * so let the statistics collector start counting from zero again.
+	 */
+	if (pageRange == BRIN_ALL_BLOCKRANGES)
+		pgstat_reset_unsummarized_ranges(index);
+
 	/* free resources */
 	brinRevmapTerminate(revmap);
 	if (state)
@@ -0,0 +1,436 @@
+/*
+ * brin_bloom.c
+ *		Implementation of Bloom opclass for BRIN
+ *
+ * A BRIN opclass summarizing page range into a Bloom filter.
+ *
+ * Bloom filters allow efficient testing whether a given page range contains
+ * a particular value.  Therefore, if we summarize each page range into a
+ * Bloom filter, we can easily and cheaply test whether it contains values
+ * we get later.
+ *
+ * The index only supports equality operators, similarly to hash indexes.
+ * Bloom indexes are however much smaller, and support only bitmap scans.
+ *
+ * Note: Don't confuse this with bloom indexes, implemented in a contrib
+ * module.  That extension implements an entirely new AM, building a bloom
+ * filter on multiple columns in a single row.  This opclass works with an
+ * existing AM (BRIN) and builds bloom filter on a column.
+ *
+ *
+ * values vs. hashes
+ * -----------------
+ *
+ * The original column values are not used directly, but are first hashed
+ * using the regular type-specific hash function, producing a uint32 hash.
+ * That hash value is then added to the summary, using the generic Bloom
+ * filter implementation in lib/bloomfilter.c.  Hashing with the opclass'
+ * hash function first means values that are equal according to the
+ * operator (e.g. numeric 1.0 and 1.00) end up in the same place in the
+ * filter, even if their binary representations differ.
+ *
+ *
+ * sizing the bloom filter
+ * -----------------------
+ *
+ * Size of a bloom filter depends on the number of distinct values we will
+ * store in it, and the desired false positive rate.  The higher the number
+ * of distinct values and/or the lower the false positive rate, the larger
+ * the bloom filter.  We assume a page range may contain a number of distinct
+ * values equal to BLOOM_NDISTINCT_FRACTION of the maximum number of tuples
+ * it can hold, and aim for a false positive rate of BLOOM_FALSE_POSITIVE_RATE.
+ * The filter is however capped so that the summaries of all columns fit
+ * into half a page, so for columns with many distinct values per range it's
+ * advisable to use a smaller pages_per_range.
+ *
+ * The filter geometry is derived from pages_per_range, which is fixed at
+ * index creation.  Should two summaries with different geometry ever have
+ * to be merged, the result is marked as matching everything, which is
+ * always correct, if not very useful.
+ *
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/brin/brin_bloom.c
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/brin.h"
+#include "access/brin_internal.h"
+#include "access/brin_tuple.h"
+#include "access/genam.h"
+#include "access/htup_details.h"
+#include "access/stratnum.h"
+#include "catalog/pg_am.h"
+#include "catalog/pg_type.h"
+#include "lib/bloomfilter.h"
+#include "utils/builtins.h"
+#include "utils/datum.h"
+#include "utils/rel.h"
+
+
+/*
+ * Additional SQL level support functions: the type's hash function.
+ *
+ * Procedure numbers must not use values reserved for BRIN itself; see
+ * brin_internal.h.
+ */
+#define		PROCNUM_HASH			11	/* required */
+
+/* the only supported strategy, equality */
+#define		BloomEqualStrategyNumber	1
+
+/*
+ * Assumed fraction of distinct values among the maximum number of tuples
+ * in a page range, and the false positive rate we aim for.
+ */
+#define		BLOOM_NDISTINCT_FRACTION	0.1
+#define		BLOOM_FALSE_POSITIVE_RATE	0.01
+
+/*
+ * Bounds on the size of the filter, in bits.  The upper bound is shared by
+ * all columns of the index, so that the index tuple fits on a page.
+ */
+#define		BLOOM_MIN_BITS				64
+#define		BLOOM_MAX_BYTES				(BLCKSZ / 2)
+
+/*
+ * The summary stored in the index tuple: a bytea with a small header, and
+ * the flat Bloom filter image following at a MAXALIGN'ed offset.  Because
+ * index tuple values are copied into palloc'd memory when deformed, the
+ * filter can usually be used and updated in place.
+ */
+typedef struct BloomSummary
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	uint32		flags;			/* BLOOM_SUMMARY_* flags */
+	/* Bloom filter follows */
+} BloomSummary;
+
+/* the filter does not track values any more, and matches everything */
+#define BLOOM_SUMMARY_MATCH_ALL		0x0001
+
+#define BloomSummaryFilterOffset	MAXALIGN(sizeof(BloomSummary))
+#define BloomSummaryGetFilter(summary) \
+	((bloom_filter *) ((char *) (summary) + BloomSummaryFilterOffset))
+
+static BloomSummary *bloom_init_summary(BrinDesc *bdesc);
+static BloomSummary *bloom_get_summary(Datum value);
+
+
+Datum
+brin_bloom_opcinfo(PG_FUNCTION_ARGS)
+{
+	BrinOpcInfo *result;
+
+	/*
+	 * The summary is stored as a bytea, regardless of the indexed type.  The
+	 * hash function is looked up through the index's support function cache,
+	 * so we don't need any private state.
+	 */
+	result = palloc0(SizeofBrinOpcInfo(1));
+	result->oi_nstored = 1;
+	result->oi_opaque = NULL;
+	result->oi_typcache[0] = lookup_type_cache(BYTEAOID, 0);
+
+	PG_RETURN_POINTER(result);
+}
+
+/*
+ * Examine the given index tuple (which contains partial status of a certain
+ * page range) by comparing it to the given value that comes from another heap
+ * tuple.  If the new value is not already represented in the Bloom filter,
+ * add it and return true.  Otherwise, return false and do not modify in this
+ * case.
+ */
+Datum
+brin_bloom_add_value(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	Datum		newval = PG_GETARG_DATUM(2);
+	bool		isnull = PG_GETARG_DATUM(3);
+	Oid			colloid = PG_GET_COLLATION();
+	FmgrInfo   *hashFn;
+	uint32		hashValue;
+	bool		updated = false;
+	AttrNumber	attno;
+	BloomSummary *summary;
+	bloom_filter *filter;
+
+	/*
+	 * If the new value is null, we record that we saw it if it's the first
+	 * one; otherwise, there's nothing to do.
+	 */
+	if (isnull)
+	{
+		if (column->bv_hasnulls)
+			PG_RETURN_BOOL(false);
+
+		column->bv_hasnulls = true;
+		PG_RETURN_BOOL(true);
+	}
+
+	attno = column->bv_attno;
+
+	/*
+	 * If this is the first non-null value, we need to initialize the bloom
+	 * filter.  Otherwise just extract the existing bloom filter from
+	 * BrinValues, switching to a private copy if it can't be modified in
+	 * place.
+	 */
+	if (column->bv_allnulls)
+	{
+		summary = bloom_init_summary(bdesc);
+		column->bv_values[0] = PointerGetDatum(summary);
+		column->bv_allnulls = false;
+		updated = true;
+	}
+	else
+	{
+		summary = bloom_get_summary(column->bv_values[0]);
+		if ((Pointer) summary != DatumGetPointer(column->bv_values[0]))
+		{
+			pfree(DatumGetPointer(column->bv_values[0]));
+			column->bv_values[0] = PointerGetDatum(summary);
+		}
+	}
+
+	/* a summary matching everything can't be made any less selective */
+	if (summary->flags & BLOOM_SUMMARY_MATCH_ALL)
+		PG_RETURN_BOOL(updated);
+
+	/*
+	 * Compute the hash of the new value, using the supplied hash function,
+	 * and then add the hash value to the bloom filter.
+	 */
+	hashFn = index_getprocinfo(bdesc->bd_index, attno, PROCNUM_HASH);
+	hashValue = DatumGetUInt32(FunctionCall1Coll(hashFn, colloid, newval));
+
+	filter = BloomSummaryGetFilter(summary);
+	if (bloom_lacks_element(filter, (unsigned char *) &hashValue,
+							sizeof(hashValue)))
+	{
+		bloom_add_element(filter, (unsigned char *) &hashValue,
+						  sizeof(hashValue));
+		updated = true;
+	}
+
+	PG_RETURN_BOOL(updated);
+}
+
+/*
+ * Given an index tuple corresponding to a certain page range and a scan key,
+ * return whether the scan key is consistent with the index tuple's bloom
+ * filter.  Return true if so, false otherwise.
+ */
+Datum
+brin_bloom_consistent(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	ScanKey		key = (ScanKey) PG_GETARG_POINTER(2);
+	Oid			colloid = PG_GET_COLLATION();
+	AttrNumber	attno;
+	FmgrInfo   *finfo;
+	uint32		hashValue;
+	BloomSummary *summary;
+	bool		matches;
+
+	Assert(key->sk_attno == column->bv_attno);
+
+	/* handle IS NULL/IS NOT NULL tests */
+	if (key->sk_flags & SK_ISNULL)
+	{
+		if (key->sk_flags & SK_SEARCHNULL)
+		{
+			if (column->bv_allnulls || column->bv_hasnulls)
+				PG_RETURN_BOOL(true);
+			PG_RETURN_BOOL(false);
+		}
+
+		/*
+		 * For IS NOT NULL, we can only skip ranges that are known to have
+		 * only nulls.
+		 */
+		if (key->sk_flags & SK_SEARCHNOTNULL)
+			PG_RETURN_BOOL(!column->bv_allnulls);
+
+		/*
+		 * Neither IS NULL nor IS NOT NULL was used; assume all indexable
+		 * operators are strict and return false.
+		 */
+		PG_RETURN_BOOL(false);
+	}
+
+	/* if the range is all empty, it cannot possibly be consistent */
+	if (column->bv_allnulls)
+		PG_RETURN_BOOL(false);
+
+	summary = bloom_get_summary(column->bv_values[0]);
+
+	if (summary->flags & BLOOM_SUMMARY_MATCH_ALL)
+		matches = true;
+	else
+	{
+		attno = key->sk_attno;
+		switch (key->sk_strategy)
+		{
+			case BloomEqualStrategyNumber:
+
+				/*
+				 * In the equality case (WHERE col = someval), we want to
+				 * return the current page range if the hash of the scan key
+				 * may be in the bloom filter.
+				 */
+				finfo = index_getprocinfo(bdesc->bd_index, attno, PROCNUM_HASH);
+				hashValue = DatumGetUInt32(FunctionCall1Coll(finfo, colloid,
+															 key->sk_argument));
+				matches = !bloom_lacks_element(BloomSummaryGetFilter(summary),
+											   (unsigned char *) &hashValue,
+											   sizeof(hashValue));
+				break;
+			default:
+				/* shouldn't happen */
+				elog(ERROR, "invalid strategy number %d", key->sk_strategy);
+				matches = false;
+				break;
+		}
+	}
+
+	if ((Pointer) summary != DatumGetPointer(column->bv_values[0]))
+		pfree(summary);
+
+	PG_RETURN_BOOL(matches);
+}
+
+/*
+ * Given two BrinValues, update the first of them as a union of the summary
+ * values contained in both.  The second one is untouched.
+ *
+ * As long as both filters were built with the same parameters, the union
+ * is simply a bitwise OR of the two bitmaps.
+ */
+Datum
+brin_bloom_union(PG_FUNCTION_ARGS)
+{
+	BrinValues *col_a = (BrinValues *) PG_GETARG_POINTER(1);
+	BrinValues *col_b = (BrinValues *) PG_GETARG_POINTER(2);
+	BloomSummary *summary_a;
+	BloomSummary *summary_b;
+
+	Assert(col_a->bv_attno == col_b->bv_attno);
+
+	/* Adjust "hasnulls" */
+	if (!col_a->bv_hasnulls && col_b->bv_hasnulls)
+		col_a->bv_hasnulls = true;
+
+	/* If there are no values in B, there's nothing left to do */
+	if (col_b->bv_allnulls)
+		PG_RETURN_VOID();
+
+	/*
+	 * Adjust "allnulls".  If A doesn't have values, just copy the values from
+	 * B into A, and we're done.  We cannot run the operators in this case,
+	 * because values in A might contain garbage.  Note we already established
+	 * that B contains values.
+	 */
+	if (col_a->bv_allnulls)
+	{
+		col_a->bv_allnulls = false;
+		col_a->bv_values[0] = datumCopy(col_b->bv_values[0], false, -1);
+		PG_RETURN_VOID();
+	}
+
+	summary_a = bloom_get_summary(col_a->bv_values[0]);
+	if ((Pointer) summary_a != DatumGetPointer(col_a->bv_values[0]))
+	{
+		pfree(DatumGetPointer(col_a->bv_values[0]));
+		col_a->bv_values[0] = PointerGetDatum(summary_a);
+	}
+	summary_b = bloom_get_summary(col_b->bv_values[0]);
+
+	if (summary_b->flags & BLOOM_SUMMARY_MATCH_ALL)
+		summary_a->flags |= BLOOM_SUMMARY_MATCH_ALL;
+	else if (!(summary_a->flags & BLOOM_SUMMARY_MATCH_ALL) &&
+			 !bloom_union(BloomSummaryGetFilter(summary_a),
+						  BloomSummaryGetFilter(summary_b)))
+	{
+		/*
+		 * The filters were built with different parameters, so they cannot
+		 * be merged.  Give up on filtering this range.
+		 */
+		summary_a->flags |= BLOOM_SUMMARY_MATCH_ALL;
+	}
+
+	if ((Pointer) summary_b != DatumGetPointer(col_b->bv_values[0]))
+		pfree(summary_b);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Create an empty summary, sized according to the index's pages_per_range.
+ */
+static BloomSummary *
+bloom_init_summary(BrinDesc *bdesc)
+{
+	double		ndistinct;
+	double		nbits;
+	uint64		maxbits;
+	uint64		bits;
+	bloom_filter *filter;
+	BloomSummary *summary;
+	Size		len;
+
+	ndistinct = (double) BrinGetPagesPerRange(bdesc->bd_index) *
+		MaxHeapTuplesPerPage * BLOOM_NDISTINCT_FRACTION;
+	ndistinct = Max(ndistinct, 1.0);
+
+	/* optimal number of bits for the desired false positive rate */
+	nbits = ceil(-(ndistinct * log(BLOOM_FALSE_POSITIVE_RATE)) /
+				 pow(log(2.0), 2));
+
+	/* the filter size must be a power of two, within our limits */
+	maxbits = (uint64) (BLOOM_MAX_BYTES / bdesc->bd_tupdesc->natts) *
+		BITS_PER_BYTE;
+	bits = BLOOM_MIN_BITS;
+	while (bits < nbits && bits * 2 <= maxbits)
+		bits *= 2;
+
+	filter = bloom_create_fixed(bits, (int64) ndistinct, 0);
+
+	len = BloomSummaryFilterOffset + bloom_size(filter);
+	summary = (BloomSummary *) palloc0(len);
+	SET_VARSIZE(summary, len);
+	summary->flags = 0;
+	memcpy(BloomSummaryGetFilter(summary), filter, bloom_size(filter));
+
+	bloom_free(filter);
+
+	return summary;
+}
+
+/*
+ * Return the summary stored in the given datum, in a form that allows
+ * accessing the Bloom filter directly.
+ *
+ * Summaries created by bloom_init_summary, or copied into palloc'd memory by
+ * brin_deform_tuple, are returned as is.  If the datum has a short header or
+ * is not suitably aligned, a palloc'd copy is returned instead.
+ */
+static BloomSummary *
+bloom_get_summary(Datum value)
+{
+	struct varlena *summary = (struct varlena *) DatumGetPointer(value);
+
+	if (VARATT_IS_EXTENDED(summary) ||
+		(uintptr_t) summary != MAXALIGN((uintptr_t) summary))
+		summary = pg_detoast_datum_copy(summary);
+
+	return (BloomSummary *) summary;
+}
@@ -0,0 +1,862 @@
+/*
+ * brin_minmax_multi.c
+ *		Implementation of Multi Min/Max opclass for BRIN
+ *
+ * Implements a variant of minmax opclass, where the summary is composed of
+ * multiple smaller intervals.  This allows us to handle outliers, which
+ * usually make the simple minmax opclass inefficient.
+ *
+ * Consider for example page range with simple minmax interval [1000,2000],
+ * and assume a new row gets inserted into the range with value 1000000.
+ * Due to that the interval gets [1000,1000000].  I.e. the minmax interval
+ * got 1000x wider and won't be useful to eliminate scan keys between 2001
+ * and 1000000.
+ *
+ * With minmax-multi opclass, we may have [1000,2000] interval initially,
+ * but after adding the new row we start tracking it as two interval:
+ *
+ *   [1000,2000] and [1000000,1000000]
+ *
+ * This allows us to still eliminate the page range when the scan keys hit
+ * the gap between 2000 and 1000000, making it useful in cases when the
+ * simple minmax opclass gets inefficient.
+ *
+ * The number of intervals tracked per page range is limited to
+ * MINMAX_MAX_RANGES.  When a new value arrives that would exceed the limit,
+ * the two adjacent intervals closest to each other are merged, so that the
+ * largest gaps in the data are the ones preserved.  This requires a
+ * "distance" support function, which calculates the distance between two
+ * values of the data type (procedure number 11).
+ *
+ * The summary is stored as a bytea, holding the sorted boundaries of the
+ * non-overlapping intervals.  A single value is stored as an interval with
+ * equal boundaries.
+ *
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/brin/brin_minmax_multi.c
+ */
+#include "postgres.h"
+
+#include "access/brin_internal.h"
+#include "access/brin_tuple.h"
+#include "access/genam.h"
+#include "access/stratnum.h"
+#include "access/tupmacs.h"
+#include "catalog/pg_amop.h"
+#include "catalog/pg_type.h"
+#include "utils/builtins.h"
+#include "utils/date.h"
+#include "utils/datum.h"
+#include "utils/float.h"
+#include "utils/lsyscache.h"
+#include "utils/numeric.h"
+#include "utils/rel.h"
+#include "utils/syscache.h"
+#include "utils/timestamp.h"
+
+/*
+ * Additional SQL level support functions
+ *
+ * Procedure numbers must not use values reserved for BRIN itself; see
+ * brin_internal.h.
+ */
+#define		PROCNUM_DISTANCE		11	/* required, distance between values */
+
+/*
+ * Maximum number of intervals tracked for each page range.
+ */
+#define		MINMAX_MAX_RANGES		16
+
+typedef struct MinmaxMultiOpaque
+{
+	Oid			cached_subtype;
+	FmgrInfo	strategy_procinfos[BTMaxStrategyNumber];
+} MinmaxMultiOpaque;
+
+/*
+ * In-memory representation of the summary: nranges non-overlapping
+ * intervals, sorted by their boundaries.  values[2*i] and values[2*i+1] are
+ * the minimum and maximum of the i-th interval.
+ */
+typedef struct Ranges
+{
+	int			nranges;
+	Datum		values[FLEXIBLE_ARRAY_MEMBER];
+} Ranges;
+
+#define SizeOfRanges(nranges) \
+	(offsetof(Ranges, values) + sizeof(Datum) * 2 * (nranges))
+
+/*
+ * On-disk representation of the summary.  The boundary values are stored
+ * one after another without any alignment, so they have to be copied out
+ * before they can be used.
+ */
+typedef struct SerializedRanges
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	Oid			typid;			/* type of the stored values */
+	int32		nranges;		/* number of intervals */
+	char		data[FLEXIBLE_ARRAY_MEMBER];	/* 2 * nranges values */
+} SerializedRanges;
+
+static FmgrInfo *minmax_multi_get_strategy_procinfo(BrinDesc *bdesc,
+													uint16 attno,
+													Oid subtype,
+													uint16 strategynum);
+static SerializedRanges *range_serialize(Ranges *ranges,
+										 Form_pg_attribute attr);
+static Ranges *range_deserialize(SerializedRanges *serialized,
+								 Form_pg_attribute attr);
+static void range_reduce(BrinDesc *bdesc, AttrNumber attno, Oid colloid,
+						 Ranges *ranges);
+
+
+Datum
+brin_minmax_multi_opcinfo(PG_FUNCTION_ARGS)
+{
+	BrinOpcInfo *result;
+
+	/*
+	 * opaque->strategy_procinfos is initialized lazily; here it is set to
+	 * all-uninitialized by palloc0 which sets fn_oid to InvalidOid.
+	 *
+	 * The summary is stored as a bytea, regardless of the indexed type.
+	 */
+	result = palloc0(MAXALIGN(SizeofBrinOpcInfo(1)) +
+					 sizeof(MinmaxMultiOpaque));
+	result->oi_nstored = 1;
+	result->oi_opaque = (MinmaxMultiOpaque *)
+		MAXALIGN((char *) result + SizeofBrinOpcInfo(1));
+	result->oi_typcache[0] = lookup_type_cache(BYTEAOID, 0);
+
+	PG_RETURN_POINTER(result);
+}
+
+/*
+ * Examine the given index tuple (which contains partial status of a certain
+ * page range) by comparing it to the given value that comes from another heap
+ * tuple.  If the new value is outside all the intervals specified by the
+ * existing tuple values, add it as a new interval (merging the two closest
+ * intervals if there are too many), update the index tuple and return true.
+ * Otherwise, return false and do not modify in this case.
+ */
+Datum
+brin_minmax_multi_add_value(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	Datum		origval = PG_GETARG_DATUM(2);
+	bool		isnull = PG_GETARG_DATUM(3);
+	Oid			colloid = PG_GET_COLLATION();
+	FmgrInfo   *cmpFn;
+	Form_pg_attribute attr;
+	AttrNumber	attno;
+	Datum		newval;
+	SerializedRanges *serialized;
+	Ranges	   *ranges;
+	bool		updated = false;
+	int			lo,
+				hi;
+
+	/*
+	 * If the new value is null, we record that we saw it if it's the first
+	 * one; otherwise, there's nothing to do.
+	 */
+	if (isnull)
+	{
+		if (column->bv_hasnulls)
+			PG_RETURN_BOOL(false);
+
+		column->bv_hasnulls = true;
+		PG_RETURN_BOOL(true);
+	}
+
+	attno = column->bv_attno;
+	attr = TupleDescAttr(bdesc->bd_tupdesc, attno - 1);
+
+	/*
+	 * Work with a detoasted value, as it gets copied into the summary.  This
+	 * is called once per heap tuple during index builds, without a
+	 * per-tuple memory context, so everything allocated here is freed
+	 * before returning.
+	 */
+	newval = origval;
+	if (attr->attlen == -1)
+		newval = PointerGetDatum(PG_DETOAST_DATUM_PACKED(origval));
+
+	/*
+	 * If the recorded value is null, store the new value (which we know to be
+	 * not null) as a single-value interval, and we're done.
+	 */
+	if (column->bv_allnulls)
+	{
+		ranges = palloc(SizeOfRanges(1));
+		ranges->nranges = 1;
+		ranges->values[0] = ranges->values[1] = newval;
+
+		column->bv_values[0] = PointerGetDatum(range_serialize(ranges, attr));
+		column->bv_allnulls = false;
+		pfree(ranges);
+		if (newval != origval)
+			pfree(DatumGetPointer(newval));
+
+		PG_RETURN_BOOL(true);
+	}
+
+	serialized = (SerializedRanges *) PG_DETOAST_DATUM(column->bv_values[0]);
+	ranges = range_deserialize(serialized, attr);
+
+	/*
+	 * Find the first interval whose maximum is not less than the new value.
+	 * If the value is not less than that interval's minimum, it falls into
+	 * the interval, and there's nothing to do.
+	 */
+	cmpFn = minmax_multi_get_strategy_procinfo(bdesc, attno, attr->atttypid,
+											   BTLessStrategyNumber);
+	lo = 0;
+	hi = ranges->nranges;
+	while (lo < hi)
+	{
+		int			mid = (lo + hi) / 2;
+
+		if (DatumGetBool(FunctionCall2Coll(cmpFn, colloid,
+										   ranges->values[2 * mid + 1],
+										   newval)))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo >= ranges->nranges ||
+		DatumGetBool(FunctionCall2Coll(cmpFn, colloid,
+									   newval, ranges->values[2 * lo])))
+	{
+		/*
+		 * Insert the value as a new single-value interval at the right
+		 * position, then merge intervals if we now have too many.
+		 * range_deserialize left room for one more interval; we mustn't
+		 * repalloc, as by-reference values point into the same chunk.
+		 */
+		memmove(&ranges->values[2 * (lo + 1)], &ranges->values[2 * lo],
+				sizeof(Datum) * 2 * (ranges->nranges - lo));
+		ranges->values[2 * lo] = ranges->values[2 * lo + 1] = newval;
+		ranges->nranges++;
+
+		range_reduce(bdesc, attno, colloid, ranges);
+
+		if ((Pointer) serialized != DatumGetPointer(column->bv_values[0]))
+			pfree(serialized);
+		serialized = NULL;
+		pfree(DatumGetPointer(column->bv_values[0]));
+		column->bv_values[0] = PointerGetDatum(range_serialize(ranges, attr));
+		updated = true;
+	}
+
+	if (serialized &&
+		(Pointer) serialized != DatumGetPointer(column->bv_values[0]))
+		pfree(serialized);
+	pfree(ranges);
+	if (newval != origval)
+		pfree(DatumGetPointer(newval));
+
+	PG_RETURN_BOOL(updated);
+}
+
+/*
+ * Given an index tuple corresponding to a certain page range and a scan key,
+ * return whether the scan key is consistent with any of the intervals stored
+ * in the index tuple.  Return true if so, false otherwise.
+ */
+Datum
+brin_minmax_multi_consistent(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	ScanKey		key = (ScanKey) PG_GETARG_POINTER(2);
+	Oid			colloid = PG_GET_COLLATION(),
+				subtype;
+	AttrNumber	attno;
+	Form_pg_attribute attr;
+	Datum		value;
+	Datum		matches;
+	FmgrInfo   *finfo;
+	SerializedRanges *serialized;
+	Ranges	   *ranges;
+	int			i;
+
+	Assert(key->sk_attno == column->bv_attno);
+
+	/* handle IS NULL/IS NOT NULL tests */
+	if (key->sk_flags & SK_ISNULL)
+	{
+		if (key->sk_flags & SK_SEARCHNULL)
+		{
+			if (column->bv_allnulls || column->bv_hasnulls)
+				PG_RETURN_BOOL(true);
+			PG_RETURN_BOOL(false);
+		}
+
+		/*
+		 * For IS NOT NULL, we can only skip ranges that are known to have
+		 * only nulls.
+		 */
+		if (key->sk_flags & SK_SEARCHNOTNULL)
+			PG_RETURN_BOOL(!column->bv_allnulls);
+
+		/*
+		 * Neither IS NULL nor IS NOT NULL was used; assume all indexable
+		 * operators are strict and return false.
+		 */
+		PG_RETURN_BOOL(false);
+	}
+
+	/* if the range is all empty, it cannot possibly be consistent */
+	if (column->bv_allnulls)
+		PG_RETURN_BOOL(false);
+
+	attno = key->sk_attno;
+	attr = TupleDescAttr(bdesc->bd_tupdesc, attno - 1);
+	subtype = key->sk_subtype;
+	value = key->sk_argument;
+
+	serialized = (SerializedRanges *) PG_DETOAST_DATUM(column->bv_values[0]);
+	ranges = range_deserialize(serialized, attr);
+
+	switch (key->sk_strategy)
+	{
+		case BTLessStrategyNumber:
+		case BTLessEqualStrategyNumber:
+			/* the minimum of the first interval is the overall minimum */
+			finfo = minmax_multi_get_strategy_procinfo(bdesc, attno, subtype,
+													   key->sk_strategy);
+			matches = FunctionCall2Coll(finfo, colloid, ranges->values[0],
+										value);
+			break;
+		case BTEqualStrategyNumber:
+
+			/*
+			 * In the equality case (WHERE col = someval), we want to return
+			 * the current page range if any of the intervals has minimum <=
+			 * scan key and maximum >= scan key.
+			 */
+			matches = BoolGetDatum(false);
+			for (i = 0; i < ranges->nranges; i++)
+			{
+				finfo = minmax_multi_get_strategy_procinfo(bdesc, attno, subtype,
+														   BTLessEqualStrategyNumber);
+				matches = FunctionCall2Coll(finfo, colloid,
+											ranges->values[2 * i], value);
+
+				/* intervals are sorted, so no later one can match either */
+				if (!DatumGetBool(matches))
+					break;
+
+				/* max() >= scankey */
+				finfo = minmax_multi_get_strategy_procinfo(bdesc, attno, subtype,
+														   BTGreaterEqualStrategyNumber);
+				matches = FunctionCall2Coll(finfo, colloid,
+											ranges->values[2 * i + 1], value);
+				if (DatumGetBool(matches))
+					break;
+			}
+			break;
+		case BTGreaterEqualStrategyNumber:
+		case BTGreaterStrategyNumber:
+			/* the maximum of the last interval is the overall maximum */
+			finfo = minmax_multi_get_strategy_procinfo(bdesc, attno, subtype,
+													   key->sk_strategy);
+			matches = FunctionCall2Coll(finfo, colloid,
+										ranges->values[2 * ranges->nranges - 1],
+										value);
+			break;
+		default:
+			/* shouldn't happen */
+			elog(ERROR, "invalid strategy number %d", key->sk_strategy);
+			matches = 0;
+			break;
+	}
+
+	/* called for every page range of a scan, so don't leak */
+	if ((Pointer) serialized != DatumGetPointer(column->bv_values[0]))
+		pfree(serialized);
+	pfree(ranges);
+
+	PG_RETURN_DATUM(matches);
+}
+
+/*
+ * Given two BrinValues, update the first of them as a union of the summary
+ * values contained in both.  The second one is untouched.
+ */
+Datum
+brin_minmax_multi_union(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *col_a = (BrinValues *) PG_GETARG_POINTER(1);
+	BrinValues *col_b = (BrinValues *) PG_GETARG_POINTER(2);
+	Oid			colloid = PG_GET_COLLATION();
+	AttrNumber	attno;
+	Form_pg_attribute attr;
+	FmgrInfo   *cmpFn;
+	SerializedRanges *serialized_a;
+	SerializedRanges *serialized_b;
+	Ranges	   *ranges_a;
+	Ranges	   *ranges_b;
+	Ranges	   *ranges;
+	int			ia,
+				ib,
+				n;
+
+	Assert(col_a->bv_attno == col_b->bv_attno);
+
+	/* Adjust "hasnulls" */
+	if (!col_a->bv_hasnulls && col_b->bv_hasnulls)
+		col_a->bv_hasnulls = true;
+
+	/* If there are no values in B, there's nothing left to do */
+	if (col_b->bv_allnulls)
+		PG_RETURN_VOID();
+
+	attno = col_a->bv_attno;
+	attr = TupleDescAttr(bdesc->bd_tupdesc, attno - 1);
+
+	/*
+	 * Adjust "allnulls".  If A doesn't have values, just copy the values from
+	 * B into A, and we're done.  We cannot run the operators in this case,
+	 * because values in A might contain garbage.  Note we already established
+	 * that B contains values.
+	 */
+	if (col_a->bv_allnulls)
+	{
+		col_a->bv_allnulls = false;
+		col_a->bv_values[0] = datumCopy(col_b->bv_values[0], false, -1);
+		PG_RETURN_VOID();
+	}
+
+	serialized_a = (SerializedRanges *) PG_DETOAST_DATUM(col_a->bv_values[0]);
+	serialized_b = (SerializedRanges *) PG_DETOAST_DATUM(col_b->bv_values[0]);
+	ranges_a = range_deserialize(serialized_a, attr);
+	ranges_b = range_deserialize(serialized_b, attr);
+
+	/*
+	 * Merge the two sorted lists of intervals, combining intervals that
+	 * overlap.
+	 */
+	cmpFn = minmax_multi_get_strategy_procinfo(bdesc, attno, attr->atttypid,
+											   BTLessStrategyNumber);
+
+	ranges = palloc(SizeOfRanges(ranges_a->nranges + ranges_b->nranges));
+	n = 0;
+	ia = ib = 0;
+	while (ia < ranges_a->nranges || ib < ranges_b->nranges)
+	{
+		Datum	   *next;
+
+		if (ib >= ranges_b->nranges ||
+			(ia < ranges_a->nranges &&
+			 !DatumGetBool(FunctionCall2Coll(cmpFn, colloid,
+											 ranges_b->values[2 * ib],
+											 ranges_a->values[2 * ia]))))
+			next = &ranges_a->values[2 * ia++];
+		else
+			next = &ranges_b->values[2 * ib++];
+
+		/* does it overlap with the last interval we added? */
+		if (n > 0 &&
+			!DatumGetBool(FunctionCall2Coll(cmpFn, colloid,
+											ranges->values[2 * n - 1],
+											next[0])))
+		{
+			if (DatumGetBool(FunctionCall2Coll(cmpFn, colloid,
+											   ranges->values[2 * n - 1],
+											   next[1])))
+				ranges->values[2 * n - 1] = next[1];
+			continue;
+		}
+
+		ranges->values[2 * n] = next[0];
+		ranges->values[2 * n + 1] = next[1];
+		n++;
+	}
+	ranges->nranges = n;
+
+	range_reduce(bdesc, attno, colloid, ranges);
+
+	if ((Pointer) serialized_a != DatumGetPointer(col_a->bv_values[0]))
+		pfree(serialized_a);
+	if ((Pointer) serialized_b != DatumGetPointer(col_b->bv_values[0]))
+		pfree(serialized_b);
+
+	pfree(DatumGetPointer(col_a->bv_values[0]));
+	col_a->bv_values[0] = PointerGetDatum(range_serialize(ranges, attr));
+
+	pfree(ranges);
+	pfree(ranges_a);
+	pfree(ranges_b);
+
+	PG_RETURN_VOID();
+}
+
+/*
+ * Merge adjacent intervals until there are no more than MINMAX_MAX_RANGES.
+ *
+ * We always merge the two intervals with the smallest gap between them, as
+ * determined by the opclass' distance function, so that the large gaps --
+ * which are what makes the summary useful -- are preserved.
+ */
+static void
+range_reduce(BrinDesc *bdesc, AttrNumber attno, Oid colloid, Ranges *ranges)
+{
+	FmgrInfo   *distanceFn;
+
+	if (ranges->nranges <= MINMAX_MAX_RANGES)
+		return;
+
+	distanceFn = index_getprocinfo(bdesc->bd_index, attno, PROCNUM_DISTANCE);
+
+	while (ranges->nranges > MINMAX_MAX_RANGES)
+	{
+		int			best = 0;
+		double		bestdist = 0;
+		int			i;
+
+		for (i = 0; i < ranges->nranges - 1; i++)
+		{
+			double		dist;
+
+			dist = DatumGetFloat8(FunctionCall2Coll(distanceFn, colloid,
+													ranges->values[2 * i + 1],
+													ranges->values[2 * i + 2]));
+			if (i == 0 || dist < bestdist)
+			{
+				best = i;
+				bestdist = dist;
+			}
+		}
+
+		/* merge interval best+1 into best, and close the hole */
+		ranges->values[2 * best + 1] = ranges->values[2 * best + 3];
+		memmove(&ranges->values[2 * best + 2], &ranges->values[2 * best + 4],
+				sizeof(Datum) * 2 * (ranges->nranges - best - 2));
+		ranges->nranges--;
+	}
+}
+
+/*
+ * Serialize the in-memory representation into a compact varlena value,
+ * suitable for storing in the index tuple.
+ */
+static SerializedRanges *
+range_serialize(Ranges *ranges, Form_pg_attribute attr)
+{
+	SerializedRanges *serialized;
+	Size		len;
+	char	   *ptr;
+	int			i;
+
+	/* compute the space needed */
+	len = offsetof(SerializedRanges, data);
+	for (i = 0; i < 2 * ranges->nranges; i++)
+	{
+		if (attr->attlen > 0)
+			len += attr->attlen;
+		else
+			len += VARSIZE_ANY(DatumGetPointer(ranges->values[i]));
+	}
+
+	serialized = (SerializedRanges *) palloc0(len);
+	SET_VARSIZE(serialized, len);
+	serialized->typid = attr->atttypid;
+	serialized->nranges = ranges->nranges;
+
+	ptr = serialized->data;
+	for (i = 0; i < 2 * ranges->nranges; i++)
+	{
+		if (attr->attbyval)
+		{
+			Datum		tmp;
+
+			/*
+			 * For byval types, we need to copy just the significant bytes.
+			 * store_att_byval requires an aligned destination, so store into
+			 * a local variable first.
+			 */
+			store_att_byval(&tmp, ranges->values[i], attr->attlen);
+			memcpy(ptr, &tmp, attr->attlen);
+			ptr += attr->attlen;
+		}
+		else if (attr->attlen > 0)
+		{
+			memcpy(ptr, DatumGetPointer(ranges->values[i]), attr->attlen);
+			ptr += attr->attlen;
+		}
+		else
+		{
+			int			tmp = VARSIZE_ANY(DatumGetPointer(ranges->values[i]));
+
+			memcpy(ptr, DatumGetPointer(ranges->values[i]), tmp);
+			ptr += tmp;
+		}
+	}
+
+	Assert(ptr == (char *) serialized + len);
+
+	return serialized;
+}
+
+/*
+ * Deserialize the summary into the in-memory representation.  Values of
+ * by-reference types are copied into properly aligned memory, which is
+ * allocated together with the Ranges struct.
+ */
+static Ranges *
+range_deserialize(SerializedRanges *serialized, Form_pg_attribute attr)
+{
+	Ranges	   *ranges;
+	char	   *ptr;
+	char	   *dataptr;
+	Size		datalen;
+	int			nvalues;
+	int			i;
+
+	Assert(serialized->typid == attr->atttypid);
+
+	nvalues = 2 * serialized->nranges;
+
+	/* compute how much space we need for the by-reference values */
+	datalen = 0;
+	if (!attr->attbyval)
+	{
+		ptr = serialized->data;
+		for (i = 0; i < nvalues; i++)
+		{
+			Size		len;
+
+			if (attr->attlen > 0)
+				len = attr->attlen;
+			else
+				len = VARSIZE_ANY(ptr);
+
+			datalen += MAXALIGN(len);
+			ptr += len;
+		}
+	}
+
+	/* room for one more interval, for the benefit of add_value */
+	ranges = palloc(MAXALIGN(SizeOfRanges(serialized->nranges + 1)) + datalen);
+	ranges->nranges = serialized->nranges;
+	dataptr = (char *) ranges + MAXALIGN(SizeOfRanges(serialized->nranges + 1));
+
+	ptr = serialized->data;
+	for (i = 0; i < nvalues; i++)
+	{
+		if (attr->attbyval)
+		{
+			Datum		v = 0;
+
+			memcpy(&v, ptr, attr->attlen);
+			ranges->values[i] = fetch_att(&v, true, attr->attlen);
+			ptr += attr->attlen;
+		}
+		else
+		{
+			Size		len;
+
+			if (attr->attlen > 0)
+				len = attr->attlen;
+			else
+				len = VARSIZE_ANY(ptr);
+
+			memcpy(dataptr, ptr, len);
+			ranges->values[i] = PointerGetDatum(dataptr);
+			dataptr += MAXALIGN(len);
+			ptr += len;
+		}
+	}
+
+	return ranges;
+}
+
+/*
+ * Cache and return the procedure for the given strategy.
+ *
+ * Note: this function mirrors minmax_get_strategy_procinfo; see notes
+ * there.  If changes are made here, see that function too.
+ */
+static FmgrInfo *
+minmax_multi_get_strategy_procinfo(BrinDesc *bdesc, uint16 attno, Oid subtype,
+								   uint16 strategynum)
+{
+	MinmaxMultiOpaque *opaque;
+
+	Assert(strategynum >= 1 &&
+		   strategynum <= BTMaxStrategyNumber);
+
+	opaque = (MinmaxMultiOpaque *) bdesc->bd_info[attno - 1]->oi_opaque;
+
+	/*
+	 * We cache the procedures for the previous subtype in the opaque struct,
+	 * to avoid repetitive syscache lookups.  If the subtype changed,
+	 * invalidate all the cached entries.
+	 */
+	if (opaque->cached_subtype != subtype)
+	{
+		uint16		i;
+
+		for (i = 1; i <= BTMaxStrategyNumber; i++)
+			opaque->strategy_procinfos[i - 1].fn_oid = InvalidOid;
+		opaque->cached_subtype = subtype;
+	}
+
+	if (opaque->strategy_procinfos[strategynum - 1].fn_oid == InvalidOid)
+	{
+		Form_pg_attribute attr;
+		HeapTuple	tuple;
+		Oid			opfamily,
+					oprid;
+		bool		isNull;
+
+		opfamily = bdesc->bd_index->rd_opfamily[attno - 1];
+		attr = TupleDescAttr(bdesc->bd_tupdesc, attno - 1);
+		tuple = SearchSysCache4(AMOPSTRATEGY, ObjectIdGetDatum(opfamily),
+								ObjectIdGetDatum(attr->atttypid),
+								ObjectIdGetDatum(subtype),
+								Int16GetDatum(strategynum));
+
+		if (!HeapTupleIsValid(tuple))
+			elog(ERROR, "missing operator %d(%u,%u) in opfamily %u",
+				 strategynum, attr->atttypid, subtype, opfamily);
+
+		oprid = DatumGetObjectId(SysCacheGetAttr(AMOPSTRATEGY, tuple,
+												 Anum_pg_amop_amopopr, &isNull));
+		ReleaseSysCache(tuple);
+		Assert(!isNull && RegProcedureIsValid(oprid));
+
+		fmgr_info_cxt(get_opcode(oprid),
+					  &opaque->strategy_procinfos[strategynum - 1],
+					  bdesc->bd_context);
+	}
+
+	return &opaque->strategy_procinfos[strategynum - 1];
+}
+
+/*
+ * Distance functions, used to decide which intervals to merge.  Each one
+ * returns how far apart the two given values (a <= b) are.
+ */
+Datum
+brin_minmax_multi_distance_int2(PG_FUNCTION_ARGS)
+{
+	int16		a = PG_GETARG_INT16(0);
+	int16		b = PG_GETARG_INT16(1);
+
+	/*
+	 * We know the values are range boundaries, but the range may be collapsed
+	 * (i.e. single points), with equal values.
+	 */
+	Assert(a <= b);
+
+	PG_RETURN_FLOAT8((double) b - (double) a);
+}
+
+Datum
+brin_minmax_multi_distance_int4(PG_FUNCTION_ARGS)
+{
+	int32		a = PG_GETARG_INT32(0);
+	int32		b = PG_GETARG_INT32(1);
+
+	Assert(a <= b);
+
+	PG_RETURN_FLOAT8((double) b - (double) a);
+}
+
+Datum
+brin_minmax_multi_distance_int8(PG_FUNCTION_ARGS)
+{
+	int64		a = PG_GETARG_INT64(0);
+	int64		b = PG_GETARG_INT64(1);
+
+	Assert(a <= b);
+
+	PG_RETURN_FLOAT8((double) b - (double) a);
+}
+
+Datum
+brin_minmax_multi_distance_float4(PG_FUNCTION_ARGS)
+{
+	float4		a = PG_GETARG_FLOAT4(0);
+	float4		b = PG_GETARG_FLOAT4(1);
+
+	/*
+	 * NaN sorts above all other values, so any gap involving it is treated
+	 * as infinitely large and never merged unless there's no other choice.
+	 */
+	if (isnan(a) || isnan(b))
+		PG_RETURN_FLOAT8(get_float8_infinity());
+
+	PG_RETURN_FLOAT8((double) b - (double) a);
+}
+
+Datum
+brin_minmax_multi_distance_float8(PG_FUNCTION_ARGS)
+{
+	float8		a = PG_GETARG_FLOAT8(0);
+	float8		b = PG_GETARG_FLOAT8(1);
+
+	/* see brin_minmax_multi_distance_float4 */
+	if (isnan(a) || isnan(b))
+		PG_RETURN_FLOAT8(get_float8_infinity());
+
+	PG_RETURN_FLOAT8(b - a);
+}
+
+Datum
+brin_minmax_multi_distance_numeric(PG_FUNCTION_ARGS)
+{
+	Datum		d;
+	Datum		a1 = PG_GETARG_DATUM(0);
+	Datum		a2 = PG_GETARG_DATUM(1);
+
+	/*
+	 * We know the values are range boundaries, but the range may be collapsed
+	 * (i.e. single points), with equal values.
+	 */
+	Assert(DatumGetBool(DirectFunctionCall2(numeric_le, a1, a2)));
+
+	d = DirectFunctionCall2(numeric_sub, a2, a1);	/* a2 - a1 */
+
+	PG_RETURN_DATUM(DirectFunctionCall1(numeric_float8, d));
+}
+
+Datum
+brin_minmax_multi_distance_date(PG_FUNCTION_ARGS)
+{
+	DateADT		dateVal1 = PG_GETARG_DATEADT(0);
+	DateADT		dateVal2 = PG_GETARG_DATEADT(1);
+
+	if (DATE_NOT_FINITE(dateVal1) || DATE_NOT_FINITE(dateVal2))
+		PG_RETURN_FLOAT8(get_float8_infinity());
+
+	PG_RETURN_FLOAT8((double) dateVal2 - (double) dateVal1);
+}
+
+/*
+ * Used for both timestamp and timestamptz, which have the same on-disk
+ * representation.
+ */
+Datum
+brin_minmax_multi_distance_timestamp(PG_FUNCTION_ARGS)
+{
+	Timestamp	dt1 = PG_GETARG_TIMESTAMP(0);
+	Timestamp	dt2 = PG_GETARG_TIMESTAMP(1);
+
+	if (TIMESTAMP_NOT_FINITE(dt1) || TIMESTAMP_NOT_FINITE(dt2))
+		PG_RETURN_FLOAT8(get_float8_infinity());
+
+	PG_RETURN_FLOAT8((double) dt2 - (double) dt1);
+}
@@ -131,6 +131,15 @@ static relopt_bool boolRelOpts[] =
 		},
 		true
 	},
+	{
+		{
+			"autocleanup",
+			"Enables cleanup of the pending list of this GIN index by autovacuum",
+			RELOPT_KIND_GIN,
+			AccessExclusiveLock
+		},
+		false
+	},
 	{
 		{
 			"security_barrier",
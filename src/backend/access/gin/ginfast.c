@@ -6,6 +6,8 @@
  *	  (typically during VACUUM), ginInsertCleanup() will be invoked to
  *	  transfer pending entries into the regular index structure.  This
  *	  wins because bulk insertion is much more efficient than retail.
+ *	  With the autocleanup option, an insertion that overflows the pending
+ *	  list asks autovacuum to do the cleanup instead of doing it itself.
  *
  * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -226,7 +228,9 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 	ginxlogUpdateMeta data;
 	bool		separateList = false;
 	bool		needCleanup = false;
+	bool		needLocalCleanup = false;
 	int			cleanupSize;
+	int64		pendingSize;
 	bool		needWal;
 
 	if (collector->ntuples == 0)
@@ -444,21 +448,45 @@ ginHeapTupleFastInsert(GinState *ginstate, GinTupleCollector *collector)
 	 * gin_pending_list_limit.
 	 *
 	 * ginInsertCleanup() should not be called inside our CRIT_SECTION.
+	 *
+	 * If autocleanup is enabled, the cleanup is normally left to autovacuum
+	 * so that this insertion doesn't pay for it.  We still do it ourselves
+	 * once the list has grown to twice the limit, which means autovacuum is
+	 * not keeping up.
 	 */
 	cleanupSize = GinGetPendingListCleanupSize(index);
-	if (metadata->nPendingPages * GIN_PAGE_FREESIZE > cleanupSize * 1024L)
+	pendingSize = (int64) metadata->nPendingPages * GIN_PAGE_FREESIZE;
+	if (pendingSize > (int64) cleanupSize * 1024)
 		needCleanup = true;
+	if (pendingSize > (int64) cleanupSize * 2048)
+		needLocalCleanup = true;
 
 	UnlockReleaseBuffer(metabuffer);
 
 	END_CRIT_SECTION();
 
+	if (!needCleanup)
+		return;
+
+	/*
+	 * Try to hand the cleanup over to autovacuum.  Temporary indexes can't
+	 * be processed by autovacuum, and if the request can't be recorded we
+	 * have to do the work here after all.
+	 */
+	if (!needLocalCleanup &&
+		GinGetUseAutoCleanup(index) &&
+		AutoVacuumingActive() &&
+		!RelationUsesLocalBuffers(index) &&
+		AutoVacuumRequestWork(AVW_GINCleanPendingList,
+							  RelationGetRelid(index),
+							  InvalidBlockNumber))
+		return;
+
 	/*
 	 * Since it could contend with concurrent cleanup process we cleanup
 	 * pending list not forcibly.
 	 */
-	if (needCleanup)
-		ginInsertCleanup(ginstate, false, true, false, NULL);
+	ginInsertCleanup(ginstate, false, true, false, NULL);
 }
 
 /*
@@ -16,16 +16,127 @@
 
 #include "access/gin_private.h"
 #include "access/ginxlog.h"
+#include "access/parallel.h"
+#include "access/table.h"
 #include "access/tableam.h"
+#include "access/xact.h"
 #include "access/xloginsert.h"
 #include "catalog/index.h"
 #include "miscadmin.h"
+#include "optimizer/optimizer.h"
+#include "pgstat.h"
 #include "storage/bufmgr.h"
+#include "storage/condition_variable.h"
 #include "storage/indexfsm.h"
 #include "storage/predicate.h"
 #include "storage/smgr.h"
+#include "storage/spin.h"
+#include "tcop/tcopprot.h"		/* pgrminclude ignore */
+#include "utils/datum.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/tuplesort.h"
+
+/* Magic numbers for parallel state sharing */
+#define PARALLEL_KEY_GIN_SHARED			UINT64CONST(0xB000000000000001)
+#define PARALLEL_KEY_TUPLESORT			UINT64CONST(0xB000000000000002)
+#define PARALLEL_KEY_QUERY_TEXT			UINT64CONST(0xB000000000000003)
+
+/*
+ * Status for index builds performed in parallel.  This is allocated in a
+ * dynamic shared memory segment.  Note that there is a separate tuplesort TOC
+ * entry, private to tuplesort.c but allocated by this module on its behalf.
+ */
+typedef struct GinShared
+{
+	/*
+	 * These fields are not modified during the build.  They primarily exist
+	 * for the benefit of worker processes that need to create state
+	 * corresponding to that used by the leader.
+	 */
+	Oid			heaprelid;
+	Oid			indexrelid;
+	bool		isconcurrent;
+	int			scantuplesortstates;
+
+	/*
+	 * workersdonecv is used to monitor the progress of workers.  All parallel
+	 * participants must indicate that they are done before leader can use
+	 * results built by the workers (and before leader can proceed to
+	 * tuplesort_performsort()).
+	 */
+	ConditionVariable workersdonecv;
+
+	/*
+	 * mutex protects all fields before heapdesc.
+	 *
+	 * These fields contain status information of interest to GIN index
+	 * builds that must work just the same when an index is built in parallel.
+	 */
+	slock_t		mutex;
+
+	/*
+	 * Mutable state that is maintained by workers, and reported back to
+	 * leader at end of the scans.
+	 *
+	 * nparticipantsdone is number of worker processes finished.
+	 *
+	 * reltuples is the total number of input heap tuples.
+	 *
+	 * indtuples is the total number of entries extracted from them.
+	 *
+	 * brokenhotchain indicates if any worker detected a broken HOT chain
+	 * during build.
+	 */
+	int			nparticipantsdone;
+	double		reltuples;
+	double		indtuples;
+	bool		brokenhotchain;
+
+	/*
+	 * ParallelTableScanDescData data follows. Can't directly embed here, as
+	 * implementations of the parallel table scan desc interface might need
+	 * stronger alignment.
+	 */
+} GinShared;
+
+/*
+ * Return pointer to a GinShared's parallel table scan.
+ *
+ * c.f. shm_toc_allocate as to why BUFFERALIGN is used, rather than just
+ * MAXALIGN.
+ */
+#define ParallelTableScanFromGinShared(shared) \
+	(ParallelTableScanDesc) ((char *) (shared) + BUFFERALIGN(sizeof(GinShared)))
+
+/*
+ * Status for leader in parallel index build.
+ */
+typedef struct GinLeader
+{
+	/* parallel context itself */
+	ParallelContext *pcxt;
+
+	/*
+	 * nparticipanttuplesorts is the exact number of worker processes
+	 * successfully launched, plus one leader process if it participates as a
+	 * worker.
+	 */
+	int			nparticipanttuplesorts;
+
+	/*
+	 * Leader process convenience pointers to shared state (leader avoids TOC
+	 * lookups).
+	 *
+	 * ginshared is the shared state for entire build.  sharedsort is the
+	 * shared, tuplesort-managed state passed to each process tuplesort.
+	 * snapshot is the snapshot used by the scan iff an MVCC snapshot is
+	 * required.
+	 */
+	GinShared  *ginshared;
+	Sharedsort *sharedsort;
+	Snapshot	snapshot;
+} GinLeader;
 
 typedef struct
 {
@@ -35,8 +146,35 @@ typedef struct
 	MemoryContext tmpCtx;
 	MemoryContext funcCtx;
 	BuildAccumulator accum;
+	int			accumMem;		/* memory limit for accum, in KB */
+
+	/*
+	 * In a parallel build, participants pass the accumulated entries to the
+	 * leader through this tuplesort instead of inserting them, and the leader
+	 * keeps its own leader tuplesort here.  NULL in a serial build.
+	 */
+	Tuplesortstate *sortstate;
+	GinLeader  *ginleader;
 } GinBuildState;
 
+static void _gin_begin_parallel(GinBuildState *buildstate, Relation heap,
+								Relation index, bool isconcurrent,
+								int request);
+static void _gin_end_parallel(GinLeader *ginleader);
+static Size _gin_parallel_estimate_shared(Relation heap, Snapshot snapshot);
+static double _gin_parallel_heapscan(GinBuildState *buildstate,
+									 bool *brokenhotchain);
+static void _gin_parallel_merge(GinBuildState *buildstate, Relation heap);
+static void _gin_leader_participate_as_worker(GinBuildState *buildstate,
+											  Relation heap, Relation index);
+static void _gin_parallel_scan_and_sort(Relation heap, Relation index,
+										GinShared *ginshared,
+										Sharedsort *sharedsort,
+										int sortmem, bool progress);
+static void ginSpoolBuildEntry(GinBuildState *buildstate, OffsetNumber attnum,
+							   Datum key, GinNullCategory category,
+							   ItemPointerData *items, uint32 nitems);
+
 
 /*
  * Adds array of item pointers to tuple's posting list, or
@@ -288,8 +426,11 @@ ginBuildCallback(Relation index, ItemPointer tid, Datum *values,
 		ginHeapTupleBulkInsert(buildstate, (OffsetNumber) (i + 1),
 							   values[i], isnull[i], tid);
 
-	/* If we've maxed out our available memory, dump everything to the index */
-	if (buildstate->accum.allocatedMemory >= (Size) maintenance_work_mem * 1024L)
+	/*
+	 * If we've maxed out our available memory, dump everything to the index,
+	 * or to the tuplesort in a parallel build.
+	 */
+	if (buildstate->accum.allocatedMemory >= (Size) buildstate->accumMem * 1024L)
 	{
 		ItemPointerData *list;
 		Datum		key;
@@ -303,8 +444,12 @@ ginBuildCallback(Relation index, ItemPointer tid, Datum *values,
 		{
 			/* there could be many entries, so be willing to abort here */
 			CHECK_FOR_INTERRUPTS();
-			ginEntryInsert(&buildstate->ginstate, attnum, key, category,
-						   list, nlist, &buildstate->buildStats);
+			if (buildstate->sortstate)
+				ginSpoolBuildEntry(buildstate, attnum, key, category,
+								   list, nlist);
+			else
+				ginEntryInsert(&buildstate->ginstate, attnum, key, category,
+							   list, nlist, &buildstate->buildStats);
 		}
 
 		MemoryContextReset(buildstate->tmpCtx);
@@ -336,6 +481,9 @@ ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	initGinState(&buildstate.ginstate, index);
 	buildstate.indtuples = 0;
 	memset(&buildstate.buildStats, 0, sizeof(GinStatsData));
+	buildstate.accumMem = maintenance_work_mem;
+	buildstate.sortstate = NULL;
+	buildstate.ginleader = NULL;
 
 	/* initialize the meta page */
 	MetaBuffer = GinNewBuffer(index);
@@ -376,26 +524,46 @@ ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	buildstate.accum.ginstate = &buildstate.ginstate;
 	ginInitBA(&buildstate.accum);
 
-	/*
-	 * Do the heap scan.  We disallow sync scan here because dataPlaceToPage
-	 * prefers to receive tuples in TID order.
-	 */
-	reltuples = table_index_build_scan(heap, index, indexInfo, false, true,
-									   ginBuildCallback, (void *) &buildstate,
-									   NULL);
+	/* Attempt to launch parallel worker scan when required */
+	if (indexInfo->ii_ParallelWorkers > 0)
+		_gin_begin_parallel(&buildstate, heap, index,
+							indexInfo->ii_Concurrent,
+							indexInfo->ii_ParallelWorkers);
 
-	/* dump remaining entries to the index */
-	oldCtx = MemoryContextSwitchTo(buildstate.tmpCtx);
-	ginBeginBAScan(&buildstate.accum);
-	while ((list = ginGetBAEntry(&buildstate.accum,
-								 &attnum, &key, &category, &nlist)) != NULL)
+	if (!buildstate.ginleader)
 	{
-		/* there could be many entries, so be willing to abort here */
-		CHECK_FOR_INTERRUPTS();
-		ginEntryInsert(&buildstate.ginstate, attnum, key, category,
-					   list, nlist, &buildstate.buildStats);
+		/*
+		 * Do the heap scan.  We disallow sync scan here because
+		 * dataPlaceToPage prefers to receive tuples in TID order.
+		 */
+		reltuples = table_index_build_scan(heap, index, indexInfo, false, true,
+										   ginBuildCallback,
+										   (void *) &buildstate, NULL);
+
+		/* dump remaining entries to the index */
+		oldCtx = MemoryContextSwitchTo(buildstate.tmpCtx);
+		ginBeginBAScan(&buildstate.accum);
+		while ((list = ginGetBAEntry(&buildstate.accum,
+									 &attnum, &key, &category, &nlist)) != NULL)
+		{
+			/* there could be many entries, so be willing to abort here */
+			CHECK_FOR_INTERRUPTS();
+			ginEntryInsert(&buildstate.ginstate, attnum, key, category,
+						   list, nlist, &buildstate.buildStats);
+		}
+		MemoryContextSwitchTo(oldCtx);
+	}
+	else
+	{
+		/*
+		 * Wait for all participants to finish their share of the scan, then
+		 * merge their sorted runs and insert the result into the index.
+		 */
+		reltuples = _gin_parallel_heapscan(&buildstate,
+										   &indexInfo->ii_BrokenHotChain);
+		_gin_parallel_merge(&buildstate, heap);
+		_gin_end_parallel(buildstate.ginleader);
 	}
-	MemoryContextSwitchTo(oldCtx);
 
 	MemoryContextDelete(buildstate.funcCtx);
 	MemoryContextDelete(buildstate.tmpCtx);
@@ -536,3 +704,631 @@ gininsert(Relation index, Datum *values, bool *isnull,
 
 	return false;
 }
+
+/*
+ * Fetch the key of a GinBuildTuple.  For pass-by-reference types the result
+ * points into the tuple.
+ */
+static Datum
+ginBuildTupleGetKey(GinState *ginstate, GinBuildTuple *tup)
+{
+	Form_pg_attribute attr;
+	Datum		key;
+
+	if (tup->category != GIN_CAT_NORM_KEY)
+		return (Datum) 0;
+
+	attr = TupleDescAttr(ginstate->origTupdesc, tup->attrnum - 1);
+	if (attr->attbyval)
+	{
+		memcpy(&key, GinBuildTupleGetKeyData(tup), sizeof(Datum));
+		return key;
+	}
+	return PointerGetDatum(GinBuildTupleGetKeyData(tup));
+}
+
+/*
+ * Comparator for GinBuildTuples, used by the tuplesort in parallel builds.
+ *
+ * Tuples are ordered like the entries in the index, and tuples with the same
+ * key by their first heap TID, so that the TID lists of one key arrive at the
+ * leader in roughly ascending order.
+ */
+int
+ginCompareBuildTuples(GinState *ginstate, GinBuildTuple *a, GinBuildTuple *b)
+{
+	int			res;
+
+	res = ginCompareAttEntries(ginstate,
+							   a->attrnum, ginBuildTupleGetKey(ginstate, a),
+							   a->category,
+							   b->attrnum, ginBuildTupleGetKey(ginstate, b),
+							   b->category);
+	if (res != 0)
+		return res;
+
+	if (a->nitems > 0 && b->nitems > 0)
+		return ginCompareItemPointers(GinBuildTupleGetItems(a),
+									  GinBuildTupleGetItems(b));
+	return 0;
+}
+
+/*
+ * Pass one accumulated entry to the leader, through the tuplesort.
+ */
+static void
+ginSpoolBuildEntry(GinBuildState *buildstate, OffsetNumber attnum,
+				   Datum key, GinNullCategory category,
+				   ItemPointerData *items, uint32 nitems)
+{
+	Form_pg_attribute attr;
+	GinBuildTuple *tup;
+	Size		keylen = 0;
+	Size		tuplen;
+
+	attr = TupleDescAttr(buildstate->ginstate.origTupdesc, attnum - 1);
+	if (category == GIN_CAT_NORM_KEY)
+		keylen = attr->attbyval ? sizeof(Datum) :
+			datumGetSize(key, false, attr->attlen);
+
+	tuplen = SHORTALIGN(GinBuildTupleKeyOffset + keylen) +
+		nitems * sizeof(ItemPointerData);
+
+	/* zero the padding, since the tuple may be written out as is */
+	tup = (GinBuildTuple *) palloc0(tuplen);
+	tup->tuplen = tuplen;
+	tup->attrnum = attnum;
+	tup->category = category;
+	tup->keylen = keylen;
+	tup->nitems = nitems;
+	if (category == GIN_CAT_NORM_KEY)
+	{
+		if (attr->attbyval)
+			memcpy(GinBuildTupleGetKeyData(tup), &key, sizeof(Datum));
+		else
+			memcpy(GinBuildTupleGetKeyData(tup), DatumGetPointer(key), keylen);
+	}
+	memcpy(GinBuildTupleGetItems(tup), items,
+		   nitems * sizeof(ItemPointerData));
+
+	tuplesort_putgintuple(buildstate->sortstate, tup);
+	pfree(tup);
+}
+
+/*
+ * qsort comparator for heap TIDs
+ */
+static int
+qsortCompareItemPointers(const void *a, const void *b)
+{
+	return ginCompareItemPointers((ItemPointer) a, (ItemPointer) b);
+}
+
+/*
+ * Create parallel context, and launch workers for leader.
+ *
+ * buildstate argument should be initialized (the leader tuplesort is
+ * created later, by _gin_parallel_merge()).
+ *
+ * isconcurrent indicates if operation is CREATE INDEX CONCURRENTLY.
+ *
+ * request is the target number of parallel worker processes to launch.
+ *
+ * Sets buildstate's GinLeader, which caller must use to shut down parallel
+ * mode by passing it to _gin_end_parallel() at the very end of its index
+ * build.  If not even a single worker process can be launched, this is
+ * never set, and caller should proceed with a serial index build.
+ */
+static void
+_gin_begin_parallel(GinBuildState *buildstate, Relation heap, Relation index,
+					bool isconcurrent, int request)
+{
+	ParallelContext *pcxt;
+	int			scantuplesortstates;
+	Snapshot	snapshot;
+	Size		estginshared;
+	Size		estsort;
+	GinShared  *ginshared;
+	Sharedsort *sharedsort;
+	GinLeader  *ginleader = (GinLeader *) palloc0(sizeof(GinLeader));
+	bool		leaderparticipates = parallel_leader_participation;
+	char	   *sharedquery;
+	int			querylen;
+
+#ifdef DISABLE_LEADER_PARTICIPATION
+	leaderparticipates = false;
+#endif
+
+	/*
+	 * Enter parallel mode, and create context for parallel build of gin
+	 * index
+	 */
+	EnterParallelMode();
+	Assert(request > 0);
+	pcxt = CreateParallelContext("postgres", "_gin_parallel_build_main",
+								 request);
+	scantuplesortstates = leaderparticipates ? request + 1 : request;
+
+	/*
+	 * Prepare for scan of the base relation.  In a normal index build, we use
+	 * SnapshotAny because we must retrieve all tuples and do our own time
+	 * qual checks (because we have to index RECENTLY_DEAD tuples).  In a
+	 * concurrent build, we take a regular MVCC snapshot and index whatever's
+	 * live according to that.
+	 */
+	if (!isconcurrent)
+		snapshot = SnapshotAny;
+	else
+		snapshot = RegisterSnapshot(GetTransactionSnapshot());
+
+	/*
+	 * Estimate size for our own PARALLEL_KEY_GIN_SHARED workspace, and
+	 * PARALLEL_KEY_TUPLESORT tuplesort workspace
+	 */
+	estginshared = _gin_parallel_estimate_shared(heap, snapshot);
+	shm_toc_estimate_chunk(&pcxt->estimator, estginshared);
+	estsort = tuplesort_estimate_shared(scantuplesortstates);
+	shm_toc_estimate_chunk(&pcxt->estimator, estsort);
+	shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+	/* Finally, estimate PARALLEL_KEY_QUERY_TEXT space */
+	querylen = strlen(debug_query_string);
+	shm_toc_estimate_chunk(&pcxt->estimator, querylen + 1);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+
+	/* Everyone's had a chance to ask for space, so now create the DSM */
+	InitializeParallelDSM(pcxt);
+
+	/* Store shared build state, for which we reserved space */
+	ginshared = (GinShared *) shm_toc_allocate(pcxt->toc, estginshared);
+	/* Initialize immutable state */
+	ginshared->heaprelid = RelationGetRelid(heap);
+	ginshared->indexrelid = RelationGetRelid(index);
+	ginshared->isconcurrent = isconcurrent;
+	ginshared->scantuplesortstates = scantuplesortstates;
+	ConditionVariableInit(&ginshared->workersdonecv);
+	SpinLockInit(&ginshared->mutex);
+	/* Initialize mutable state */
+	ginshared->nparticipantsdone = 0;
+	ginshared->reltuples = 0.0;
+	ginshared->indtuples = 0.0;
+	ginshared->brokenhotchain = false;
+	table_parallelscan_initialize(heap,
+								  ParallelTableScanFromGinShared(ginshared),
+								  snapshot);
+
+	/*
+	 * Store shared tuplesort-private state, for which we reserved space.
+	 * Then, initialize opaque state using tuplesort routine.
+	 */
+	sharedsort = (Sharedsort *) shm_toc_allocate(pcxt->toc, estsort);
+	tuplesort_initialize_shared(sharedsort, scantuplesortstates,
+								pcxt->seg);
+
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_GIN_SHARED, ginshared);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLESORT, sharedsort);
+
+	/* Store query string for workers */
+	sharedquery = (char *) shm_toc_allocate(pcxt->toc, querylen + 1);
+	memcpy(sharedquery, debug_query_string, querylen + 1);
+	shm_toc_insert(pcxt->toc, PARALLEL_KEY_QUERY_TEXT, sharedquery);
+
+	/* Launch workers, saving status for leader/caller */
+	LaunchParallelWorkers(pcxt);
+	ginleader->pcxt = pcxt;
+	ginleader->nparticipanttuplesorts = pcxt->nworkers_launched;
+	if (leaderparticipates)
+		ginleader->nparticipanttuplesorts++;
+	ginleader->ginshared = ginshared;
+	ginleader->sharedsort = sharedsort;
+	ginleader->snapshot = snapshot;
+
+	/* If no workers were successfully launched, back out (do serial build) */
+	if (pcxt->nworkers_launched == 0)
+	{
+		_gin_end_parallel(ginleader);
+		return;
+	}
+
+	/* Save leader state now that it's clear build will be parallel */
+	buildstate->ginleader = ginleader;
+
+	/* Join heap scan ourselves */
+	if (leaderparticipates)
+		_gin_leader_participate_as_worker(buildstate, heap, index);
+
+	/*
+	 * Caller needs to wait for all launched workers when we return.  Make
+	 * sure that the failure-to-start case will not hang forever.
+	 */
+	WaitForParallelWorkersToAttach(pcxt);
+}
+
+/*
+ * Shut down workers, destroy parallel context, and end parallel mode.
+ */
+static void
+_gin_end_parallel(GinLeader *ginleader)
+{
+	/* Shutdown worker processes */
+	WaitForParallelWorkersToFinish(ginleader->pcxt);
+	/* Free last reference to MVCC snapshot, if one was used */
+	if (IsMVCCSnapshot(ginleader->snapshot))
+		UnregisterSnapshot(ginleader->snapshot);
+	DestroyParallelContext(ginleader->pcxt);
+	ExitParallelMode();
+}
+
+/*
+ * Returns size of shared memory required to store state for a parallel
+ * gin index build based on the snapshot its parallel scan will use.
+ */
+static Size
+_gin_parallel_estimate_shared(Relation heap, Snapshot snapshot)
+{
+	/* c.f. shm_toc_allocate as to why BUFFERALIGN is used */
+	return add_size(BUFFERALIGN(sizeof(GinShared)),
+					table_parallelscan_estimate(heap, snapshot));
+}
+
+/*
+ * Within leader, wait for end of heap scan.
+ *
+ * When called, parallel heap scan started by _gin_begin_parallel() will
+ * already be underway within worker processes (the leader participates as a
+ * worker, so we should end up here just as workers are finishing).
+ *
+ * Fills in fields needed for ambuild statistics, and lets caller set
+ * field indicating that some worker encountered a broken HOT chain.
+ *
+ * Returns the total number of heap tuples scanned.
+ */
+static double
+_gin_parallel_heapscan(GinBuildState *buildstate, bool *brokenhotchain)
+{
+	GinShared  *ginshared = buildstate->ginleader->ginshared;
+	int			nparticipanttuplesorts;
+	double		reltuples;
+
+	nparticipanttuplesorts = buildstate->ginleader->nparticipanttuplesorts;
+	for (;;)
+	{
+		SpinLockAcquire(&ginshared->mutex);
+		if (ginshared->nparticipantsdone == nparticipanttuplesorts)
+		{
+			buildstate->indtuples = ginshared->indtuples;
+			*brokenhotchain = ginshared->brokenhotchain;
+			reltuples = ginshared->reltuples;
+			SpinLockRelease(&ginshared->mutex);
+			break;
+		}
+		SpinLockRelease(&ginshared->mutex);
+
+		ConditionVariableSleep(&ginshared->workersdonecv,
+							   WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN);
+	}
+
+	ConditionVariableCancelSleep();
+
+	return reltuples;
+}
+
+/*
+ * Within leader, merge the sorted runs produced by all participants and
+ * insert the entries into the index.
+ *
+ * Runs from different participants contain TIDs of the same key, so
+ * consecutive tuples with equal keys are combined into one TID list before
+ * inserting it, just like the accumulator does in a serial build.  The list
+ * buffer gets half of maintenance_work_mem and the merge the other half; the
+ * list is flushed early once it fills its share, as ginEntryInsert() copes
+ * with adding more TIDs to an existing entry.
+ */
+static void
+_gin_parallel_merge(GinBuildState *buildstate, Relation heap)
+{
+	GinState   *ginstate = &buildstate->ginstate;
+	GinLeader  *ginleader = buildstate->ginleader;
+	SortCoordinate coordinate;
+	GinBuildTuple *tup;
+	MemoryContext oldCtx;
+	OffsetNumber attnum = InvalidOffsetNumber;
+	Datum		key = (Datum) 0;
+	GinNullCategory category = GIN_CAT_NORM_KEY;
+	ItemPointerData *items;
+	uint32		nitems = 0;
+	uint32		maxitems;
+	uint32		maxbuffered;
+	int			sortmem;
+	bool		sorted = true;
+
+	coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = false;
+	coordinate->nParticipants = ginleader->nparticipanttuplesorts;
+	coordinate->sharedsort = ginleader->sharedsort;
+
+	/*
+	 * The leader tuplesort only allocates a small, fixed amount of memory
+	 * until tuplesort_performsort(), and by then all workers have freed
+	 * theirs.  See _bt_spools_heapscan() for discussion.  The TID buffer
+	 * below is charged against the same budget, so the merge only gets what
+	 * the buffer leaves over.
+	 */
+	sortmem = Max(maintenance_work_mem / 2, 64);
+	buildstate->sortstate =
+		tuplesort_begin_index_gin(heap, ginstate->index,
+								  sortmem, coordinate, false);
+	tuplesort_performsort(buildstate->sortstate);
+
+	maxbuffered = Min(MaxAllocSize,
+					  (Size) Max(maintenance_work_mem - sortmem, 64) * 1024L) /
+		sizeof(ItemPointerData);
+	maxitems = Min(1024, maxbuffered);
+	items = (ItemPointerData *) palloc(maxitems * sizeof(ItemPointerData));
+
+	oldCtx = MemoryContextSwitchTo(buildstate->tmpCtx);
+
+	for (;;)
+	{
+		Datum		tupkey = (Datum) 0;
+
+		tup = tuplesort_getgintuple(buildstate->sortstate, true);
+		if (tup)
+			tupkey = ginBuildTupleGetKey(ginstate, tup);
+
+		/* Insert the collected TIDs at end of a key, or if we have too many */
+		if (nitems > 0 &&
+			(tup == NULL ||
+			 ginCompareAttEntries(ginstate, attnum, key, category,
+								  tup->attrnum, tupkey, tup->category) != 0 ||
+			 nitems + tup->nitems > maxbuffered))
+		{
+			if (!sorted)
+			{
+				uint32		i,
+							j;
+
+				qsort(items, nitems, sizeof(ItemPointerData),
+					  qsortCompareItemPointers);
+				/* remove duplicates, for safety */
+				for (i = 1, j = 1; i < nitems; i++)
+				{
+					if (!ItemPointerEquals(&items[i], &items[j - 1]))
+						items[j++] = items[i];
+				}
+				nitems = j;
+			}
+
+			/* there could be many entries, so be willing to abort here */
+			CHECK_FOR_INTERRUPTS();
+			ginEntryInsert(ginstate, attnum, key, category,
+						   items, nitems, &buildstate->buildStats);
+
+			nitems = 0;
+			sorted = true;
+			MemoryContextReset(buildstate->tmpCtx);
+		}
+
+		if (tup == NULL)
+			break;
+
+		/* Starting a new key?  Remember it. */
+		if (nitems == 0)
+		{
+			Form_pg_attribute attr;
+
+			attnum = tup->attrnum;
+			category = tup->category;
+			attr = TupleDescAttr(ginstate->origTupdesc, attnum - 1);
+			key = (category == GIN_CAT_NORM_KEY) ?
+				datumCopy(tupkey, attr->attbyval, attr->attlen) : (Datum) 0;
+		}
+
+		if (nitems + tup->nitems > maxitems)
+		{
+			while (nitems + tup->nitems > maxitems)
+				maxitems *= 2;
+			/* don't let doubling overshoot the buffer's share */
+			maxitems = Max(Min(maxitems, maxbuffered), nitems + tup->nitems);
+			items = (ItemPointerData *)
+				repalloc_huge(items, (Size) maxitems * sizeof(ItemPointerData));
+		}
+
+		if (nitems > 0 && tup->nitems > 0 &&
+			ginCompareItemPointers(&items[nitems - 1],
+								   GinBuildTupleGetItems(tup)) >= 0)
+			sorted = false;
+
+		memcpy(&items[nitems], GinBuildTupleGetItems(tup),
+			   tup->nitems * sizeof(ItemPointerData));
+		nitems += tup->nitems;
+	}
+
+	MemoryContextSwitchTo(oldCtx);
+
+	pfree(items);
+	tuplesort_end(buildstate->sortstate);
+	buildstate->sortstate = NULL;
+}
+
+/*
+ * Within leader, participate as a parallel worker.
+ */
+static void
+_gin_leader_participate_as_worker(GinBuildState *buildstate, Relation heap,
+								  Relation index)
+{
+	GinLeader  *ginleader = buildstate->ginleader;
+	int			sortmem;
+
+	/*
+	 * Might as well use reliable figure when doling out maintenance_work_mem
+	 * (when requested number of workers were not launched, this will be
+	 * somewhat higher than it is for other workers).
+	 */
+	sortmem = maintenance_work_mem / ginleader->nparticipanttuplesorts;
+
+	/* Perform work common to all participants */
+	_gin_parallel_scan_and_sort(heap, index,
+								ginleader->ginshared, ginleader->sharedsort,
+								sortmem, true);
+}
+
+/*
+ * Perform work within a launched parallel process.
+ */
+void
+_gin_parallel_build_main(dsm_segment *seg, shm_toc *toc)
+{
+	char	   *sharedquery;
+	GinShared  *ginshared;
+	Sharedsort *sharedsort;
+	Relation	heapRel;
+	Relation	indexRel;
+	LOCKMODE	heapLockmode;
+	LOCKMODE	indexLockmode;
+	int			sortmem;
+
+	/* Set debug_query_string for individual workers first */
+	sharedquery = shm_toc_lookup(toc, PARALLEL_KEY_QUERY_TEXT, false);
+	debug_query_string = sharedquery;
+
+	/* Report the query string from leader */
+	pgstat_report_activity(STATE_RUNNING, debug_query_string);
+
+	/* Look up gin shared state */
+	ginshared = shm_toc_lookup(toc, PARALLEL_KEY_GIN_SHARED, false);
+
+	/* Open relations using lock modes known to be obtained by index.c */
+	if (!ginshared->isconcurrent)
+	{
+		heapLockmode = ShareLock;
+		indexLockmode = AccessExclusiveLock;
+	}
+	else
+	{
+		heapLockmode = ShareUpdateExclusiveLock;
+		indexLockmode = RowExclusiveLock;
+	}
+
+	/* Open relations within worker */
+	heapRel = table_open(ginshared->heaprelid, heapLockmode);
+	indexRel = index_open(ginshared->indexrelid, indexLockmode);
+
+	/* Look up shared state private to tuplesort.c */
+	sharedsort = shm_toc_lookup(toc, PARALLEL_KEY_TUPLESORT, false);
+	tuplesort_attach_shared(sharedsort, seg);
+
+	/*
+	 * Perform scanning and sorting.  Workers start before the leader knows
+	 * how many of them were launched, so divide maintenance_work_mem among
+	 * the participants that were planned, counting the leader only when it
+	 * takes part in the scan.
+	 */
+	sortmem = maintenance_work_mem / ginshared->scantuplesortstates;
+	_gin_parallel_scan_and_sort(heapRel, indexRel, ginshared,
+								sharedsort, sortmem, false);
+
+	index_close(indexRel, indexLockmode);
+	table_close(heapRel, heapLockmode);
+}
+
+/*
+ * Perform a worker's portion of a parallel build.
+ *
+ * The worker scans its share of the heap, accumulating entries in memory
+ * like a serial build does, but passes them to a "partial" tuplesort
+ * instead of inserting them into the index.  sortmem is the amount of
+ * working memory to use within each worker, expressed in KBs; it is split
+ * evenly between the accumulator and the tuplesort.
+ *
+ * When this returns, workers are done, and need only release resources.
+ */
+static void
+_gin_parallel_scan_and_sort(Relation heap, Relation index,
+							GinShared *ginshared, Sharedsort *sharedsort,
+							int sortmem, bool progress)
+{
+	SortCoordinate coordinate;
+	GinBuildState buildstate;
+	TableScanDesc scan;
+	double		reltuples;
+	IndexInfo  *indexInfo;
+	ItemPointerData *list;
+	Datum		key;
+	GinNullCategory category;
+	uint32		nlist;
+	OffsetNumber attnum;
+	MemoryContext oldCtx;
+
+	/* Initialize local tuplesort coordination state */
+	coordinate = palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = true;
+	coordinate->nParticipants = -1;
+	coordinate->sharedsort = sharedsort;
+
+	/* Fill in buildstate for ginBuildCallback() */
+	initGinState(&buildstate.ginstate, index);
+	buildstate.indtuples = 0;
+	memset(&buildstate.buildStats, 0, sizeof(GinStatsData));
+	buildstate.accumMem = Max(sortmem / 2, 64);
+	buildstate.ginleader = NULL;
+
+	buildstate.tmpCtx = AllocSetContextCreate(CurrentMemoryContext,
+											  "Gin build temporary context",
+											  ALLOCSET_DEFAULT_SIZES);
+	buildstate.funcCtx = AllocSetContextCreate(CurrentMemoryContext,
+											   "Gin build temporary context for user-defined function",
+											   ALLOCSET_DEFAULT_SIZES);
+	buildstate.accum.ginstate = &buildstate.ginstate;
+	ginInitBA(&buildstate.accum);
+
+	/* Begin "partial" tuplesort */
+	buildstate.sortstate = tuplesort_begin_index_gin(heap, index,
+													 Max(sortmem / 2, 64),
+													 coordinate, false);
+
+	/* Join parallel scan */
+	indexInfo = BuildIndexInfo(index);
+	indexInfo->ii_Concurrent = ginshared->isconcurrent;
+	scan = table_beginscan_parallel(heap,
+									ParallelTableScanFromGinShared(ginshared));
+	reltuples = table_index_build_scan(heap, index, indexInfo, true, progress,
+									   ginBuildCallback,
+									   (void *) &buildstate, scan);
+
+	/* pass the remaining entries to the leader */
+	oldCtx = MemoryContextSwitchTo(buildstate.tmpCtx);
+	ginBeginBAScan(&buildstate.accum);
+	while ((list = ginGetBAEntry(&buildstate.accum,
+								 &attnum, &key, &category, &nlist)) != NULL)
+	{
+		CHECK_FOR_INTERRUPTS();
+		ginSpoolBuildEntry(&buildstate, attnum, key, category, list, nlist);
+	}
+	MemoryContextSwitchTo(oldCtx);
+
+	/* Execute this worker's part of the sort */
+	tuplesort_performsort(buildstate.sortstate);
+
+	/*
+	 * Done.  Record ambuild statistics, and whether we encountered a broken
+	 * HOT chain.
+	 */
+	SpinLockAcquire(&ginshared->mutex);
+	ginshared->nparticipantsdone++;
+	ginshared->reltuples += reltuples;
+	ginshared->indtuples += buildstate.indtuples;
+	if (indexInfo->ii_BrokenHotChain)
+		ginshared->brokenhotchain = true;
+	SpinLockRelease(&ginshared->mutex);
+
+	/* Notify leader */
+	ConditionVariableSignal(&ginshared->workersdonecv);
+
+	/* We can end tuplesort immediately */
+	tuplesort_end(buildstate.sortstate);
+
+	MemoryContextDelete(buildstate.funcCtx);
+	MemoryContextDelete(buildstate.tmpCtx);
+}
@@ -1681,7 +1681,7 @@ gistprunepage(Relation rel, Page page, Buffer buffer, Relation heapRel)
 
 			recptr = gistXLogDelete(buffer,
 									deletable, ndeletable,
-									latestRemovedXid);
+									latestRemovedXid, heapRel);
 
 			PageSetLSN(page, recptr);
 		}
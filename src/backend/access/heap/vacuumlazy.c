@@ -4,23 +4,31 @@
  *	  Concurrent ("lazy") vacuuming.
  *
  *
- * The major space usage for LAZY VACUUM is storage for the array of dead tuple
- * TIDs.  We want to ensure we can vacuum even the very largest relations with
+ * The major space usage for LAZY VACUUM is storage for the dead tuple TIDs.
+ * We want to ensure we can vacuum even the very largest relations with
  * finite memory space usage.  To do that, we set upper bounds on the number of
  * tuples we will keep track of at once.
  *
+ * The TIDs are stored grouped by heap block: each block with dead tuples has
+ * an LVDeadBlock entry, and a short run of 16-bit items holding either the
+ * offset numbers of its dead tuples, or a bitmap of them, whichever is
+ * smaller.  That takes much less space than an array of ItemPointerData when
+ * pages have more than a couple of dead tuples, and lets index vacuuming test
+ * a TID with a binary search over blocks followed by a bit test.
+ *
  * We are willing to use at most maintenance_work_mem (or perhaps
- * autovacuum_work_mem) memory space to keep track of dead tuples.  We
- * initially allocate an array of TIDs of that size, with an upper limit that
- * depends on table size (this limit ensures we don't allocate a huge area
- * uselessly for vacuuming small tables).  If the array threatens to overflow,
- * we suspend the heap scan phase and perform a pass of index cleanup and page
- * compaction, then resume the heap scan with an empty TID array.
+ * autovacuum_work_mem) memory space to keep track of dead tuples, with an
+ * upper limit that depends on table size (this limit ensures we don't
+ * allocate a huge area uselessly for vacuuming small tables).  The arrays are
+ * grown as needed within that limit, using huge allocations so that the
+ * limit can exceed 1GB.  If the space threatens to overflow, we suspend the
+ * heap scan phase and perform a pass of index cleanup and page compaction,
+ * then resume the heap scan with empty TID storage.
  *
  * If we're processing a table with no indexes, we can just vacuum each page
  * as we go; there's no need to save up multiple tuples to minimize the number
  * of index scans performed.  So we don't use maintenance_work_mem memory for
- * the TID array, just enough to hold as many heap tuples as fit on one page.
+ * the TID storage, just enough to hold the dead tuples of one page.
  *
  *
  * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
@@ -92,11 +100,36 @@
 	((BlockNumber) (((uint64) 8 * 1024 * 1024 * 1024) / BLCKSZ))
 
 /*
- * Guesstimation of number of dead tuples per page.  This is used to
- * provide an upper limit to memory allocated when vacuuming small
- * tables.
+ * Dead tuple TIDs of one heap block (see comments at the head of this file).
+ * The block's items in dead_items run from its start up to the next block's
+ * start, or to num_dead_items for the last block.  If DEAD_BLOCK_IS_BITMAP is
+ * set in start, the items are a bitmap indexed by offset number; otherwise
+ * they are the offset numbers, in ascending order.
  */
-#define LAZY_ALLOC_TUPLES		MaxHeapTuplesPerPage
+typedef struct LVDeadBlock
+{
+	BlockNumber blkno;			/* heap block number */
+	uint32		start;			/* index of first item, plus flag bit */
+} LVDeadBlock;
+
+#define DEAD_BLOCK_IS_BITMAP	0x80000000
+#define DEAD_BLOCK_START_MASK	0x7FFFFFFF
+
+/* Number of bitmap items needed to cover offset numbers up to 'off' */
+#define DEAD_BITMAP_ITEMS(off)	((off) / 16 + 1)
+
+/* Most items a single block can use */
+#define DEAD_ITEMS_PER_PAGE		DEAD_BITMAP_ITEMS(MaxHeapTuplesPerPage)
+
+/* Most space a single block can use */
+#define DEAD_SPACE_PER_PAGE \
+	(sizeof(LVDeadBlock) + DEAD_ITEMS_PER_PAGE * sizeof(uint16))
+
+/*
+ * Number of blocks to allocate dead tuple storage for initially; it's
+ * enlarged as needed.
+ */
+#define LAZY_INITIAL_DEAD_BLOCKS	1024
 
 /*
  * Before we consider skipping a page that's marked as clean in
@@ -128,11 +161,17 @@ typedef struct LVRelStats
 	BlockNumber pages_removed;
 	double		tuples_deleted;
 	BlockNumber nonempty_pages; /* actually, last nonempty page + 1 */
-	/* List of TIDs of tuples we intend to delete */
-	/* NB: this list is ordered by TID address */
-	int			num_dead_tuples;	/* current # of entries */
-	int			max_dead_tuples;	/* # slots allocated in array */
-	ItemPointer dead_tuples;	/* array of ItemPointerData */
+	/* TIDs of tuples we intend to delete, grouped by block */
+	/* NB: blocks are in ascending order */
+	int64		num_dead_tuples;	/* current # of TIDs */
+	int64		max_dead_tuples;	/* rough capacity, for progress reports */
+	LVDeadBlock *dead_blocks;	/* array of per-block entries */
+	int			num_dead_blocks;	/* current # of entries */
+	int			max_dead_blocks;	/* # slots allocated in array */
+	uint16	   *dead_items;		/* offsets or bitmaps, for all blocks */
+	uint32		num_dead_items; /* current # of entries */
+	uint32		max_dead_items; /* # slots allocated in array */
+	Size		dead_space_limit;	/* max bytes for the above two arrays */
 	int			num_index_scans;
 	TransactionId latestRemovedXid;
 	bool		lock_waiter_detected;
@@ -165,17 +204,20 @@ static void lazy_cleanup_index(Relation indrel,
 							   IndexBulkDeleteResult *stats,
 							   LVRelStats *vacrelstats);
 static int	lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-							 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer);
+							 int blkindex, LVRelStats *vacrelstats, Buffer *vmbuffer);
 static bool should_attempt_truncation(VacuumParams *params,
 									  LVRelStats *vacrelstats);
 static void lazy_truncate_heap(Relation onerel, LVRelStats *vacrelstats);
 static BlockNumber count_nondeletable_pages(Relation onerel,
 											LVRelStats *vacrelstats);
 static void lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks);
+static bool lazy_space_reserve(LVRelStats *vacrelstats);
+static void lazy_forget_dead_tuples(LVRelStats *vacrelstats);
 static void lazy_record_dead_tuple(LVRelStats *vacrelstats,
 								   ItemPointer itemptr);
+static int	lazy_dead_block_offsets(LVRelStats *vacrelstats, int blkindex,
+									OffsetNumber *offsets);
 static bool lazy_tid_reaped(ItemPointer itemptr, void *state);
-static int	vac_cmp_itemptr(const void *left, const void *right);
 static bool heap_page_is_all_visible(Relation rel, Buffer buf,
 									 TransactionId *visibility_cutoff_xid, bool *all_frozen);
 
@@ -476,7 +518,7 @@ vacuum_log_cleanup_info(Relation rel, LVRelStats *vacrelstats)
 	 * No need to write the record at all unless it contains a valid value
 	 */
 	if (TransactionIdIsValid(vacrelstats->latestRemovedXid))
-		(void) log_heap_cleanup_info(rel->rd_node, vacrelstats->latestRemovedXid);
+		(void) log_heap_cleanup_info(rel, vacrelstats->latestRemovedXid);
 }
 
 /*
@@ -646,7 +688,7 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 					maxoff;
 		bool		tupgone,
 					hastup;
-		int			prev_dead_count;
+		int64		prev_dead_count;
 		int			nfrozen;
 		Size		freespace;
 		bool		all_visible_according_to_vm = false;
@@ -740,8 +782,8 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 		 * If we are close to overrunning the available space for dead-tuple
 		 * TIDs, pause and do a cycle of vacuuming before we tackle this page.
 		 */
-		if ((vacrelstats->max_dead_tuples - vacrelstats->num_dead_tuples) < MaxHeapTuplesPerPage &&
-			vacrelstats->num_dead_tuples > 0)
+		if (vacrelstats->num_dead_tuples > 0 &&
+			!lazy_space_reserve(vacrelstats))
 		{
 			/*
 			 * Before beginning index vacuuming, we release any pin we may
@@ -767,7 +809,7 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
-			vacrelstats->num_dead_tuples = 0;
+			lazy_forget_dead_tuples(vacrelstats);
 
 			/*
 			 * Vacuum the Free Space Map to make newly-freed space visible on
@@ -1233,7 +1275,7 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 				 * Instead of vacuuming the dead tuples on the heap, we just
 				 * forget them.
 				 *
-				 * Note that vacrelstats->dead_tuples could have tuples which
+				 * Note that vacrelstats->dead_blocks could have tuples which
 				 * became dead after HOT-pruning but are not marked dead yet.
 				 * We do not process them because it's a very rare condition,
 				 * and the next vacuum will process them anyway.
@@ -1246,7 +1288,7 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
-			vacrelstats->num_dead_tuples = 0;
+			lazy_forget_dead_tuples(vacrelstats);
 
 			/*
 			 * Periodically do incremental FSM vacuuming to make newly-freed
@@ -1509,7 +1551,8 @@ lazy_vacuum_all_indexes(Relation onerel, LVRelStats *vacrelstats,
 static void
 lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 {
-	int			tupindex;
+	int			blkindex;
+	double		ntuples;
 	int			npages;
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
@@ -1519,10 +1562,10 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 								 PROGRESS_VACUUM_PHASE_VACUUM_HEAP);
 
 	pg_rusage_init(&ru0);
+	ntuples = 0;
 	npages = 0;
 
-	tupindex = 0;
-	while (tupindex < vacrelstats->num_dead_tuples)
+	for (blkindex = 0; blkindex < vacrelstats->num_dead_blocks; blkindex++)
 	{
 		BlockNumber tblk;
 		Buffer		buf;
@@ -1531,16 +1574,15 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 
 		vacuum_delay_point();
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
+		tblk = vacrelstats->dead_blocks[blkindex].blkno;
 		buf = ReadBufferExtended(onerel, MAIN_FORKNUM, tblk, RBM_NORMAL,
 								 vac_strategy);
 		if (!ConditionalLockBufferForCleanup(buf))
 		{
 			ReleaseBuffer(buf);
-			++tupindex;
 			continue;
 		}
-		tupindex = lazy_vacuum_page(onerel, tblk, buf, tupindex, vacrelstats,
+		ntuples += lazy_vacuum_page(onerel, tblk, buf, blkindex, vacrelstats,
 									&vmbuffer);
 
 		/* Now that we've compacted the page, record its available space */
@@ -1559,9 +1601,9 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 	}
 
 	ereport(elevel,
-			(errmsg("\"%s\": removed %d row versions in %d pages",
+			(errmsg("\"%s\": removed %.0f row versions in %d pages",
 					RelationGetRelationName(onerel),
-					tupindex, npages),
+					ntuples, npages),
 			 errdetail_internal("%s", pg_rusage_show(&ru0))));
 }
 
@@ -1571,37 +1613,33 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
  *
  * Caller must hold pin and buffer cleanup lock on the buffer.
  *
- * tupindex is the index in vacrelstats->dead_tuples of the first dead
- * tuple for this page.  We assume the rest follow sequentially.
- * The return value is the first tupindex after the tuples of this page.
+ * blkindex is the index in vacrelstats->dead_blocks of the entry for this
+ * page.  The return value is the number of tuples removed.
  */
 static int
 lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-				 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer)
+				 int blkindex, LVRelStats *vacrelstats, Buffer *vmbuffer)
 {
 	Page		page = BufferGetPage(buffer);
 	OffsetNumber unused[MaxOffsetNumber];
-	int			uncnt = 0;
+	int			uncnt;
+	int			i;
 	TransactionId visibility_cutoff_xid;
 	bool		all_frozen;
 
+	Assert(vacrelstats->dead_blocks[blkindex].blkno == blkno);
+
 	pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_VACUUMED, blkno);
 
+	uncnt = lazy_dead_block_offsets(vacrelstats, blkindex, unused);
+
 	START_CRIT_SECTION();
 
-	for (; tupindex < vacrelstats->num_dead_tuples; tupindex++)
+	for (i = 0; i < uncnt; i++)
 	{
-		BlockNumber tblk;
-		OffsetNumber toff;
-		ItemId		itemid;
+		ItemId		itemid = PageGetItemId(page, unused[i]);
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
-		if (tblk != blkno)
-			break;				/* past end of tuples for this block */
-		toff = ItemPointerGetOffsetNumber(&vacrelstats->dead_tuples[tupindex]);
-		itemid = PageGetItemId(page, toff);
 		ItemIdSetUnused(itemid);
-		unused[uncnt++] = toff;
 	}
 
 	PageRepairFragmentation(page);
@@ -1663,7 +1701,7 @@ lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
 							  *vmbuffer, visibility_cutoff_xid, flags);
 	}
 
-	return tupindex;
+	return uncnt;
 }
 
 /*
@@ -1724,7 +1762,7 @@ lazy_check_needs_freeze(Buffer buf, bool *hastup)
  *	lazy_vacuum_index() -- vacuum one index relation.
  *
  *		Delete all the index entries pointing to tuples listed in
- *		vacrelstats->dead_tuples, and update running statistics.
+ *		vacrelstats->dead_blocks, and update running statistics.
  */
 static void
 lazy_vacuum_index(Relation indrel,
@@ -1750,9 +1788,9 @@ lazy_vacuum_index(Relation indrel,
 							   lazy_tid_reaped, (void *) vacrelstats);
 
 	ereport(elevel,
-			(errmsg("scanned index \"%s\" to remove %d row versions",
+			(errmsg("scanned index \"%s\" to remove %.0f row versions",
 					RelationGetRelationName(indrel),
-					vacrelstats->num_dead_tuples),
+					(double) vacrelstats->num_dead_tuples),
 			 errdetail_internal("%s", pg_rusage_show(&ru0))));
 }
 
@@ -2129,106 +2167,313 @@ count_nondeletable_pages(Relation onerel, LVRelStats *vacrelstats)
 static void
 lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks)
 {
-	long		maxtuples;
+	Size		limit;
+	int			nblocks;
 	int			vac_work_mem = IsAutoVacuumWorkerProcess() &&
 	autovacuum_work_mem != -1 ?
 	autovacuum_work_mem : maintenance_work_mem;
 
 	if (vacrelstats->useindex)
 	{
-		maxtuples = (vac_work_mem * 1024L) / sizeof(ItemPointerData);
-		maxtuples = Min(maxtuples, INT_MAX);
-		maxtuples = Min(maxtuples, MaxAllocSize / sizeof(ItemPointerData));
+		limit = (Size) vac_work_mem * 1024;
 
-		/* curious coding here to ensure the multiplication can't overflow */
-		if ((BlockNumber) (maxtuples / LAZY_ALLOC_TUPLES) > relblocks)
-			maxtuples = relblocks * LAZY_ALLOC_TUPLES;
+		/* don't allow more than every block of the table could need */
+		if (limit / DEAD_SPACE_PER_PAGE > relblocks)
+			limit = relblocks * DEAD_SPACE_PER_PAGE;
 
 		/* stay sane if small maintenance_work_mem */
-		maxtuples = Max(maxtuples, MaxHeapTuplesPerPage);
+		limit = Max(limit, DEAD_SPACE_PER_PAGE);
 	}
 	else
 	{
-		maxtuples = MaxHeapTuplesPerPage;
+		limit = DEAD_SPACE_PER_PAGE;
+	}
+
+	vacrelstats->dead_space_limit = limit;
+
+	/*
+	 * Report how many TIDs fit if every page has only one; when pages have
+	 * more, more will fit.
+	 */
+	vacrelstats->max_dead_tuples = limit / (sizeof(LVDeadBlock) + sizeof(uint16));
+
+	nblocks = Min(LAZY_INITIAL_DEAD_BLOCKS, limit / DEAD_SPACE_PER_PAGE);
+
+	vacrelstats->num_dead_tuples = 0;
+	vacrelstats->num_dead_blocks = 0;
+	vacrelstats->max_dead_blocks = nblocks;
+	vacrelstats->dead_blocks = (LVDeadBlock *)
+		palloc(nblocks * sizeof(LVDeadBlock));
+	vacrelstats->num_dead_items = 0;
+	vacrelstats->max_dead_items = nblocks * DEAD_ITEMS_PER_PAGE;
+	vacrelstats->dead_items = (uint16 *)
+		palloc(nblocks * DEAD_ITEMS_PER_PAGE * sizeof(uint16));
+}
+
+/*
+ * lazy_space_reserve - make sure the dead tuples of one more page will fit
+ *
+ * The arrays are enlarged if necessary, as long as the total stays within
+ * dead_space_limit.  Returns false if there isn't enough room.
+ */
+static bool
+lazy_space_reserve(LVRelStats *vacrelstats)
+{
+	Size		blocks_space = vacrelstats->max_dead_blocks * sizeof(LVDeadBlock);
+	Size		items_space = vacrelstats->max_dead_items * sizeof(uint16);
+
+	if (vacrelstats->num_dead_blocks >= vacrelstats->max_dead_blocks)
+	{
+		Size		newmax;
+
+		if (items_space >= vacrelstats->dead_space_limit)
+			return false;
+		newmax = Min((Size) vacrelstats->max_dead_blocks * 2,
+					 (vacrelstats->dead_space_limit - items_space) /
+					 sizeof(LVDeadBlock));
+		newmax = Min(newmax, INT_MAX);
+		if (newmax <= vacrelstats->num_dead_blocks)
+			return false;
+
+		vacrelstats->max_dead_blocks = (int) newmax;
+		vacrelstats->dead_blocks = (LVDeadBlock *)
+			repalloc_huge(vacrelstats->dead_blocks,
+						  newmax * sizeof(LVDeadBlock));
+		blocks_space = newmax * sizeof(LVDeadBlock);
 	}
 
+	if (vacrelstats->num_dead_items + DEAD_ITEMS_PER_PAGE >
+		vacrelstats->max_dead_items)
+	{
+		Size		newmax;
+
+		if (blocks_space >= vacrelstats->dead_space_limit)
+			return false;
+		newmax = Min((Size) vacrelstats->max_dead_items * 2,
+					 (vacrelstats->dead_space_limit - blocks_space) /
+					 sizeof(uint16));
+		newmax = Min(newmax, DEAD_BLOCK_START_MASK);
+		if (newmax < vacrelstats->num_dead_items + DEAD_ITEMS_PER_PAGE)
+			return false;
+
+		vacrelstats->max_dead_items = (uint32) newmax;
+		vacrelstats->dead_items = (uint16 *)
+			repalloc_huge(vacrelstats->dead_items,
+						  newmax * sizeof(uint16));
+	}
+
+	return true;
+}
+
+/*
+ * lazy_forget_dead_tuples - empty the dead tuple storage
+ *
+ * The arrays are kept for reuse.
+ */
+static void
+lazy_forget_dead_tuples(LVRelStats *vacrelstats)
+{
 	vacrelstats->num_dead_tuples = 0;
-	vacrelstats->max_dead_tuples = (int) maxtuples;
-	vacrelstats->dead_tuples = (ItemPointer)
-		palloc(maxtuples * sizeof(ItemPointerData));
+	vacrelstats->num_dead_blocks = 0;
+	vacrelstats->num_dead_items = 0;
 }
 
 /*
  * lazy_record_dead_tuple - remember one deletable tuple
+ *
+ * Tuples must be recorded in TID order.  A block's offsets are stored as a
+ * list until that would take more space than a bitmap covering them, and
+ * then converted to a bitmap.
  */
 static void
 lazy_record_dead_tuple(LVRelStats *vacrelstats,
 					   ItemPointer itemptr)
 {
-	/*
-	 * The array shouldn't overflow under normal behavior, but perhaps it
-	 * could if we are given a really small maintenance_work_mem. In that
-	 * case, just forget the last few tuples (we'll get 'em next time).
-	 */
-	if (vacrelstats->num_dead_tuples < vacrelstats->max_dead_tuples)
+	BlockNumber blkno = ItemPointerGetBlockNumber(itemptr);
+	OffsetNumber offnum = ItemPointerGetOffsetNumber(itemptr);
+	uint16	   *items = vacrelstats->dead_items;
+	LVDeadBlock *blk;
+	uint32		start;
+	uint32		nitems;
+
+	Assert(offnum >= FirstOffsetNumber && offnum <= MaxHeapTuplesPerPage);
+
+	if (vacrelstats->num_dead_blocks == 0 ||
+		vacrelstats->dead_blocks[vacrelstats->num_dead_blocks - 1].blkno != blkno)
+	{
+		/*
+		 * Starting a new block.  lazy_scan_heap makes sure there's room
+		 * before each page, but perhaps there isn't if we are given a really
+		 * small maintenance_work_mem.  In that case, just forget this page's
+		 * tuples (we'll get 'em next time).
+		 */
+		if (!lazy_space_reserve(vacrelstats))
+			return;
+		items = vacrelstats->dead_items;
+
+		Assert(vacrelstats->num_dead_blocks == 0 ||
+			   vacrelstats->dead_blocks[vacrelstats->num_dead_blocks - 1].blkno < blkno);
+
+		blk = &vacrelstats->dead_blocks[vacrelstats->num_dead_blocks++];
+		blk->blkno = blkno;
+		blk->start = vacrelstats->num_dead_items;
+	}
+
+	blk = &vacrelstats->dead_blocks[vacrelstats->num_dead_blocks - 1];
+	start = blk->start & DEAD_BLOCK_START_MASK;
+	nitems = vacrelstats->num_dead_items - start;
+
+	if (blk->start & DEAD_BLOCK_IS_BITMAP)
 	{
-		vacrelstats->dead_tuples[vacrelstats->num_dead_tuples] = *itemptr;
-		vacrelstats->num_dead_tuples++;
-		pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
-									 vacrelstats->num_dead_tuples);
+		/* extend the bitmap if needed, then set the bit */
+		while (nitems < DEAD_BITMAP_ITEMS(offnum))
+			items[start + nitems++] = 0;
+		items[start + offnum / 16] |= (uint16) (1 << (offnum % 16));
+		vacrelstats->num_dead_items = start + nitems;
 	}
+	else if (nitems < DEAD_BITMAP_ITEMS(offnum))
+	{
+		/* the list is still no longer than a bitmap would be */
+		Assert(nitems == 0 || items[start + nitems - 1] < offnum);
+		items[start + nitems] = offnum;
+		vacrelstats->num_dead_items++;
+	}
+	else
+	{
+		/* convert the list to a bitmap */
+		uint16		offsets[DEAD_ITEMS_PER_PAGE];
+		uint32		nwords = DEAD_BITMAP_ITEMS(offnum);
+		uint32		i;
+
+		memcpy(offsets, &items[start], nitems * sizeof(uint16));
+		memset(&items[start], 0, nwords * sizeof(uint16));
+		for (i = 0; i < nitems; i++)
+			items[start + offsets[i] / 16] |= (uint16) (1 << (offsets[i] % 16));
+		items[start + offnum / 16] |= (uint16) (1 << (offnum % 16));
+
+		blk->start |= DEAD_BLOCK_IS_BITMAP;
+		vacrelstats->num_dead_items = start + nwords;
+	}
+
+	vacrelstats->num_dead_tuples++;
+	pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
+								 vacrelstats->num_dead_tuples);
 }
 
 /*
- *	lazy_tid_reaped() -- is a particular tid deletable?
- *
- *		This has the right signature to be an IndexBulkDeleteCallback.
+ * lazy_dead_block_items - find the items of a dead_blocks entry
+ */
+static inline void
+lazy_dead_block_items(LVRelStats *vacrelstats, int blkindex,
+					  uint32 *start, uint32 *end)
+{
+	*start = vacrelstats->dead_blocks[blkindex].start & DEAD_BLOCK_START_MASK;
+	if (blkindex + 1 < vacrelstats->num_dead_blocks)
+		*end = vacrelstats->dead_blocks[blkindex + 1].start & DEAD_BLOCK_START_MASK;
+	else
+		*end = vacrelstats->num_dead_items;
+}
+
+/*
+ * lazy_dead_block_offsets - get the offsets of one block's dead tuples
  *
- *		Assumes dead_tuples array is in sorted order.
+ * The offsets are stored into *offsets in ascending order, and their number
+ * is returned.
  */
-static bool
-lazy_tid_reaped(ItemPointer itemptr, void *state)
+static int
+lazy_dead_block_offsets(LVRelStats *vacrelstats, int blkindex,
+						OffsetNumber *offsets)
 {
-	LVRelStats *vacrelstats = (LVRelStats *) state;
-	ItemPointer res;
+	uint16	   *items = vacrelstats->dead_items;
+	uint32		start;
+	uint32		end;
+	uint32		i;
+	int			n = 0;
+
+	lazy_dead_block_items(vacrelstats, blkindex, &start, &end);
+
+	if (vacrelstats->dead_blocks[blkindex].start & DEAD_BLOCK_IS_BITMAP)
+	{
+		for (i = start; i < end; i++)
+		{
+			uint16		word = items[i];
+			int			bit;
 
-	res = (ItemPointer) bsearch((void *) itemptr,
-								(void *) vacrelstats->dead_tuples,
-								vacrelstats->num_dead_tuples,
-								sizeof(ItemPointerData),
-								vac_cmp_itemptr);
+			for (bit = 0; word != 0; bit++, word >>= 1)
+			{
+				if (word & 1)
+					offsets[n++] = (i - start) * 16 + bit;
+			}
+		}
+	}
+	else
+	{
+		for (i = start; i < end; i++)
+			offsets[n++] = items[i];
+	}
 
-	return (res != NULL);
+	return n;
 }
 
 /*
- * Comparator routines for use with qsort() and bsearch().
+ *	lazy_tid_reaped() -- is a particular tid deletable?
+ *
+ *		This has the right signature to be an IndexBulkDeleteCallback.
+ *
+ *		Assumes dead_blocks array is in sorted order.
  */
-static int
-vac_cmp_itemptr(const void *left, const void *right)
+static bool
+lazy_tid_reaped(ItemPointer itemptr, void *state)
 {
-	BlockNumber lblk,
-				rblk;
-	OffsetNumber loff,
-				roff;
+	LVRelStats *vacrelstats = (LVRelStats *) state;
+	BlockNumber blkno = ItemPointerGetBlockNumber(itemptr);
+	OffsetNumber offnum = ItemPointerGetOffsetNumber(itemptr);
+	LVDeadBlock *blocks = vacrelstats->dead_blocks;
+	uint16	   *items = vacrelstats->dead_items;
+	int			lo,
+				hi;
+	uint32		start;
+	uint32		end;
+	uint32		i;
+
+	/* Quick exit for TIDs outside the range of blocks we have */
+	if (vacrelstats->num_dead_blocks == 0 ||
+		blkno < blocks[0].blkno ||
+		blkno > blocks[vacrelstats->num_dead_blocks - 1].blkno)
+		return false;
 
-	lblk = ItemPointerGetBlockNumber((ItemPointer) left);
-	rblk = ItemPointerGetBlockNumber((ItemPointer) right);
+	/* Binary search for the block */
+	lo = 0;
+	hi = vacrelstats->num_dead_blocks - 1;
+	while (lo < hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
 
-	if (lblk < rblk)
-		return -1;
-	if (lblk > rblk)
-		return 1;
+		if (blocks[mid].blkno < blkno)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (blocks[lo].blkno != blkno)
+		return false;
 
-	loff = ItemPointerGetOffsetNumber((ItemPointer) left);
-	roff = ItemPointerGetOffsetNumber((ItemPointer) right);
+	lazy_dead_block_items(vacrelstats, lo, &start, &end);
 
-	if (loff < roff)
-		return -1;
-	if (loff > roff)
-		return 1;
+	if (blocks[lo].start & DEAD_BLOCK_IS_BITMAP)
+	{
+		if (offnum / 16 >= end - start)
+			return false;
+		return (items[start + offnum / 16] & (1 << (offnum % 16))) != 0;
+	}
+
+	/* The list is never longer than a bitmap would be, so just scan it */
+	for (i = start; i < end; i++)
+	{
+		if (items[i] >= offnum)
+			return items[i] == offnum;
+	}
 
-	return 0;
+	return false;
 }
 
 /*
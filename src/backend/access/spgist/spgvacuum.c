@@ -20,6 +20,7 @@
 #include "access/spgxlog.h"
 #include "access/transam.h"
 #include "access/xloginsert.h"
+#include "catalog/catalog.h"
 #include "catalog/storage_xlog.h"
 #include "commands/vacuum.h"
 #include "miscadmin.h"
@@ -504,6 +505,7 @@ vacuumRedirectAndPlaceholder(Relation index, Buffer buffer)
 
 	xlrec.nToPlaceholder = 0;
 	xlrec.newestRedirectXid = InvalidTransactionId;
+	xlrec.isCatalogRel = RelationIsAccessibleInLogicalDecoding(index);
 
 	START_CRIT_SECTION();
 
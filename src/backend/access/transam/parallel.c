@@ -14,6 +14,7 @@
 
 #include "postgres.h"
 
+#include "access/gin_private.h"
 #include "access/nbtree.h"
 #include "access/parallel.h"
 #include "access/session.h"
@@ -139,6 +140,9 @@ static const struct
 	},
 	{
 		"_bt_parallel_build_main", _bt_parallel_build_main
+	},
+	{
+		"_gin_parallel_build_main", _gin_parallel_build_main
 	}
 };
 
@@ -1370,7 +1370,7 @@ RecordTransactionCommit(void)
 		 synchronous_commit > SYNCHRONOUS_COMMIT_OFF) ||
 		forceSyncCommit || nrels > 0)
 	{
-		XLogFlush(XactLastRecEnd);
+		XLogFlushCommit(XactLastRecEnd);
 
 		/*
 		 * Now we may update the CLOG, if we wrote a COMMIT record above
@@ -34,6 +34,7 @@
 #include "access/xact.h"
 #include "access/xlog_internal.h"
 #include "access/xloginsert.h"
+#include "access/xlogprefetch.h"
 #include "access/xlogreader.h"
 #include "access/xlogutils.h"
 #include "catalog/catversion.h"
@@ -41,10 +42,12 @@
 #include "catalog/pg_database.h"
 #include "commands/tablespace.h"
 #include "common/controldata_utils.h"
+#include "executor/instrument.h"
 #include "miscadmin.h"
 #include "pg_trace.h"
 #include "pgstat.h"
 #include "port/atomics.h"
+#include "portability/instr_time.h"
 #include "postmaster/bgwriter.h"
 #include "postmaster/startup.h"
 #include "postmaster/walwriter.h"
@@ -101,7 +104,7 @@ bool		wal_recycle = true;
 bool		log_checkpoints = false;
 int			sync_method = DEFAULT_SYNC_METHOD;
 int			wal_level = WAL_LEVEL_MINIMAL;
-int			CommitDelay = 0;	/* precommit delay in microseconds */
+int			CommitDelay = 0;	/* precommit delay in microseconds, or -1 */
 int			CommitSiblings = 5; /* # concurrent xacts needed to sleep */
 int			wal_retrieve_retry_interval = 5000;
 
@@ -118,6 +121,13 @@ int			wal_segment_size = DEFAULT_XLOG_SEG_SIZE;
  */
 #define NUM_XLOGINSERT_LOCKS  8
 
+/*
+ * Upper limit of the commit delay chosen when commit_delay is -1, and the
+ * weight given to each new sample in the moving averages it is based on.
+ */
+#define MAX_ADAPTIVE_COMMIT_DELAY	10000	/* microseconds */
+#define GROUP_COMMIT_SMOOTHING		0.125
+
 /*
  * Max distance from last checkpoint, before triggering a new xlog-based
  * checkpoint.
@@ -605,6 +615,23 @@ typedef struct XLogCtlData
 	pg_time_t	lastSegSwitchTime;
 	XLogRecPtr	lastSegSwitchLSN;
 
+	/*
+	 * Group commit statistics, protected by info_lck.  Only flushes for
+	 * transaction commits are counted: flushRequests counts the
+	 * XLogFlushCommit() calls that had to wait for a flush, and groupFlushes
+	 * the flushes they performed; the ratio of the two is the average number
+	 * of commits served by one flush.  The moving averages of the time such
+	 * a flush takes and of the interval between requests (the latter only
+	 * maintained when commit_delay is -1) are used to choose the adaptive
+	 * delay.  lastCommitDelay is the delay slept before the latest flush.
+	 */
+	uint64		flushRequests;
+	uint64		groupFlushes;
+	TimestampTz lastFlushRequest;
+	double		flushRequestInterval;	/* microseconds */
+	double		flushDuration;	/* microseconds */
+	int			lastCommitDelay;	/* microseconds */
+
 	/*
 	 * Protected by info_lck and WALWriteLock (you must hold either lock to
 	 * read it, but both to update)
@@ -876,6 +903,8 @@ static XLogRecPtr XLogGetReplicationSlotMinimumLSN(void);
 
 static void AdvanceXLInsertBuffer(XLogRecPtr upto, bool opportunistic);
 static bool XLogCheckpointNeeded(XLogSegNo new_segno);
+static void XLogFlushInternal(XLogRecPtr record, bool commit);
+static int	AdaptiveCommitDelay(void);
 static void XLogWrite(XLogwrtRqst WriteRqst, bool flexible);
 static bool InstallXLogFileSegment(XLogSegNo *segno, char *tmppath,
 								   bool find_free, XLogSegNo max_segno,
@@ -969,7 +998,8 @@ static void WALInsertLockUpdateInsertingAt(XLogRecPtr insertingAt);
 XLogRecPtr
 XLogInsertRecord(XLogRecData *rdata,
 				 XLogRecPtr fpw_lsn,
-				 uint8 flags)
+				 uint8 flags,
+				 int num_fpi)
 {
 	XLogCtlInsert *Insert = &XLogCtl->Insert;
 	pg_crc32c	rdata_crc;
@@ -1225,6 +1255,14 @@ XLogInsertRecord(XLogRecData *rdata,
 	ProcLastRecPtr = StartPos;
 	XactLastRecEnd = EndPos;
 
+	/* Report WAL traffic to the instrumentation. */
+	if (inserted)
+	{
+		pgWalUsage.wal_bytes += rechdr->xl_tot_len;
+		pgWalUsage.wal_records++;
+		pgWalUsage.wal_fpi += num_fpi;
+	}
+
 	return EndPos;
 }
 
@@ -2157,6 +2195,7 @@ AdvanceXLInsertBuffer(XLogRecPtr upto, bool opportunistic)
 					WriteRqst.Flush = 0;
 					XLogWrite(WriteRqst, false);
 					LWLockRelease(WALWriteLock);
+					WalStats.m_counts.wal_buffers_full++;
 					TRACE_POSTGRESQL_WAL_BUFFER_WRITE_DIRTY_DONE();
 				}
 				/* Re-acquire WALBufMappingLock and retry */
@@ -2492,10 +2531,31 @@ XLogWrite(XLogwrtRqst WriteRqst, bool flexible)
 			nleft = nbytes;
 			do
 			{
+				instr_time	start;
+
+				if (track_io_timing)
+					INSTR_TIME_SET_CURRENT(start);
+
 				errno = 0;
 				pgstat_report_wait_start(WAIT_EVENT_WAL_WRITE);
 				written = pg_pwrite(openLogFile, from, nleft, startoffset);
 				pgstat_report_wait_end();
+
+				/*
+				 * Count the write even if it failed or was interrupted, so
+				 * that wal_write reflects the system calls actually made.
+				 */
+				if (track_io_timing)
+				{
+					instr_time	duration;
+
+					INSTR_TIME_SET_CURRENT(duration);
+					INSTR_TIME_SUBTRACT(duration, start);
+					WalStats.m_counts.wal_write_time +=
+						INSTR_TIME_GET_MICROSEC(duration);
+				}
+				WalStats.m_counts.wal_write++;
+
 				if (written <= 0)
 				{
 					char		xlogfname[MAXFNAMELEN];
@@ -2802,9 +2862,28 @@ UpdateMinRecoveryPoint(XLogRecPtr lsn, bool force)
  */
 void
 XLogFlush(XLogRecPtr record)
+{
+	XLogFlushInternal(record, false);
+}
+
+/*
+ * Like XLogFlush, for the commit record of a transaction.  These are the
+ * flushes that group commit statistics and the adaptive commit delay are
+ * based on.
+ */
+void
+XLogFlushCommit(XLogRecPtr record)
+{
+	XLogFlushInternal(record, true);
+}
+
+static void
+XLogFlushInternal(XLogRecPtr record, bool commit)
 {
 	XLogRecPtr	WriteRqstPtr;
 	XLogwrtRqst WriteRqst;
+	TimestampTz now = 0;
+	bool		counted = false;
 
 	/*
 	 * During REDO, we are reading not writing WAL.  Therefore, instead of
@@ -2831,6 +2910,10 @@ XLogFlush(XLogRecPtr record)
 			 (uint32) (LogwrtResult.Flush >> 32), (uint32) LogwrtResult.Flush);
 #endif
 
+	/* The adaptive commit delay needs to know how often commits are made */
+	if (commit && CommitDelay < 0)
+		now = GetCurrentTimestamp();
+
 	START_CRIT_SECTION();
 
 	/*
@@ -2851,12 +2934,34 @@ XLogFlush(XLogRecPtr record)
 	for (;;)
 	{
 		XLogRecPtr	insertpos;
+		int			commit_delay;
+		instr_time	flush_start;
+		instr_time	flush_time;
 
 		/* read LogwrtResult and update local state */
 		SpinLockAcquire(&XLogCtl->info_lck);
 		if (WriteRqstPtr < XLogCtl->LogwrtRqst.Write)
 			WriteRqstPtr = XLogCtl->LogwrtRqst.Write;
 		LogwrtResult = XLogCtl->LogwrtResult;
+		if (commit && !counted)
+		{
+			XLogCtl->flushRequests++;
+			if (now != 0)
+			{
+				if (XLogCtl->lastFlushRequest != 0)
+				{
+					double		interval;
+
+					interval = Max(now - XLogCtl->lastFlushRequest, 0);
+					interval = Min(interval, USECS_PER_SEC);
+					XLogCtl->flushRequestInterval +=
+						(interval - XLogCtl->flushRequestInterval) *
+						GROUP_COMMIT_SMOOTHING;
+				}
+				XLogCtl->lastFlushRequest = Max(now, XLogCtl->lastFlushRequest);
+			}
+			counted = true;
+		}
 		SpinLockRelease(&XLogCtl->info_lck);
 
 		/* done already? */
@@ -2902,11 +3007,20 @@ XLogFlush(XLogRecPtr record)
 		 *
 		 * We do not sleep if enableFsync is not turned on, nor if there are
 		 * fewer than CommitSiblings other backends with active transactions.
+		 * If commit_delay is -1, commit flushes instead sleep for a delay
+		 * derived from recent commit flush durations and arrival rate; see
+		 * AdaptiveCommitDelay.  Other flushes don't sleep in that mode.
 		 */
-		if (CommitDelay > 0 && enableFsync &&
-			MinimumActiveBackends(CommitSiblings))
+		if (CommitDelay < 0)
+			commit_delay = commit ? AdaptiveCommitDelay() : 0;
+		else if (CommitDelay > 0 && MinimumActiveBackends(CommitSiblings))
+			commit_delay = CommitDelay;
+		else
+			commit_delay = 0;
+
+		if (commit_delay > 0 && enableFsync)
 		{
-			pg_usleep(CommitDelay);
+			pg_usleep(commit_delay);
 
 			/*
 			 * Re-check how far we can now flush the WAL. It's generally not
@@ -2925,9 +3039,23 @@ XLogFlush(XLogRecPtr record)
 		WriteRqst.Write = insertpos;
 		WriteRqst.Flush = insertpos;
 
+		INSTR_TIME_SET_CURRENT(flush_start);
 		XLogWrite(WriteRqst, false);
+		INSTR_TIME_SET_CURRENT(flush_time);
+		INSTR_TIME_SUBTRACT(flush_time, flush_start);
 
 		LWLockRelease(WALWriteLock);
+
+		if (commit)
+		{
+			SpinLockAcquire(&XLogCtl->info_lck);
+			XLogCtl->groupFlushes++;
+			XLogCtl->flushDuration +=
+				((double) INSTR_TIME_GET_MICROSEC(flush_time) -
+				 XLogCtl->flushDuration) * GROUP_COMMIT_SMOOTHING;
+			XLogCtl->lastCommitDelay = enableFsync ? commit_delay : 0;
+			SpinLockRelease(&XLogCtl->info_lck);
+		}
 		/* done */
 		break;
 	}
@@ -2965,6 +3093,48 @@ XLogFlush(XLogRecPtr record)
 			 (uint32) (LogwrtResult.Flush >> 32), (uint32) LogwrtResult.Flush);
 }
 
+/*
+ * Choose the delay to sleep before a group commit flush, when commit_delay
+ * is -1.
+ *
+ * Sleeping is only worthwhile if other backends are likely to ask for a
+ * flush while we sleep, so that they can be served by the same flush.  We
+ * sleep for half of the recent average flush duration (the classic rule of
+ * thumb for commit_delay), but only if flush requests have recently been
+ * arriving more often than that.  Caller must hold WALWriteLock.
+ */
+static int
+AdaptiveCommitDelay(void)
+{
+	int			delay;
+
+	SpinLockAcquire(&XLogCtl->info_lck);
+	delay = (int) Min(XLogCtl->flushDuration / 2, MAX_ADAPTIVE_COMMIT_DELAY);
+	if (XLogCtl->flushRequestInterval >= delay)
+		delay = 0;
+	SpinLockRelease(&XLogCtl->info_lck);
+
+	return delay;
+}
+
+/*
+ * Report group commit statistics accumulated since server start, for the
+ * pg_stat_group_commit view.  *flush_time is the recent average duration of
+ * a commit flush in microseconds, and *commit_delay the delay slept before
+ * the latest one, which with commit_delay = -1 is the adaptive delay.
+ */
+void
+GetXLogGroupCommitStats(uint64 *requests, uint64 *flushes,
+						double *flush_time, int *commit_delay)
+{
+	SpinLockAcquire(&XLogCtl->info_lck);
+	*requests = XLogCtl->flushRequests;
+	*flushes = XLogCtl->groupFlushes;
+	*flush_time = XLogCtl->flushDuration;
+	*commit_delay = XLogCtl->lastCommitDelay;
+	SpinLockRelease(&XLogCtl->info_lck);
+}
+
 /*
  * Write & flush xlog, but without specifying exactly where to.
  *
@@ -4821,6 +4991,17 @@ DataChecksumsEnabled(void)
 	return (ControlFile->data_checksum_version > 0);
 }
 
+/*
+ * Get the wal_level in use on the primary, as last seen in a checkpoint or
+ * XLOG_PARAMETER_CHANGE record replayed by this standby.
+ */
+WalLevel
+GetActiveWalLevelOnStandby(void)
+{
+	Assert(ControlFile != NULL);
+	return ControlFile->wal_level;
+}
+
 /*
  * Returns a fake LSN for unlogged relations.
  *
@@ -7046,6 +7227,7 @@ StartupXLOG(void)
 		{
 			ErrorContextCallback errcallback;
 			TimestampTz xtime;
+			XLogPrefetcher *prefetcher;
 
 			InRedo = true;
 
@@ -7053,6 +7235,8 @@ StartupXLOG(void)
 					(errmsg("redo starts at %X/%X",
 							(uint32) (ReadRecPtr >> 32), (uint32) ReadRecPtr)));
 
+			prefetcher = XLogPrefetcherAllocate();
+
 			/*
 			 * main redo apply loop
 			 */
@@ -7124,6 +7308,12 @@ StartupXLOG(void)
 						recoveryPausesHere();
 				}
 
+				/*
+				 * Look ahead in the WAL, and start reading the blocks that
+				 * upcoming records will need.
+				 */
+				XLogPrefetcherReadAhead(prefetcher, ReadRecPtr);
+
 				/* Setup error traceback support for ereport() */
 				errcallback.callback = rm_redo_error_callback;
 				errcallback.arg = (void *) xlogreader;
@@ -7254,6 +7444,16 @@ StartupXLOG(void)
 					if (switchedTLI && AllowCascadeReplication())
 						WalSndWakeup();
 				}
+				else if (record->xl_rmid == RM_XACT_ID &&
+						 AllowCascadeReplication())
+				{
+					/*
+					 * Logical walsenders on this standby only decode WAL
+					 * that has been replayed; wake them up at transaction
+					 * boundaries, where they have something to send.
+					 */
+					WalSndWakeup();
+				}
 
 				/* Exit loop if we reached inclusive recovery target */
 				if (recoveryStopsAfter(xlogreader))
@@ -7270,6 +7470,8 @@ StartupXLOG(void)
 			 * end of main redo apply loop
 			 */
 
+			XLogPrefetcherFree(prefetcher);
+
 			if (reachedStopPoint)
 			{
 				if (!reachedConsistency)
@@ -9926,6 +10128,14 @@ xlog_redo(XLogReaderState *record)
 		UpdateControlFile();
 		LWLockRelease(ControlFileLock);
 
+		/*
+		 * If the primary no longer logs the information logical decoding
+		 * needs, logical slots on this standby can't be used any more.
+		 */
+		if (ArchiveRecoveryRequested && xlrec.wal_level < WAL_LEVEL_LOGICAL)
+			InvalidateConflictingLogicalReplicationSlots(InvalidOid,
+														 InvalidTransactionId);
+
 		/* Check to see if any parameter change gives a problem on recovery */
 		CheckRequiredParameterValues();
 	}
@@ -10126,6 +10336,19 @@ void
 issue_xlog_fsync(int fd, XLogSegNo segno)
 {
 	char	   *msg = NULL;
+	bool		do_sync;
+	instr_time	start;
+
+	/*
+	 * There is nothing to count or time if the write itself already synced
+	 * the WAL, or if fsync is disabled.
+	 */
+	do_sync = enableFsync &&
+		sync_method != SYNC_METHOD_OPEN &&
+		sync_method != SYNC_METHOD_OPEN_DSYNC;
+
+	if (do_sync && track_io_timing)
+		INSTR_TIME_SET_CURRENT(start);
 
 	pgstat_report_wait_start(WAIT_EVENT_WAL_SYNC);
 	switch (sync_method)
@@ -10170,6 +10393,19 @@ issue_xlog_fsync(int fd, XLogSegNo segno)
 	}
 
 	pgstat_report_wait_end();
+
+	if (do_sync)
+	{
+		if (track_io_timing)
+		{
+			instr_time	duration;
+
+			INSTR_TIME_SET_CURRENT(duration);
+			INSTR_TIME_SUBTRACT(duration, start);
+			WalStats.m_counts.wal_sync_time += INSTR_TIME_GET_MICROSEC(duration);
+		}
+		WalStats.m_counts.wal_sync++;
+	}
 }
 
 /*
@@ -11368,6 +11604,18 @@ read_backup_label(XLogRecPtr *checkPointLoc, bool *backupEndRequired,
 						tli_from_file, BACKUP_LABEL_FILE)));
 	}
 
+	/*
+	 * INCREMENTAL FROM LSN is only present in incremental base backups, which
+	 * contain just the blocks changed since an earlier backup and cannot be
+	 * started without first being combined with that backup.
+	 */
+	if (fscanf(lfp, "INCREMENTAL FROM LSN: %X/%X\n", &hi, &lo) == 2)
+		ereport(FATAL,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("file \"%s\" belongs to an incremental backup",
+						BACKUP_LABEL_FILE),
+				 errhint("Use pg_combinebackup to combine it with the backups it depends on.")));
+
 	if (ferror(lfp) || FreeFile(lfp))
 		ereport(FATAL,
 				(errcode_for_file_access(),
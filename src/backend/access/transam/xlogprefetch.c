@@ -0,0 +1,397 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogprefetch.c
+ *		Prefetching support for recovery.
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *		src/backend/access/transam/xlogprefetch.c
+ *
+ * The startup process replays WAL records one at a time, and a record that
+ * references a block that isn't in shared buffers has to wait for that block
+ * to be read synchronously.  When a standby is far behind, replay is then
+ * limited by the latency of one random read at a time, even though the
+ * storage could serve many at once.
+ *
+ * To get more I/O going, we decode records ahead of the one being replayed,
+ * using a second xlogreader, up to max_recovery_prefetch_distance bytes of
+ * WAL, and issue prefetch requests (posix_fadvise(), via smgrprefetch()) for
+ * the blocks they reference.  By the time replay gets to those records, the
+ * kernel has hopefully brought the blocks into its page cache.
+ *
+ * Blocks that replay won't need to read are skipped: those that will be
+ * restored from a full page image or initialized from scratch, and those
+ * already in shared buffers.  We also remember the last few blocks we
+ * prefetched, so that we don't issue repeated requests for the same block or
+ * for sequential access, which the kernel's readahead handles by itself.
+ *
+ * The look-ahead reader reads WAL segment files from pg_wal directly and
+ * never waits for WAL to arrive.  If the next record is not available yet,
+ * or isn't valid, it gives up and tries again after replay has advanced a
+ * bit; if replay gets ahead of it, it starts over at the record being
+ * replayed.  It only opens segment files in pg_wal named for the timeline
+ * being replayed, ThisTimeLineID, so it sees the WAL of crash recovery and of
+ * streaming replication on the current timeline, and nothing else.  WAL
+ * restored from the archive is never prefetched, because it is read from a
+ * temporary file with a different name; nor is WAL on any other timeline, so
+ * prefetching stops at a timeline switch until replay has crossed it.
+ * Nothing here can affect correctness: a prefetch request is only a hint.
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "access/xlog.h"
+#include "access/xlog_internal.h"
+#include "access/xlogprefetch.h"
+#include "access/xlogreader.h"
+#include "access/xlogrecord.h"
+#include "port/atomics.h"
+#include "storage/bufmgr.h"
+#include "storage/fd.h"
+#include "storage/shmem.h"
+#include "storage/smgr.h"
+
+/*
+ * Number of recently prefetched blocks to remember, to avoid repeated
+ * requests for the same block and for sequential access.
+ */
+#define XLOGPREFETCHER_RECENT_SIZE 4
+
+typedef struct XLogPrefetcherRecentBlock
+{
+	RelFileNode rnode;
+	ForkNumber	forknum;
+	BlockNumber blkno;
+} XLogPrefetcherRecentBlock;
+
+struct XLogPrefetcher
+{
+	/* Reader used to decode records ahead of replay */
+	XLogReaderState *reader;
+
+	/* Is the reader positioned, so that we can just read the next record? */
+	bool		reading;
+
+	/* After a failed read, don't try again until replay gets here */
+	XLogRecPtr	retry_lsn;
+
+	/* Timeline to read WAL from */
+	TimeLineID	tli;
+
+	/* Ring buffer of recently prefetched blocks */
+	XLogPrefetcherRecentBlock recent[XLOGPREFETCHER_RECENT_SIZE];
+	int			next_recent;
+};
+
+/*
+ * Statistics, in shared memory.  They are only written by the startup
+ * process, so plain atomic reads and writes are enough.
+ */
+typedef struct XLogPrefetchShared
+{
+	pg_atomic_uint64 prefetch;
+	pg_atomic_uint64 skip_hit;
+	pg_atomic_uint64 skip_new;
+	pg_atomic_uint64 skip_fpw;
+	pg_atomic_uint64 skip_seq;
+	pg_atomic_uint64 distance;
+} XLogPrefetchShared;
+
+static XLogPrefetchShared *SharedPrefetch = NULL;
+
+/* GUC parameter */
+int			max_recovery_prefetch_distance = -1;
+
+static int	XLogPrefetcherReadPage(XLogReaderState *state,
+								   XLogRecPtr targetPagePtr, int reqLen,
+								   XLogRecPtr targetRecPtr, char *readBuf);
+static int	XLogPrefetcherOpenSegment(XLogSegNo nextSegNo,
+									  WALSegmentContext *segcxt,
+									  TimeLineID *tli_p);
+static void XLogPrefetcherScanBlocks(XLogPrefetcher *prefetcher);
+static bool XLogPrefetcherIsRecent(XLogPrefetcher *prefetcher,
+								   DecodedBkpBlock *block);
+
+static inline void
+XLogPrefetchIncrement(pg_atomic_uint64 *counter)
+{
+	pg_atomic_write_u64(counter, pg_atomic_read_u64(counter) + 1);
+}
+
+/*
+ * Initialization of shared memory for prefetching statistics
+ */
+Size
+XLogPrefetchShmemSize(void)
+{
+	return sizeof(XLogPrefetchShared);
+}
+
+void
+XLogPrefetchShmemInit(void)
+{
+	bool		found;
+
+	SharedPrefetch = (XLogPrefetchShared *)
+		ShmemInitStruct("XLogPrefetchShared",
+						sizeof(XLogPrefetchShared),
+						&found);
+	if (!found)
+	{
+		pg_atomic_init_u64(&SharedPrefetch->prefetch, 0);
+		pg_atomic_init_u64(&SharedPrefetch->skip_hit, 0);
+		pg_atomic_init_u64(&SharedPrefetch->skip_new, 0);
+		pg_atomic_init_u64(&SharedPrefetch->skip_fpw, 0);
+		pg_atomic_init_u64(&SharedPrefetch->skip_seq, 0);
+		pg_atomic_init_u64(&SharedPrefetch->distance, 0);
+	}
+}
+
+/*
+ * Return a copy of the prefetching statistics.
+ */
+void
+XLogPrefetchGetStats(XLogPrefetchStats *stats)
+{
+	stats->prefetch = pg_atomic_read_u64(&SharedPrefetch->prefetch);
+	stats->skip_hit = pg_atomic_read_u64(&SharedPrefetch->skip_hit);
+	stats->skip_new = pg_atomic_read_u64(&SharedPrefetch->skip_new);
+	stats->skip_fpw = pg_atomic_read_u64(&SharedPrefetch->skip_fpw);
+	stats->skip_seq = pg_atomic_read_u64(&SharedPrefetch->skip_seq);
+	stats->distance = pg_atomic_read_u64(&SharedPrefetch->distance);
+}
+
+/*
+ * Create a prefetcher.  It starts reading at the first record it is asked
+ * to look ahead of.
+ */
+XLogPrefetcher *
+XLogPrefetcherAllocate(void)
+{
+	XLogPrefetcher *prefetcher;
+
+	prefetcher = palloc0(sizeof(XLogPrefetcher));
+	prefetcher->reader = XLogReaderAllocate(wal_segment_size, NULL,
+											XLogPrefetcherReadPage,
+											prefetcher);
+	if (prefetcher->reader == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+				 errdetail("Failed while allocating a WAL reading processor.")));
+	prefetcher->reading = false;
+	prefetcher->retry_lsn = InvalidXLogRecPtr;
+
+	return prefetcher;
+}
+
+/*
+ * Destroy a prefetcher.
+ */
+void
+XLogPrefetcherFree(XLogPrefetcher *prefetcher)
+{
+	if (prefetcher->reader->seg.ws_file >= 0)
+		close(prefetcher->reader->seg.ws_file);
+	XLogReaderFree(prefetcher->reader);
+	pfree(prefetcher);
+
+	pg_atomic_write_u64(&SharedPrefetch->distance, 0);
+}
+
+/*
+ * Called by the startup process before replaying the record that starts at
+ * replaying_lsn.  Decode records ahead of it, up to the configured distance,
+ * and issue prefetch requests for the blocks they reference.
+ */
+void
+XLogPrefetcherReadAhead(XLogPrefetcher *prefetcher, XLogRecPtr replaying_lsn)
+{
+	XLogReaderState *reader = prefetcher->reader;
+	XLogRecord *record;
+	char	   *errormsg;
+
+	if (max_recovery_prefetch_distance <= 0)
+	{
+		/* Prefetching is disabled; start over if it's enabled again */
+		if (prefetcher->reading)
+		{
+			prefetcher->reading = false;
+			pg_atomic_write_u64(&SharedPrefetch->distance, 0);
+		}
+		return;
+	}
+
+	/*
+	 * If replay has caught up with us, we have nothing useful to say about
+	 * the records we read before.  Start over at the record being replayed.
+	 */
+	if (prefetcher->reading && reader->EndRecPtr <= replaying_lsn)
+		prefetcher->reading = false;
+
+	/* After a failure, give replay a chance to advance before trying again */
+	if (replaying_lsn < prefetcher->retry_lsn)
+		return;
+
+	prefetcher->tli = ThisTimeLineID;
+
+	while (!prefetcher->reading ||
+		   reader->ReadRecPtr < replaying_lsn + max_recovery_prefetch_distance)
+	{
+		record = XLogReadRecord(reader,
+								prefetcher->reading ? InvalidXLogRecPtr : replaying_lsn,
+								&errormsg);
+		if (record == NULL)
+		{
+			/*
+			 * The next record hasn't been written yet, or we ran into
+			 * something invalid.  Either way, try again once replay has
+			 * moved on a page.
+			 */
+			prefetcher->retry_lsn = replaying_lsn + XLOG_BLCKSZ;
+			break;
+		}
+
+		prefetcher->reading = true;
+		XLogPrefetcherScanBlocks(prefetcher);
+	}
+
+	if (prefetcher->reading && reader->EndRecPtr > replaying_lsn)
+		pg_atomic_write_u64(&SharedPrefetch->distance,
+							reader->EndRecPtr - replaying_lsn);
+	else
+		pg_atomic_write_u64(&SharedPrefetch->distance, 0);
+}
+
+/*
+ * Issue prefetch requests for the blocks referenced by the record the
+ * prefetcher's reader has just decoded.
+ */
+static void
+XLogPrefetcherScanBlocks(XLogPrefetcher *prefetcher)
+{
+	XLogReaderState *reader = prefetcher->reader;
+	int			block_id;
+
+	for (block_id = 0; block_id <= reader->max_block_id; block_id++)
+	{
+		DecodedBkpBlock *block = &reader->blocks[block_id];
+		SMgrRelation reln;
+
+		if (!block->in_use)
+			continue;
+
+		/* Replay will restore a full page image without reading the page */
+		if (block->apply_image)
+		{
+			XLogPrefetchIncrement(&SharedPrefetch->skip_fpw);
+			continue;
+		}
+
+		/* Likewise if the page is going to be initialized */
+		if (block->flags & BKPBLOCK_WILL_INIT)
+		{
+			XLogPrefetchIncrement(&SharedPrefetch->skip_new);
+			continue;
+		}
+
+		if (XLogPrefetcherIsRecent(prefetcher, block))
+		{
+			XLogPrefetchIncrement(&SharedPrefetch->skip_seq);
+			continue;
+		}
+
+		reln = smgropen(block->rnode, InvalidBackendId);
+		switch (PrefetchSharedBuffer(reln, block->forknum, block->blkno))
+		{
+			case PREFETCH_BUFFER_HIT:
+				XLogPrefetchIncrement(&SharedPrefetch->skip_hit);
+				break;
+			case PREFETCH_BUFFER_INITIATED:
+				XLogPrefetchIncrement(&SharedPrefetch->prefetch);
+				break;
+			case PREFETCH_BUFFER_NOFILE:
+				XLogPrefetchIncrement(&SharedPrefetch->skip_new);
+				break;
+		}
+	}
+}
+
+/*
+ * Check whether the block is one we prefetched recently, or the one right
+ * after it.  If not, remember it for next time.
+ */
+static bool
+XLogPrefetcherIsRecent(XLogPrefetcher *prefetcher, DecodedBkpBlock *block)
+{
+	XLogPrefetcherRecentBlock *recent;
+	int			i;
+
+	for (i = 0; i < XLOGPREFETCHER_RECENT_SIZE; i++)
+	{
+		recent = &prefetcher->recent[i];
+
+		if (RelFileNodeEquals(recent->rnode, block->rnode) &&
+			recent->forknum == block->forknum &&
+			(recent->blkno == block->blkno ||
+			 recent->blkno + 1 == block->blkno))
+		{
+			recent->blkno = block->blkno;
+			return true;
+		}
+	}
+
+	recent = &prefetcher->recent[prefetcher->next_recent];
+	recent->rnode = block->rnode;
+	recent->forknum = block->forknum;
+	recent->blkno = block->blkno;
+	prefetcher->next_recent =
+		(prefetcher->next_recent + 1) % XLOGPREFETCHER_RECENT_SIZE;
+
+	return false;
+}
+
+/*
+ * read_page callback for the look-ahead reader.  Unlike the startup
+ * process's own callback, this never waits: if the page can't be read, we
+ * just report failure.  A page that is only partially written is returned
+ * as a whole; the reader will reject whatever it finds past the end of
+ * valid WAL.
+ */
+static int
+XLogPrefetcherReadPage(XLogReaderState *state, XLogRecPtr targetPagePtr,
+					   int reqLen, XLogRecPtr targetRecPtr, char *readBuf)
+{
+	XLogPrefetcher *prefetcher = (XLogPrefetcher *) state->private_data;
+	WALReadError errinfo;
+
+	if (!WALRead(readBuf, targetPagePtr, XLOG_BLCKSZ, prefetcher->tli,
+				 &state->seg, &state->segcxt, XLogPrefetcherOpenSegment,
+				 &errinfo))
+		return -1;
+
+	return XLOG_BLCKSZ;
+}
+
+/*
+ * openSegment callback for WALRead.  A missing segment is not an error
+ * here; WALRead() then fails to read from the invalid file descriptor, and
+ * we try again later.
+ */
+static int
+XLogPrefetcherOpenSegment(XLogSegNo nextSegNo, WALSegmentContext *segcxt,
+						  TimeLineID *tli_p)
+{
+	char		path[MAXPGPATH];
+
+	XLogFilePath(path, *tli_p, nextSegNo, segcxt->ws_segsize);
+
+	return BasicOpenFile(path, O_RDONLY | PG_BINARY);
+}
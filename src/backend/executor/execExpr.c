@@ -626,6 +626,19 @@ ExecCheck(ExprState *state, ExprContext *econtext)
 static void
 ExecReadyExpr(ExprState *state)
 {
+	/*
+	 * If JIT compilation is to be deferred, interpret the expression until
+	 * it has been evaluated often enough to make compiling it worthwhile.
+	 * See ExecInterpExprDeferredJit().
+	 */
+	if (jit_defer_expr(state))
+	{
+		ExecReadyInterpretedExpr(state);
+		state->flags |= EEO_FLAG_JIT_DEFERRED;
+		state->jit_countdown = Max(jit_expr_threshold, 1);
+		return;
+	}
+
 	if (jit_compile_expr(state))
 		return;
 
@@ -2234,7 +2247,15 @@ ExecInitFunc(ExprEvalStep *scratch, Expr *node, List *args, Oid funcid,
 	if (pgstat_track_functions <= flinfo->fn_stats)
 	{
 		if (flinfo->fn_strict && nargs > 0)
-			scratch->opcode = EEOP_FUNCEXPR_STRICT;
+		{
+			/* Choose nargs optimized implementation if available. */
+			if (nargs == 1)
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_1;
+			else if (nargs == 2)
+				scratch->opcode = EEOP_FUNCEXPR_STRICT_2;
+			else
+				scratch->opcode = EEOP_FUNCEXPR_STRICT;
+		}
 		else
 			scratch->opcode = EEOP_FUNCEXPR;
 	}
@@ -62,6 +62,7 @@
 #include "executor/execExpr.h"
 #include "executor/nodeSubplan.h"
 #include "funcapi.h"
+#include "jit/jit.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
 #include "parser/parsetree.h"
@@ -139,6 +140,7 @@ static ExprEvalOpLookup reverse_dispatch_table[EEOP_LAST];
 
 
 static Datum ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull);
+static Datum ExecInterpExprDeferredJit(ExprState *state, ExprContext *econtext, bool *isnull);
 static void ExecInitInterpreter(void);
 
 /* support functions */
@@ -253,7 +255,9 @@ ExecReadyInterpretedExpr(ExprState *state)
 			return;
 		}
 		else if (step0 == EEOP_CASE_TESTVAL &&
-				 step1 == EEOP_FUNCEXPR_STRICT &&
+				 (step1 == EEOP_FUNCEXPR_STRICT ||
+				  step1 == EEOP_FUNCEXPR_STRICT_1 ||
+				  step1 == EEOP_FUNCEXPR_STRICT_2) &&
 				 state->steps[0].d.casetest.value)
 		{
 			state->evalfunc_private = (void *) ExecJustApplyFuncToCase;
@@ -367,6 +371,8 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_CONST,
 		&&CASE_EEOP_FUNCEXPR,
 		&&CASE_EEOP_FUNCEXPR_STRICT,
+		&&CASE_EEOP_FUNCEXPR_STRICT_1,
+		&&CASE_EEOP_FUNCEXPR_STRICT_2,
 		&&CASE_EEOP_FUNCEXPR_FUSAGE,
 		&&CASE_EEOP_FUNCEXPR_STRICT_FUSAGE,
 		&&CASE_EEOP_BOOL_AND_STEP_FIRST,
@@ -694,6 +700,57 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 			EEO_NEXT();
 		}
 
+		/*
+		 * Strict functions with one or two arguments, which covers nearly all
+		 * operators, are common enough to be worth checking their arguments'
+		 * NULLness without a loop.
+		 */
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_1)
+		{
+			FunctionCallInfo fcinfo = op->d.func.fcinfo_data;
+			NullableDatum *args = fcinfo->args;
+
+			Assert(op->d.func.nargs == 1);
+
+			/* strict function, so check for NULL args */
+			if (args[0].isnull)
+				*op->resnull = true;
+			else
+			{
+				Datum		d;
+
+				fcinfo->isnull = false;
+				d = op->d.func.fn_addr(fcinfo);
+				*op->resvalue = d;
+				*op->resnull = fcinfo->isnull;
+			}
+
+			EEO_NEXT();
+		}
+
+		EEO_CASE(EEOP_FUNCEXPR_STRICT_2)
+		{
+			FunctionCallInfo fcinfo = op->d.func.fcinfo_data;
+			NullableDatum *args = fcinfo->args;
+
+			Assert(op->d.func.nargs == 2);
+
+			/* strict function, so check for NULL args */
+			if (args[0].isnull || args[1].isnull)
+				*op->resnull = true;
+			else
+			{
+				Datum		d;
+
+				fcinfo->isnull = false;
+				d = op->d.func.fn_addr(fcinfo);
+				*op->resvalue = d;
+				*op->resnull = fcinfo->isnull;
+			}
+
+			EEO_NEXT();
+		}
+
 		EEO_CASE(EEOP_FUNCEXPR_FUSAGE)
 		{
 			/* not common enough to inline */
@@ -1803,12 +1860,47 @@ ExecInterpExprStillValid(ExprState *state, ExprContext *econtext, bool *isNull)
 	CheckExprStillValid(state, econtext);
 
 	/* skip the check during further executions */
-	state->evalfunc = (ExprStateEvalFunc) state->evalfunc_private;
+	if (state->flags & EEO_FLAG_JIT_DEFERRED)
+		state->evalfunc = ExecInterpExprDeferredJit;
+	else
+		state->evalfunc = (ExprStateEvalFunc) state->evalfunc_private;
 
 	/* and actually execute */
 	return state->evalfunc(state, econtext, isNull);
 }
 
+/*
+ * Expression evaluation callback for expressions whose JIT compilation has
+ * been deferred (see ExecReadyExpr()).  Interprets the expression, until it
+ * has been evaluated jit_expr_threshold times; then it is compiled, and the
+ * compiled code is used from there on.
+ */
+static Datum
+ExecInterpExprDeferredJit(ExprState *state, ExprContext *econtext, bool *isNull)
+{
+	EState	   *estate = state->parent->state;
+	MemoryContext oldcontext;
+
+	if (--state->jit_countdown > 0)
+		return ((ExprStateEvalFunc) state->evalfunc_private) (state, econtext, isNull);
+
+	state->flags &= ~EEO_FLAG_JIT_DEFERRED;
+
+	/*
+	 * We're likely called in a short-lived memory context, but the compiled
+	 * expression's state has to live as long as the query.  If compilation
+	 * isn't possible after all, just keep interpreting.
+	 */
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+	if (jit_compile_expr(state))
+		estate->es_jit->instr.deferred_exprs++;
+	else
+		state->evalfunc = (ExprStateEvalFunc) state->evalfunc_private;
+	MemoryContextSwitchTo(oldcontext);
+
+	return state->evalfunc(state, econtext, isNull);
+}
+
 /*
  * Check that an expression is still valid in the face of potential schema
  * changes since the plan has been created.
@@ -191,8 +191,9 @@
  *	  So we create an array, aggcontexts, with an ExprContext for each grouping
  *	  set in the largest rollup that we're going to process, and use the
  *	  per-tuple memory context of those ExprContexts to store the aggregate
- *	  transition values.  hashcontext is the single context created to support
- *	  all hash tables.
+ *	  transition values.  hashcontext is the single context created to hold
+ *	  the transition values of all hash tables; the hash table entries
+ *	  themselves go into hash_tablecxt, a bump context.
  *
  *    Transition / Combine function invocation:
  *
@@ -1256,9 +1257,12 @@ find_unaggregated_cols_walker(Node *node, Bitmapset **colnos)
  * We have a separate hashtable and associated perhash data structure for each
  * grouping set for which we're doing hashing.
  *
- * The contents of the hash tables always live in the hashcontext's per-tuple
- * memory context (there is only one of these for all tables together, since
- * they are all reset at the same time).
+ * The hash table entries (representative tuples and per-group arrays) live
+ * in hash_tablecxt, a bump context, since they are never freed individually.
+ * There is only one of these for all tables together, since they are all
+ * reset at the same time.  Transition values live in the hashcontext's
+ * per-tuple memory instead, since transition functions may free and
+ * reallocate them.
  */
 static void
 build_hash_table(AggState *aggstate)
@@ -1290,7 +1294,7 @@ build_hash_table(AggState *aggstate)
 														perhash->aggnode->numGroups,
 														additionalsize,
 														aggstate->ss.ps.state->es_query_cxt,
-														aggstate->hashcontext->ecxt_per_tuple_memory,
+														aggstate->hash_tablecxt,
 														tmpmem,
 														DO_AGGSPLIT_SKIPFINAL(aggstate->aggsplit));
 	}
@@ -2213,6 +2217,10 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	{
 		ExecAssignExprContext(estate, &aggstate->ss.ps);
 		aggstate->hashcontext = aggstate->ss.ps.ps_ExprContext;
+
+		aggstate->hash_tablecxt = BumpContextCreate(estate->es_query_cxt,
+													"HashAgg table context",
+													ALLOCSET_DEFAULT_SIZES);
 	}
 
 	ExecAssignExprContext(estate, &aggstate->ss.ps);
@@ -3414,6 +3422,8 @@ ExecEndAgg(AggState *node)
 		ReScanExprContext(node->aggcontexts[setno]);
 	if (node->hashcontext)
 		ReScanExprContext(node->hashcontext);
+	if (node->hash_tablecxt)
+		MemoryContextDelete(node->hash_tablecxt);
 
 	/*
 	 * We don't actually free any ExprContexts here (see comment in
@@ -3509,13 +3519,14 @@ ExecReScanAgg(AggState *node)
 	MemSet(econtext->ecxt_aggnulls, 0, sizeof(bool) * node->numaggs);
 
 	/*
-	 * With AGG_HASHED/MIXED, the hash table is allocated in a sub-context of
-	 * the hashcontext. This used to be an issue, but now, resetting a context
-	 * automatically deletes sub-contexts too.
+	 * With AGG_HASHED/MIXED, the hash table entries live in hash_tablecxt and
+	 * the transition values in the hashcontext; both must be reset before
+	 * rebuilding the table.
 	 */
 	if (node->aggstrategy == AGG_HASHED || node->aggstrategy == AGG_MIXED)
 	{
 		ReScanExprContext(node->hashcontext);
+		MemoryContextReset(node->hash_tablecxt);
 		/* Rebuild an empty hash table */
 		build_hash_table(node);
 		node->table_filled = false;
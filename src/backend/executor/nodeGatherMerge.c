@@ -247,8 +247,13 @@ ExecGatherMerge(PlanState *pstate)
 			}
 		}
 
-		/* allow leader to participate if enabled or no choice */
-		if (parallel_leader_participation || node->nreaders == 0)
+		/*
+		 * allow leader to participate if enabled or no choice.  A
+		 * parallel-aware Sort returns all its tuples in the leader, so the
+		 * leader must always run that.
+		 */
+		if (parallel_leader_participation || node->nreaders == 0 ||
+			(IsA(outerPlan(gm), Sort) && outerPlan(gm)->parallel_aware))
 			node->need_to_scan_locally = true;
 		node->initialized = true;
 	}
@@ -34,6 +34,7 @@
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
+#include "lib/bloomfilter.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/atomics.h"
@@ -43,6 +44,26 @@
 #include "utils/memutils.h"
 #include "utils/syscache.h"
 
+/*
+ * Parameters of the Bloom filter built over the inner side's hash values.
+ *
+ * Inner relations whose hash table is estimated to be smaller than
+ * HJ_BLOOM_MIN_TABLE_SIZE are probed cheaply enough that a filter doesn't
+ * pay off.  The filter is sized at HJ_BLOOM_BITS_PER_TUPLE bits per
+ * estimated inner tuple, for a false positive rate of about 2%, and is
+ * dropped if after the build more than HJ_BLOOM_MAX_FILL of its bits are set,
+ * or if it rejects less than HJ_BLOOM_MIN_REJECT of the outer tuples checked
+ * (as of every HJ_BLOOM_CHECK_INTERVAL checks).
+ */
+#define HJ_BLOOM_MIN_TABLE_SIZE		(256 * 1024)
+#define HJ_BLOOM_BITS_PER_TUPLE		8
+#define HJ_BLOOM_MAX_FILL			0.75
+#define HJ_BLOOM_MIN_REJECT			0.1
+#define HJ_BLOOM_CHECK_INTERVAL		4096
+
+/* GUC parameter */
+bool		enable_hashjoin_bloom = true;
+
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
 static void ExecHashIncreaseNumBuckets(HashJoinTable hashtable);
 static void ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable);
@@ -60,6 +81,8 @@ static HashJoinTuple ExecParallelHashTupleAlloc(HashJoinTable hashtable,
 												size_t size,
 												dsa_pointer *shared);
 static void MultiExecPrivateHash(HashState *node);
+static void ExecHashInitBloomFilter(HashState *node);
+static void ExecHashFreeBloomFilter(HashJoinTable hashtable);
 static void MultiExecParallelHash(HashState *node);
 static inline HashJoinTuple ExecParallelHashFirstTuple(HashJoinTable table,
 													   int bucketno);
@@ -156,6 +179,8 @@ MultiExecPrivateHash(HashState *node)
 	hashkeys = node->hashkeys;
 	econtext = node->ps.ps_ExprContext;
 
+	ExecHashInitBloomFilter(node);
+
 	/*
 	 * Get all tuples from the node below the Hash node and insert into the
 	 * hash table (or temp files).
@@ -173,6 +198,11 @@ MultiExecPrivateHash(HashState *node)
 		{
 			int			bucketNumber;
 
+			if (hashtable->bloomFilter)
+				bloom_add_element(hashtable->bloomFilter,
+								  (unsigned char *) &hashvalue,
+								  sizeof(hashvalue));
+
 			bucketNumber = ExecHashGetSkewBucket(hashtable, hashvalue);
 			if (bucketNumber != INVALID_SKEW_BUCKET_NO)
 			{
@@ -200,6 +230,72 @@ MultiExecPrivateHash(HashState *node)
 		hashtable->spacePeak = hashtable->spaceUsed;
 
 	hashtable->partialTuples = hashtable->totalTuples;
+
+	/*
+	 * If the inner side turned out much bigger than estimated, the filter is
+	 * too full to reject much; don't bother checking it.
+	 */
+	if (hashtable->bloomFilter &&
+		bloom_prop_bits_set(hashtable->bloomFilter) > HJ_BLOOM_MAX_FILL)
+		ExecHashFreeBloomFilter(hashtable);
+}
+
+/*
+ * Set up a Bloom filter for the hash values of the inner relation, if it
+ * looks large enough for probing the hash table to be expensive.
+ *
+ * The filter lives in hashCxt, and is limited to a quarter of spaceAllowed.
+ * It is counted in spaceUsed for as long as it exists, so it takes its share
+ * of work_mem away from the hash table.
+ */
+static void
+ExecHashInitBloomFilter(HashState *node)
+{
+	HashJoinTable hashtable = node->hashtable;
+	Plan	   *outerNode = outerPlanState(node)->plan;
+	double		rows = outerNode->plan_rows;
+	double		tablesize;
+	uint64		nbits;
+	uint64		maxbits;
+	MemoryContext oldcxt;
+
+	if (!enable_hashjoin_bloom)
+		return;
+
+	tablesize = rows * (MAXALIGN(outerNode->plan_width) +
+						HJTUPLE_OVERHEAD + sizeof(HashJoinTuple));
+	if (tablesize < HJ_BLOOM_MIN_TABLE_SIZE)
+		return;
+
+	/*
+	 * Power of 2 between 1kB worth of bits and a quarter of spaceAllowed.
+	 * bloom_create_fixed() accepts at most 2^32 bits, so clamp the size in
+	 * bytes before converting it to bits.
+	 */
+	maxbits = Min((uint64) hashtable->spaceAllowed / 4,
+				  ((uint64) PG_UINT32_MAX + 1) / BITS_PER_BYTE) * BITS_PER_BYTE;
+	nbits = 1024 * BITS_PER_BYTE;
+	while (nbits < rows * HJ_BLOOM_BITS_PER_TUPLE && nbits * 2 <= maxbits)
+		nbits *= 2;
+
+	oldcxt = MemoryContextSwitchTo(hashtable->hashCxt);
+	hashtable->bloomFilter = bloom_create_fixed(nbits, (int64) rows, 0);
+	MemoryContextSwitchTo(oldcxt);
+
+	hashtable->spaceUsed += bloom_size(hashtable->bloomFilter);
+	if (hashtable->spaceUsed > hashtable->spacePeak)
+		hashtable->spacePeak = hashtable->spaceUsed;
+}
+
+/*
+ * Discard the Bloom filter, and stop counting its memory in spaceUsed.
+ */
+static void
+ExecHashFreeBloomFilter(HashJoinTable hashtable)
+{
+	hashtable->spaceUsed -= bloom_size(hashtable->bloomFilter);
+	bloom_free(hashtable->bloomFilter);
+	hashtable->bloomFilter = NULL;
 }
 
 /* ----------------------------------------------------------------
@@ -507,6 +603,9 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 	hashtable->spaceUsedSkew = 0;
 	hashtable->spaceAllowedSkew =
 		hashtable->spaceAllowed * SKEW_WORK_MEM_PERCENT / 100;
+	hashtable->bloomFilter = NULL;
+	hashtable->bloomProbes = 0;
+	hashtable->bloomRejected = 0;
 	hashtable->chunks = NULL;
 	hashtable->current_chunk = NULL;
 	hashtable->parallel_state = state->parallel_state;
@@ -1579,6 +1678,42 @@ ExecParallelHashIncreaseNumBuckets(HashJoinTable hashtable)
 	}
 }
 
+/*
+ * ExecHashTableMightMatch
+ *		check whether an outer tuple with the given hash value could have a
+ *		match in the inner relation, as far as the Bloom filter can tell
+ *
+ * Returns true if there's no filter.  The filter is discarded if it turns out
+ * to reject too few outer tuples to be worth checking.
+ */
+bool
+ExecHashTableMightMatch(HashJoinTable hashtable, uint32 hashvalue)
+{
+	bloom_filter *filter = hashtable->bloomFilter;
+
+	if (filter == NULL)
+		return true;
+
+	if (hashtable->bloomProbes > 0 &&
+		hashtable->bloomProbes % HJ_BLOOM_CHECK_INTERVAL == 0 &&
+		hashtable->bloomRejected <
+		hashtable->bloomProbes * HJ_BLOOM_MIN_REJECT)
+	{
+		ExecHashFreeBloomFilter(hashtable);
+		return true;
+	}
+
+	hashtable->bloomProbes++;
+	if (bloom_lacks_element(filter, (unsigned char *) &hashvalue,
+							sizeof(hashvalue)))
+	{
+		hashtable->bloomRejected++;
+		return false;
+	}
+
+	return true;
+}
+
 /*
  * ExecHashTableInsert
  *		insert a tuple into the hash table depending on the hash value
@@ -1709,6 +1844,7 @@ retry:
 		/* Store the hash value in the HashJoinTuple header. */
 		hashTuple->hashvalue = hashvalue;
 		memcpy(HJTUPLE_MINTUPLE(hashTuple), tuple, tuple->t_len);
+		HeapTupleHeaderClearMatch(HJTUPLE_MINTUPLE(hashTuple));
 
 		/* Push it onto the front of the bucket's list */
 		ExecParallelHashPushTuple(&hashtable->buckets.shared[bucketno],
@@ -2056,6 +2192,74 @@ ExecPrepHashTableForUnmatched(HashJoinState *hjstate)
 	hjstate->hj_CurTuple = NULL;
 }
 
+/*
+ * ExecParallelPrepHashTableForUnmatched
+ *		set up for a series of ExecParallelScanHashTableForUnmatched calls
+ *
+ * Decide whether this participant should scan the current batch for
+ * unmatched inner tuples.  Only the last participant to finish probing may
+ * do so, because it is only safe once all others have stopped setting match
+ * bits.  Since a participant can't wait for the others here without risking
+ * deadlock, the others detach from the batch instead, leaving the last one
+ * to carry on alone.  Returns true if the caller should scan.
+ */
+bool
+ExecParallelPrepHashTableForUnmatched(HashJoinState *hjstate)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	int			curbatch = hashtable->curbatch;
+	ParallelHashJoinBatch *batch = hashtable->batches[curbatch].shared;
+
+	Assert(BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_PROBING);
+
+	/*
+	 * It would not be deadlock-free to wait on the batch barrier, because it
+	 * is in PHJ_BATCH_PROBING phase, and thus processes attached to it have
+	 * already emitted tuples.  Therefore, we'll hold a wait-free election:
+	 * only one process can continue to the next phase, and all others detach
+	 * from this batch.  They can still go and work on other batches, if there
+	 * are any.
+	 */
+	if (!BarrierArriveAndDetachExceptLast(&batch->batch_barrier))
+	{
+		/* This process considers the batch to be done. */
+		hashtable->batches[hashtable->curbatch].done = true;
+
+		/* Make sure any temporary files are closed. */
+		sts_end_parallel_scan(hashtable->batches[curbatch].inner_tuples);
+		sts_end_parallel_scan(hashtable->batches[curbatch].outer_tuples);
+
+		/*
+		 * Track largest batch we've seen, which would normally happen in
+		 * ExecHashTableDetachBatch().
+		 */
+		hashtable->spacePeak =
+			Max(hashtable->spacePeak,
+				batch->size + sizeof(dsa_pointer_atomic) * hashtable->nbuckets);
+		hashtable->curbatch = -1;
+		return false;
+	}
+
+	/* Now we are alone with this batch. */
+	Assert(BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_SCANNING);
+
+	/*
+	 * Has another process decided to give up early and command all processes
+	 * to skip the unmatched scan?
+	 */
+	if (batch->skip_unmatched)
+	{
+		hashtable->batches[hashtable->curbatch].done = true;
+		ExecHashTableDetachBatch(hashtable);
+		return false;
+	}
+
+	/* Now prepare the process local state, just as for non-parallel join. */
+	ExecPrepHashTableForUnmatched(hjstate);
+
+	return true;
+}
+
 /*
  * ExecScanHashTableForUnmatched
  *		scan the hash table for unmatched inner tuples
@@ -2130,6 +2334,72 @@ ExecScanHashTableForUnmatched(HashJoinState *hjstate, ExprContext *econtext)
 	return false;
 }
 
+/*
+ * ExecParallelScanHashTableForUnmatched
+ *		scan the hash table for unmatched inner tuples, in parallel join
+ *
+ * On success, the inner tuple is stored into hjstate->hj_CurTuple and
+ * econtext->ecxt_innertuple, using hjstate->hj_HashTupleSlot as the slot
+ * for the latter.
+ */
+bool
+ExecParallelScanHashTableForUnmatched(HashJoinState *hjstate,
+									  ExprContext *econtext)
+{
+	HashJoinTable hashtable = hjstate->hj_HashTable;
+	HashJoinTuple hashTuple = hjstate->hj_CurTuple;
+
+	for (;;)
+	{
+		/*
+		 * hj_CurTuple is the address of the tuple last returned from the
+		 * current bucket, or NULL if it's time to start scanning a new
+		 * bucket.  Parallel hash tables have no skew buckets.
+		 */
+		if (hashTuple != NULL)
+			hashTuple = ExecParallelHashNextTuple(hashtable, hashTuple);
+		else if (hjstate->hj_CurBucketNo < hashtable->nbuckets)
+			hashTuple = ExecParallelHashFirstTuple(hashtable,
+												   hjstate->hj_CurBucketNo++);
+		else
+			break;				/* finished all buckets */
+
+		while (hashTuple != NULL)
+		{
+			if (!HeapTupleHeaderHasMatch(HJTUPLE_MINTUPLE(hashTuple)))
+			{
+				TupleTableSlot *inntuple;
+
+				/* insert hashtable's tuple into exec slot */
+				inntuple = ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(hashTuple),
+												 hjstate->hj_HashTupleSlot,
+												 false);	/* do not pfree */
+				econtext->ecxt_innertuple = inntuple;
+
+				/*
+				 * Reset temp memory each time; although this function doesn't
+				 * do any qual eval, the caller will, so let's keep it
+				 * parallel to ExecScanHashBucket.
+				 */
+				ResetExprContext(econtext);
+
+				hjstate->hj_CurTuple = hashTuple;
+				return true;
+			}
+
+			hashTuple = ExecParallelHashNextTuple(hashtable, hashTuple);
+		}
+
+		/* allow this loop to be cancellable */
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	/*
+	 * no more unmatched tuples
+	 */
+	return false;
+}
+
 /*
  * ExecHashTableReset
  *
@@ -2152,6 +2422,16 @@ ExecHashTableReset(HashJoinTable hashtable)
 	hashtable->buckets.unshared = (HashJoinTuple *)
 		palloc0(nbuckets * sizeof(HashJoinTuple));
 
+	/*
+	 * The Bloom filter is only checked for outer tuples of the first batch,
+	 * so there's no point keeping it around any longer.
+	 */
+	if (hashtable->bloomFilter)
+	{
+		bloom_free(hashtable->bloomFilter);
+		hashtable->bloomFilter = NULL;
+	}
+
 	hashtable->spaceUsed = 0;
 
 	MemoryContextSwitchTo(oldcxt);
@@ -2671,6 +2951,8 @@ ExecHashGetInstrumentation(HashInstrumentation *instrument,
 	instrument->nbatch = hashtable->nbatch;
 	instrument->nbatch_original = hashtable->nbatch_original;
 	instrument->space_peak = hashtable->spacePeak;
+	instrument->bloom_probes = hashtable->bloomProbes;
+	instrument->bloom_rejected = hashtable->bloomRejected;
 }
 
 /*
@@ -3093,13 +3375,39 @@ ExecHashTableDetachBatch(HashJoinTable hashtable)
 	{
 		int			curbatch = hashtable->curbatch;
 		ParallelHashJoinBatch *batch = hashtable->batches[curbatch].shared;
+		bool		attached = true;
 
 		/* Make sure any temporary files are closed. */
 		sts_end_parallel_scan(hashtable->batches[curbatch].inner_tuples);
 		sts_end_parallel_scan(hashtable->batches[curbatch].outer_tuples);
 
-		/* Detach from the batch we were last working on. */
-		if (BarrierArriveAndDetach(&batch->batch_barrier))
+		/* After attaching we always get at least to PHJ_BATCH_PROBING. */
+		Assert(BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_PROBING ||
+			   BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_SCANNING);
+
+		/*
+		 * If we're abandoning the PHJ_BATCH_PROBING phase early without having
+		 * reached the end of it, it means the plan doesn't want any more
+		 * tuples, and it is happy to abandon any tuples buffered in this
+		 * process's subplans.  For correctness, we can't allow any process to
+		 * execute the PHJ_BATCH_SCANNING phase, because we will never have the
+		 * complete set of match bits.  Therefore we skip emitting unmatched
+		 * tuples in all backends (if this is a full/right join), as if those
+		 * tuples were all due to be emitted by this process and it has
+		 * abandoned them too.
+		 */
+		if (BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_PROBING &&
+			!hashtable->batches[curbatch].outer_eof)
+			batch->skip_unmatched = true;
+
+		/*
+		 * Even if we aren't doing a full/right outer join, we'll step through
+		 * the PHJ_BATCH_SCANNING phase just to maintain the invariant that
+		 * freeing happens in PHJ_BATCH_DONE phase.
+		 */
+		if (BarrierPhase(&batch->batch_barrier) == PHJ_BATCH_PROBING)
+			attached = BarrierArriveAndDetachExceptLast(&batch->batch_barrier);
+		if (attached && BarrierArriveAndDetach(&batch->batch_barrier))
 		{
 			/*
 			 * Technically we shouldn't access the barrier because we're no
@@ -3241,6 +3549,7 @@ ExecParallelHashTableSetCurrentBatch(HashJoinTable hashtable, int batchno)
 	hashtable->current_chunk = NULL;
 	hashtable->current_chunk_shared = InvalidDsaPointer;
 	hashtable->batches[batchno].at_least_one_chunk = false;
+	hashtable->batches[batchno].outer_eof = false;
 }
 
 /*
@@ -196,7 +196,8 @@ ExecInitRecursiveUnion(RecursiveUnion *node, EState *estate, int eflags)
 	 * If hashing, we need a per-tuple memory context for comparisons, and a
 	 * longer-lived context to store the hash table.  The table can't just be
 	 * kept in the per-query context because we want to be able to throw it
-	 * away when rescanning.
+	 * away when rescanning.  Hash table entries are never freed individually,
+	 * so the latter can be a bump context.
 	 */
 	if (node->numCols > 0)
 	{
@@ -205,9 +206,9 @@ ExecInitRecursiveUnion(RecursiveUnion *node, EState *estate, int eflags)
 								  "RecursiveUnion",
 								  ALLOCSET_DEFAULT_SIZES);
 		rustate->tableContext =
-			AllocSetContextCreate(CurrentMemoryContext,
-								  "RecursiveUnion hash table",
-								  ALLOCSET_DEFAULT_SIZES);
+			BumpContextCreate(CurrentMemoryContext,
+							  "RecursiveUnion hash table",
+							  ALLOCSET_DEFAULT_SIZES);
 	}
 
 	/*
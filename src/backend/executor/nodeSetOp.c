@@ -511,13 +511,14 @@ ExecInitSetOp(SetOp *node, EState *estate, int eflags)
 	/*
 	 * If hashing, we also need a longer-lived context to store the hash
 	 * table.  The table can't just be kept in the per-query context because
-	 * we want to be able to throw it away in ExecReScanSetOp.
+	 * we want to be able to throw it away in ExecReScanSetOp.  Entries are
+	 * never freed individually, so a bump context suffices.
 	 */
 	if (node->strategy == SETOP_HASHED)
 		setopstate->tableContext =
-			AllocSetContextCreate(CurrentMemoryContext,
-								  "SetOp hash table",
-								  ALLOCSET_DEFAULT_SIZES);
+			BumpContextCreate(CurrentMemoryContext,
+							  "SetOp hash table",
+							  ALLOCSET_DEFAULT_SIZES);
 
 	/*
 	 * initialize child nodes
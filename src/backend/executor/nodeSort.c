@@ -19,9 +19,16 @@
 #include "executor/execdebug.h"
 #include "executor/nodeSort.h"
 #include "miscadmin.h"
+#include "optimizer/optimizer.h"
+#include "pgstat.h"
 #include "utils/tuplesort.h"
 
 
+static void ExecSortParallelRun(SortState *node, TupleDesc tupDesc);
+static Tuplesortstate *ExecSortParallelLeader(SortState *node,
+											  TupleDesc tupDesc);
+
+
 /* ----------------------------------------------------------------
  *		ExecSort
  *
@@ -86,36 +93,55 @@ ExecSort(PlanState *pstate)
 		outerNode = outerPlanState(node);
 		tupDesc = ExecGetResultType(outerNode);
 
-		tuplesortstate = tuplesort_begin_heap(tupDesc,
-											  plannode->numCols,
-											  plannode->sortColIdx,
-											  plannode->sortOperators,
-											  plannode->collations,
-											  plannode->nullsFirst,
-											  work_mem,
-											  NULL, node->randomAccess);
-		if (node->bounded)
-			tuplesort_set_bound(tuplesortstate, node->bound);
-		node->tuplesortstate = (void *) tuplesortstate;
-
-		/*
-		 * Scan the subplan and feed all the tuples to tuplesort.
-		 */
-
-		for (;;)
+		if (node->pstate != NULL && node->am_worker)
 		{
-			slot = ExecProcNode(outerNode);
-
-			if (TupIsNull(slot))
-				break;
-
-			tuplesort_puttupleslot(tuplesortstate, slot);
+			/*
+			 * Parallel-aware sort in a worker: sort our share of the input
+			 * into a run for the leader to merge.  We return no tuples.
+			 */
+			ExecSortParallelRun(node, tupDesc);
+			tuplesortstate = NULL;
+		}
+		else if (node->pstate != NULL &&
+				 node->pcxt->nworkers_launched > 0)
+		{
+			/* Parallel-aware sort in the leader: merge all the runs */
+			tuplesortstate = ExecSortParallelLeader(node, tupDesc);
+			node->tuplesortstate = (void *) tuplesortstate;
+		}
+		else
+		{
+			tuplesortstate = tuplesort_begin_heap(tupDesc,
+												  plannode->numCols,
+												  plannode->sortColIdx,
+												  plannode->sortOperators,
+												  plannode->collations,
+												  plannode->nullsFirst,
+												  work_mem,
+												  NULL, node->randomAccess);
+			if (node->bounded)
+				tuplesort_set_bound(tuplesortstate, node->bound);
+			node->tuplesortstate = (void *) tuplesortstate;
+
+			/*
+			 * Scan the subplan and feed all the tuples to tuplesort.
+			 */
+
+			for (;;)
+			{
+				slot = ExecProcNode(outerNode);
+
+				if (TupIsNull(slot))
+					break;
+
+				tuplesort_puttupleslot(tuplesortstate, slot);
+			}
+
+			/*
+			 * Complete the sort.
+			 */
+			tuplesort_performsort(tuplesortstate);
 		}
-
-		/*
-		 * Complete the sort.
-		 */
-		tuplesort_performsort(tuplesortstate);
 
 		/*
 		 * restore to user specified direction
@@ -128,7 +154,7 @@ ExecSort(PlanState *pstate)
 		node->sort_Done = true;
 		node->bounded_Done = node->bounded;
 		node->bound_Done = node->bound;
-		if (node->shared_info && node->am_worker)
+		if (node->shared_info && node->am_worker && node->pstate == NULL)
 		{
 			TuplesortInstrumentation *si;
 
@@ -149,6 +175,8 @@ ExecSort(PlanState *pstate)
 	 * next fetch from the tuplesort.
 	 */
 	slot = node->ss.ps.ps_ResultTupleSlot;
+	if (tuplesortstate == NULL)
+		return ExecClearTuple(slot);
 	(void) tuplesort_gettupleslot(tuplesortstate,
 								  ScanDirectionIsForward(dir),
 								  false, slot, NULL);
@@ -191,6 +219,13 @@ ExecInitSort(Sort *node, EState *estate, int eflags)
 	sortstate->sort_Done = false;
 	sortstate->tuplesortstate = NULL;
 
+	/*
+	 * A parallel-aware sort's output is produced by merging runs on shared
+	 * tapes, which doesn't support random access.  Rescans re-sort instead.
+	 */
+	if (node->plan.parallel_aware)
+		sortstate->randomAccess = false;
+
 	/*
 	 * Miscellaneous initialization
 	 *
@@ -346,23 +381,166 @@ ExecReScanSort(SortState *node)
  * ----------------------------------------------------------------
  */
 
+/* ----------------------------------------------------------------
+ *		ExecSortParallelRun
+ *
+ *		Sort this participant's share of the input of a parallel-aware
+ *		sort into a single run on the shared tapes, and tell the leader
+ *		we're done.
+ * ----------------------------------------------------------------
+ */
+static void
+ExecSortParallelRun(SortState *node, TupleDesc tupDesc)
+{
+	Sort	   *plannode = (Sort *) node->ss.ps.plan;
+	PlanState  *outerNode = outerPlanState(node);
+	ParallelSortState *pstate = node->pstate;
+	SortCoordinate coordinate;
+	Tuplesortstate *tuplesortstate;
+	TupleTableSlot *slot;
+
+	coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = true;
+	coordinate->nParticipants = -1;
+	coordinate->sharedsort = node->sharedsort;
+
+	tuplesortstate = tuplesort_begin_heap(tupDesc,
+										  plannode->numCols,
+										  plannode->sortColIdx,
+										  plannode->sortOperators,
+										  plannode->collations,
+										  plannode->nullsFirst,
+										  work_mem,
+										  coordinate, false);
+
+	for (;;)
+	{
+		slot = ExecProcNode(outerNode);
+
+		if (TupIsNull(slot))
+			break;
+
+		tuplesort_puttupleslot(tuplesortstate, slot);
+	}
+
+	tuplesort_performsort(tuplesortstate);
+
+	if (node->shared_info && IsParallelWorker())
+	{
+		TuplesortInstrumentation *si;
+
+		Assert(ParallelWorkerNumber <= node->shared_info->num_workers);
+		si = &node->shared_info->sinstrument[ParallelWorkerNumber];
+		tuplesort_get_stats(tuplesortstate, si);
+	}
+
+	/* The run stays behind on the shared tapes */
+	tuplesort_end(tuplesortstate);
+	pfree(coordinate);
+
+	SpinLockAcquire(&pstate->mutex);
+	pstate->nparticipantsdone++;
+	SpinLockRelease(&pstate->mutex);
+
+	ConditionVariableSignal(&pstate->workersdonecv);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecSortParallelLeader
+ *
+ *		Produce the output of a parallel-aware sort in the leader, by
+ *		merging the runs of all participants once they are done.  The
+ *		leader sorts a share of the input itself first, unless
+ *		parallel_leader_participation is off.
+ * ----------------------------------------------------------------
+ */
+static Tuplesortstate *
+ExecSortParallelLeader(SortState *node, TupleDesc tupDesc)
+{
+	Sort	   *plannode = (Sort *) node->ss.ps.plan;
+	ParallelSortState *pstate = node->pstate;
+	int			nparticipants;
+	SortCoordinate coordinate;
+	Tuplesortstate *tuplesortstate;
+
+	nparticipants = node->pcxt->nworkers_launched;
+	Assert(nparticipants > 0);
+
+	/*
+	 * Make sure that all launched workers actually started, or we'd wait
+	 * forever for their runs below.
+	 */
+	WaitForParallelWorkersToAttach(node->pcxt);
+
+	if (parallel_leader_participation)
+	{
+		ExecSortParallelRun(node, tupDesc);
+		nparticipants++;
+	}
+
+	for (;;)
+	{
+		SpinLockAcquire(&pstate->mutex);
+		if (pstate->nparticipantsdone == nparticipants)
+		{
+			SpinLockRelease(&pstate->mutex);
+			break;
+		}
+		SpinLockRelease(&pstate->mutex);
+
+		ConditionVariableSleep(&pstate->workersdonecv,
+							   WAIT_EVENT_PARALLEL_SORT);
+	}
+	ConditionVariableCancelSleep();
+
+	coordinate = (SortCoordinate) palloc0(sizeof(SortCoordinateData));
+	coordinate->isWorker = false;
+	coordinate->nParticipants = nparticipants;
+	coordinate->sharedsort = node->sharedsort;
+
+	tuplesortstate = tuplesort_begin_heap(tupDesc,
+										  plannode->numCols,
+										  plannode->sortColIdx,
+										  plannode->sortOperators,
+										  plannode->collations,
+										  plannode->nullsFirst,
+										  work_mem,
+										  coordinate, false);
+	tuplesort_performsort(tuplesortstate);
+
+	return tuplesortstate;
+}
+
 /* ----------------------------------------------------------------
  *		ExecSortEstimate
  *
- *		Estimate space required to propagate sort statistics.
+ *		Estimate space required to propagate sort statistics, and for a
+ *		parallel-aware sort, to coordinate it.
  * ----------------------------------------------------------------
  */
 void
 ExecSortEstimate(SortState *node, ParallelContext *pcxt)
 {
-	Size		size;
+	Size		size = 0;
+
+	if (node->ss.ps.plan->parallel_aware)
+	{
+		/* one tape per worker, plus one for the leader */
+		size = MAXALIGN(sizeof(ParallelSortState));
+		size = add_size(size, tuplesort_estimate_shared(pcxt->nworkers + 1));
+	}
+
+	/* don't need instrumentation if not instrumenting or no workers */
+	if (node->ss.ps.instrument && pcxt->nworkers > 0)
+	{
+		size = add_size(size, mul_size(pcxt->nworkers,
+									   sizeof(TuplesortInstrumentation)));
+		size = add_size(size, offsetof(SharedSortInfo, sinstrument));
+	}
 
-	/* don't need this if not instrumenting or no workers */
-	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
+	if (size == 0)
 		return;
 
-	size = mul_size(pcxt->nworkers, sizeof(TuplesortInstrumentation));
-	size = add_size(size, offsetof(SharedSortInfo, sinstrument));
 	shm_toc_estimate_chunk(&pcxt->estimator, size);
 	shm_toc_estimate_keys(&pcxt->estimator, 1);
 }
@@ -370,39 +548,107 @@ ExecSortEstimate(SortState *node, ParallelContext *pcxt)
 /* ----------------------------------------------------------------
  *		ExecSortInitializeDSM
  *
- *		Initialize DSM space for sort statistics.
+ *		Initialize DSM space for sort statistics, and for a parallel-aware
+ *		sort, the shared tuplesort state.
  * ----------------------------------------------------------------
  */
 void
 ExecSortInitializeDSM(SortState *node, ParallelContext *pcxt)
 {
-	Size		size;
+	Size		pstate_size = 0;
+	Size		instr_size = 0;
+	char	   *chunk;
 
-	/* don't need this if not instrumenting or no workers */
-	if (!node->ss.ps.instrument || pcxt->nworkers == 0)
+	if (node->ss.ps.plan->parallel_aware)
+		pstate_size = MAXALIGN(sizeof(ParallelSortState)) +
+			tuplesort_estimate_shared(pcxt->nworkers + 1);
+
+	/* don't need instrumentation if not instrumenting or no workers */
+	if (node->ss.ps.instrument && pcxt->nworkers > 0)
+		instr_size = offsetof(SharedSortInfo, sinstrument)
+			+ pcxt->nworkers * sizeof(TuplesortInstrumentation);
+
+	if (pstate_size + instr_size == 0)
 		return;
 
-	size = offsetof(SharedSortInfo, sinstrument)
-		+ pcxt->nworkers * sizeof(TuplesortInstrumentation);
-	node->shared_info = shm_toc_allocate(pcxt->toc, size);
-	/* ensure any unfilled slots will contain zeroes */
-	memset(node->shared_info, 0, size);
-	node->shared_info->num_workers = pcxt->nworkers;
-	shm_toc_insert(pcxt->toc, node->ss.ps.plan->plan_node_id,
-				   node->shared_info);
+	chunk = shm_toc_allocate(pcxt->toc, pstate_size + instr_size);
+
+	if (pstate_size > 0)
+	{
+		ParallelSortState *pstate = (ParallelSortState *) chunk;
+
+		SpinLockInit(&pstate->mutex);
+		pstate->nparticipantsdone = 0;
+		ConditionVariableInit(&pstate->workersdonecv);
+		pstate->instr_offset = (instr_size > 0) ? pstate_size : 0;
+
+		node->pstate = pstate;
+		node->sharedsort = (Sharedsort *)
+			(chunk + MAXALIGN(sizeof(ParallelSortState)));
+		tuplesort_initialize_shared(node->sharedsort, pcxt->nworkers + 1,
+									pcxt->seg);
+		node->pcxt = pcxt;
+	}
+
+	if (instr_size > 0)
+	{
+		node->shared_info = (SharedSortInfo *) (chunk + pstate_size);
+		/* ensure any unfilled slots will contain zeroes */
+		memset(node->shared_info, 0, instr_size);
+		node->shared_info->num_workers = pcxt->nworkers;
+	}
+
+	shm_toc_insert(pcxt->toc, node->ss.ps.plan->plan_node_id, chunk);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecSortReInitializeDSM
+ *
+ *		Reset shared state before beginning a fresh parallel-aware sort.
+ * ----------------------------------------------------------------
+ */
+void
+ExecSortReInitializeDSM(SortState *node, ParallelContext *pcxt)
+{
+	/* The previous sort's tapes must be released before deleting them */
+	if (node->tuplesortstate != NULL)
+	{
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+		node->tuplesortstate = NULL;
+	}
+	node->sort_Done = false;
+
+	tuplesort_reset_shared(node->sharedsort);
+	node->pstate->nparticipantsdone = 0;
 }
 
 /* ----------------------------------------------------------------
  *		ExecSortInitializeWorker
  *
- *		Attach worker to DSM space for sort statistics.
+ *		Attach worker to DSM space for sort statistics, and for a
+ *		parallel-aware sort, to the shared tuplesort state.
  * ----------------------------------------------------------------
  */
 void
 ExecSortInitializeWorker(SortState *node, ParallelWorkerContext *pwcxt)
 {
-	node->shared_info =
-		shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, true);
+	if (node->ss.ps.plan->parallel_aware)
+	{
+		ParallelSortState *pstate;
+
+		pstate = shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id,
+								false);
+		node->pstate = pstate;
+		node->sharedsort = (Sharedsort *)
+			((char *) pstate + MAXALIGN(sizeof(ParallelSortState)));
+		tuplesort_attach_shared(node->sharedsort, pwcxt->seg);
+		if (pstate->instr_offset != 0)
+			node->shared_info = (SharedSortInfo *)
+				((char *) pstate + pstate->instr_offset);
+	}
+	else
+		node->shared_info =
+			shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, true);
 	node->am_worker = true;
 }
 
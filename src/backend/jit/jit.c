@@ -36,9 +36,11 @@ bool		jit_dump_bitcode = false;
 bool		jit_expressions = true;
 bool		jit_profiling_support = false;
 bool		jit_tuple_deforming = true;
+bool		jit_deform_cache = true;
 double		jit_above_cost = 100000;
 double		jit_inline_above_cost = 500000;
 double		jit_optimize_above_cost = 500000;
+int			jit_expr_threshold = 0;
 
 static JitProviderCallbacks provider;
 static bool provider_successfully_loaded = false;
@@ -179,11 +181,32 @@ jit_compile_expr(struct ExprState *state)
 	return false;
 }
 
+/*
+ * Should JIT compilation of the expression be deferred until it has been
+ * evaluated jit_expr_threshold times?  If so, the caller is expected to
+ * interpret the expression until then, and call jit_compile_expr() later.
+ */
+bool
+jit_defer_expr(struct ExprState *state)
+{
+	int			flags;
+
+	/* same restrictions as in jit_compile_expr() */
+	if (!state->parent)
+		return false;
+
+	flags = state->parent->state->es_jit_flags;
+
+	return (flags & PGJIT_PERFORM) && (flags & PGJIT_EXPR) &&
+		(flags & PGJIT_DEFER);
+}
+
 /* Aggregate JIT instrumentation information */
 void
 InstrJitAgg(JitInstrumentation *dst, JitInstrumentation *add)
 {
 	dst->created_functions += add->created_functions;
+	dst->deferred_exprs += add->deferred_exprs;
 	INSTR_TIME_ADD(dst->generation_counter, add->generation_counter);
 	INSTR_TIME_ADD(dst->inlining_counter, add->inlining_counter);
 	INSTR_TIME_ADD(dst->optimization_counter, add->optimization_counter);
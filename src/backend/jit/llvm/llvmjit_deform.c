@@ -25,6 +25,62 @@
 #include "executor/tuptable.h"
 #include "jit/llvmjit.h"
 #include "jit/llvmjit_emit.h"
+#include "utils/hashutils.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+
+
+/*
+ * Deform functions only depend on the physical layout of the tuple
+ * descriptor, the slot type and the number of attributes to extract - unlike
+ * expressions, they don't embed any pointers into query-lifetime state.  So
+ * once a deform function has been emitted, later queries deforming tuples of
+ * the same shape can call the existing code, rather than generating,
+ * optimizing and emitting it again.  The cache is per backend, and emitted
+ * code stays around until backend exit.
+ *
+ * As the key is derived from the layout itself, rather than from the OID of a
+ * relation or type, there's no need for invalidation.
+ *
+ * A cached function lives in a module of its own and is called through its
+ * address, so it can't be inlined into the expression calling it.  When the
+ * expression is optimized, that inlining is worth more than the compile time
+ * saved, so the cache is only used for unoptimized expressions.
+ */
+#define DEFORM_CACHE_MAX_ENTRIES	1024
+
+/* per-attribute part of the cache key */
+typedef struct DeformCacheAttr
+{
+	int16		attlen;
+	char		attalign;
+	bool		attbyval;
+	bool		attnotnull;
+	bool		atthasmissing;
+	bool		attisdropped;
+} DeformCacheAttr;
+
+/* cache key, followed by DeformCacheAttr for each attribute of the desc */
+typedef struct DeformCacheKey
+{
+	const TupleTableSlotOps *ops;
+	int			natts;			/* number of attributes to deform */
+	int			desc_natts;		/* number of attributes in desc */
+} DeformCacheKey;
+
+typedef struct DeformCacheEntry
+{
+	uint32		hash;			/* hash of key, must be first */
+	Size		keylen;
+	char	   *key;			/* to detect hash collisions */
+	void	   *fn;				/* address of emitted function */
+} DeformCacheEntry;
+
+static HTAB *deform_cache = NULL;
+static List *deform_cache_handles = NIL;
+
+static void *emit_cached_deform(LLVMJitContext *context, TupleDesc desc,
+								const TupleTableSlotOps *ops, int natts);
 
 
 /*
@@ -754,3 +810,163 @@ slot_compile_deform(LLVMJitContext *context, TupleDesc desc,
 
 	return v_deform_fn;
 }
+
+/*
+ * Return a reference to a function deforming tuples of type desc up to natts
+ * columns, for use in the module currently being built for context.
+ *
+ * If jit_deform_cache is enabled and the module won't be optimized, the
+ * function is looked up in, or added to, the backend's cache of already
+ * emitted deform functions.  Otherwise, or if the cache can't be used, this is
+ * the same as slot_compile_deform(), which leaves the function in the module
+ * where the optimizer can inline it.
+ */
+LLVMValueRef
+slot_cached_deform(LLVMJitContext *context, TupleDesc desc,
+				   const TupleTableSlotOps *ops, int natts)
+{
+	DeformCacheKey *key;
+	DeformCacheAttr *attrs;
+	DeformCacheEntry *entry;
+	Size		keylen;
+	uint32		hash;
+	void	   *fn;
+	bool		found;
+	int			attnum;
+
+	/* only slot types slot_compile_deform() knows to handle */
+	if (!jit_deform_cache ||
+		(context->base.flags & PGJIT_OPT3) ||
+		(ops != &TTSOpsHeapTuple && ops != &TTSOpsBufferHeapTuple &&
+		 ops != &TTSOpsMinimalTuple))
+		return slot_compile_deform(context, desc, ops, natts);
+
+	/* build key from everything slot_compile_deform() looks at */
+	keylen = sizeof(DeformCacheKey) + sizeof(DeformCacheAttr) * desc->natts;
+	key = palloc0(keylen);
+	key->ops = ops;
+	key->natts = natts;
+	key->desc_natts = desc->natts;
+
+	attrs = (DeformCacheAttr *) (key + 1);
+	for (attnum = 0; attnum < desc->natts; attnum++)
+	{
+		Form_pg_attribute att = TupleDescAttr(desc, attnum);
+
+		attrs[attnum].attlen = att->attlen;
+		attrs[attnum].attalign = att->attalign;
+		attrs[attnum].attbyval = att->attbyval;
+		attrs[attnum].attnotnull = att->attnotnull;
+		attrs[attnum].atthasmissing = att->atthasmissing;
+		attrs[attnum].attisdropped = att->attisdropped;
+	}
+
+	hash = DatumGetUInt32(hash_any((unsigned char *) key, keylen));
+
+	if (deform_cache == NULL)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(uint32);
+		ctl.entrysize = sizeof(DeformCacheEntry);
+		deform_cache = hash_create("JIT deform cache", 64, &ctl,
+								   HASH_ELEM | HASH_BLOBS);
+	}
+
+	entry = (DeformCacheEntry *) hash_search(deform_cache, &hash,
+											 HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		/* on a hash collision, just don't use the cache */
+		if (entry->keylen != keylen || memcmp(entry->key, key, keylen) != 0)
+		{
+			pfree(key);
+			return slot_compile_deform(context, desc, ops, natts);
+		}
+		fn = entry->fn;
+	}
+	else
+	{
+		/* once full, behave as if there were no cache */
+		if (hash_get_num_entries(deform_cache) >= DEFORM_CACHE_MAX_ENTRIES)
+		{
+			pfree(key);
+			return slot_compile_deform(context, desc, ops, natts);
+		}
+
+		fn = emit_cached_deform(context, desc, ops, natts);
+
+		entry = (DeformCacheEntry *) hash_search(deform_cache, &hash,
+												 HASH_ENTER, &found);
+		Assert(!found);
+		entry->keylen = keylen;
+		entry->key = MemoryContextAlloc(TopMemoryContext, keylen);
+		memcpy(entry->key, key, keylen);
+		entry->fn = fn;
+	}
+
+	pfree(key);
+
+	/* reference the already emitted function by its address */
+	{
+		LLVMTypeRef param_types[1];
+		LLVMTypeRef deform_sig;
+
+		param_types[0] = l_ptr(StructTupleTableSlot);
+		deform_sig = LLVMFunctionType(LLVMVoidType(), param_types,
+									  lengthof(param_types), 0);
+
+		return l_ptr_const(fn, l_ptr(deform_sig));
+	}
+}
+
+/*
+ * Generate and emit a deform function in a module of its own, so it can
+ * outlive context.  Returns the address of the function.
+ */
+static void *
+emit_cached_deform(LLVMJitContext *context, TupleDesc desc,
+				   const TupleTableSlotOps *ops, int natts)
+{
+	LLVMJitContext deform_context;
+	LLVMValueRef v_deform_fn;
+	MemoryContext oldcontext;
+	char	   *funcname;
+	void	   *fn;
+
+	/*
+	 * Use a throwaway context with the same flags.  It's not registered with
+	 * a resource owner, so its emitted code isn't released with the query.
+	 */
+	memset(&deform_context, 0, sizeof(LLVMJitContext));
+	deform_context.base.flags = context->base.flags;
+
+	v_deform_fn = slot_compile_deform(&deform_context, desc, ops, natts);
+	Assert(v_deform_fn != NULL);
+
+	/* has to be visible to be looked up, and to survive optimization */
+	LLVMSetLinkage(v_deform_fn, LLVMExternalLinkage);
+	funcname = pstrdup(LLVMGetValueName(v_deform_fn));
+
+	fn = llvm_get_function(&deform_context, funcname);
+	pfree(funcname);
+
+	/* the time spent is still accounted to the query that caused it */
+	context->base.instr.created_functions +=
+		deform_context.base.instr.created_functions;
+	INSTR_TIME_ADD(context->base.instr.inlining_counter,
+				   deform_context.base.instr.inlining_counter);
+	INSTR_TIME_ADD(context->base.instr.optimization_counter,
+				   deform_context.base.instr.optimization_counter);
+	INSTR_TIME_ADD(context->base.instr.emission_counter,
+				   deform_context.base.instr.emission_counter);
+
+	/* keep the handles, the code has to stay around */
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+	deform_cache_handles = list_concat(deform_cache_handles,
+									   deform_context.handles);
+	MemoryContextSwitchTo(oldcontext);
+
+	return fn;
+}
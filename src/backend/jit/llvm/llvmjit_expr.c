@@ -320,9 +320,9 @@ llvm_compile_expr(ExprState *state)
 					if (tts_ops && desc && (context->base.flags & PGJIT_DEFORM))
 					{
 						l_jit_deform =
-							slot_compile_deform(context, desc,
-												tts_ops,
-												op->d.fetch.last_var);
+							slot_cached_deform(context, desc,
+											   tts_ops,
+											   op->d.fetch.last_var);
 					}
 
 					if (l_jit_deform)
@@ -562,6 +562,8 @@ llvm_compile_expr(ExprState *state)
 				}
 
 			case EEOP_FUNCEXPR_STRICT:
+			case EEOP_FUNCEXPR_STRICT_1:
+			case EEOP_FUNCEXPR_STRICT_2:
 				{
 					FunctionCallInfo fcinfo = op->d.func.fcinfo_data;
 					LLVMBasicBlockRef b_nonull;
@@ -120,6 +120,71 @@ bloom_create(int64 total_elems, int bloom_work_mem, uint64 seed)
 	return filter;
 }
 
+/*
+ * Create a Bloom filter with a bitset of exactly bitset_bits bits, in caller's
+ * memory context.
+ *
+ * This is for callers that need small filters, below the 1MB floor that
+ * bloom_create() imposes, such as filters that are stored inside index
+ * tuples.  bitset_bits must be a power of two.  The number of hash functions
+ * is chosen based on caller's total_elems estimate, as in bloom_create().
+ *
+ * The filter is a single flat chunk of bloom_size() bytes, so callers may
+ * copy it byte-for-byte to store it and copy it back into suitably aligned
+ * memory to use it again.
+ */
+bloom_filter *
+bloom_create_fixed(uint64 bitset_bits, int64 total_elems, uint64 seed)
+{
+	bloom_filter *filter;
+
+	Assert(bitset_bits >= BITS_PER_BYTE);
+	Assert(bitset_bits <= PG_UINT32_MAX + UINT64CONST(1));
+	Assert(((bitset_bits - 1) & bitset_bits) == 0);
+
+	filter = palloc0(offsetof(bloom_filter, bitset) +
+					 sizeof(unsigned char) * (bitset_bits / BITS_PER_BYTE));
+	filter->k_hash_funcs = optimal_k(bitset_bits, Max(total_elems, 1));
+	filter->seed = seed;
+	filter->m = bitset_bits;
+
+	return filter;
+}
+
+/*
+ * Total size of the Bloom filter, in bytes, including bookkeeping fields
+ */
+Size
+bloom_size(bloom_filter *filter)
+{
+	return offsetof(bloom_filter, bitset) +
+		sizeof(unsigned char) * (filter->m / BITS_PER_BYTE);
+}
+
+/*
+ * Merge the elements of Bloom filter src into dst.
+ *
+ * This is only possible when both filters were created with the same size,
+ * number of hash functions and seed.  Returns false, leaving dst untouched,
+ * if that's not the case.
+ */
+bool
+bloom_union(bloom_filter *dst, bloom_filter *src)
+{
+	uint64		bitset_bytes;
+	uint64		i;
+
+	if (dst->m != src->m || dst->k_hash_funcs != src->k_hash_funcs ||
+		dst->seed != src->seed)
+		return false;
+
+	bitset_bytes = dst->m / BITS_PER_BYTE;
+	for (i = 0; i < bitset_bytes; i++)
+		dst->bitset[i] |= src->bitset[i];
+
+	return true;
+}
+
 /*
  * Free Bloom filter
  */
@@ -137,6 +137,7 @@ bool		enable_partitionwise_join = false;
 bool		enable_partitionwise_aggregate = false;
 bool		enable_parallel_append = true;
 bool		enable_parallel_hash = true;
+bool		enable_parallel_sort = true;
 bool		enable_partition_pruning = true;
 
 typedef struct
@@ -432,23 +433,35 @@ cost_gather_merge(GatherMergePath *path, PlannerInfo *root,
 	/* Assumed cost per tuple comparison */
 	comparison_cost = 2.0 * cpu_operator_cost;
 
-	/* Heap creation cost */
-	startup_cost += comparison_cost * N * logN;
-
-	/* Per-tuple heap maintenance cost */
-	run_cost += path->path.rows * comparison_cost * logN;
-
-	/* small cost for heap management, like cost_merge_append */
-	run_cost += cpu_operator_cost * path->path.rows;
+	startup_cost += parallel_setup_cost;
 
 	/*
-	 * Parallel setup and communication cost.  Since Gather Merge, unlike
-	 * Gather, requires us to block until a tuple is available from every
-	 * worker, we bump the IPC cost up a little bit as compared with Gather.
-	 * For lack of a better idea, charge an extra 5%.
+	 * A parallel-aware Sort returns all of its tuples, already merged, in the
+	 * leader.  There's nothing to merge or to receive from workers.
 	 */
-	startup_cost += parallel_setup_cost;
-	run_cost += parallel_tuple_cost * path->path.rows * 1.05;
+	if (IsA(path->subpath, SortPath) && path->subpath->parallel_aware)
+	{
+		run_cost += cpu_operator_cost * path->path.rows;
+	}
+	else
+	{
+		/* Heap creation cost */
+		startup_cost += comparison_cost * N * logN;
+
+		/* Per-tuple heap maintenance cost */
+		run_cost += path->path.rows * comparison_cost * logN;
+
+		/* small cost for heap management, like cost_merge_append */
+		run_cost += cpu_operator_cost * path->path.rows;
+
+		/*
+		 * Parallel communication cost.  Since Gather Merge, unlike Gather,
+		 * requires us to block until a tuple is available from every worker,
+		 * we bump the IPC cost up a little bit as compared with Gather.  For
+		 * lack of a better idea, charge an extra 5%.
+		 */
+		run_cost += parallel_tuple_cost * path->path.rows * 1.05;
+	}
 
 	path->path.startup_cost = startup_cost + input_startup_cost;
 	path->path.total_cost = (startup_cost + run_cost + input_total_cost);
@@ -1789,6 +1802,56 @@ cost_sort(Path *path, PlannerInfo *root,
 	path->total_cost = startup_cost + run_cost;
 }
 
+/*
+ * cost_parallel_sort
+ *	  Determines and returns the cost of a parallel-aware sort.
+ *
+ * Each participant sorts its share of the input into a single run on shared
+ * tapes, and the leader then merges the runs of all participants.  So on top
+ * of sorting one share, as estimated by cost_sort(), we charge for writing
+ * and reading back all the runs once, and for merging them.  The leader
+ * returns all of the tuples.
+ *
+ * 'tuples' is the number of input tuples per participant, 'total_tuples'
+ * the number of tuples in all.  Other arguments are as for cost_sort().
+ */
+void
+cost_parallel_sort(Path *path, PlannerInfo *root,
+				   List *pathkeys, Cost input_cost,
+				   double tuples, double total_tuples, int width,
+				   int parallel_workers, int sort_mem)
+{
+	Cost		startup_cost;
+	Cost		run_cost = 0;
+	Cost		comparison_cost;
+	double		npages;
+	double		nparticipants;
+
+	cost_sort(path, root, pathkeys, input_cost, tuples, width,
+			  0.0, sort_mem, -1.0);
+	startup_cost = path->startup_cost;
+
+	if (!enable_parallel_sort)
+		startup_cost += disable_cost;
+
+	/* Writing and reading back the runs is all sequential */
+	npages = ceil(relation_byte_size(total_tuples, width) / BLCKSZ);
+	startup_cost += 2.0 * npages * seq_page_cost;
+
+	/* Count the leader too, as cost_gather_merge does */
+	nparticipants = parallel_workers + 1;
+	comparison_cost = 2.0 * cpu_operator_cost;
+
+	/* The merge runs as tuples are fetched, like in cost_merge_append */
+	startup_cost += comparison_cost * nparticipants * LOG2(nparticipants);
+	run_cost += total_tuples * comparison_cost * LOG2(nparticipants);
+	run_cost += cpu_operator_cost * total_tuples;
+
+	path->rows = total_tuples;
+	path->startup_cost = startup_cost;
+	path->total_cost = startup_cost + run_cost;
+}
+
 /*
  * append_nonpartial_cost
  *	  Estimate the cost of the non-partial paths in a Parallel Append.
@@ -540,6 +540,13 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 	{
 		result->jitFlags |= PGJIT_PERFORM;
 
+		/*
+		 * With a threshold, expressions are only compiled once they turn out
+		 * to be evaluated often, rather than all before execution starts.
+		 */
+		if (jit_expr_threshold > 0)
+			result->jitFlags |= PGJIT_DEFER;
+
 		/*
 		 * Decide how much effort should be put into generating better code.
 		 */
@@ -5043,6 +5050,36 @@ create_ordered_paths(PlannerInfo *root,
 												path, target);
 
 			add_path(ordered_rel, path);
+
+			/*
+			 * If the input is too large to sort in memory anyway, also try a
+			 * parallel-aware sort, where the leader merges the workers'
+			 * sorted runs from disk rather than Gather Merge merging their
+			 * output streams.  It can't make use of a LIMIT.
+			 */
+			if (enable_parallel_sort && limit_tuples < 0 &&
+				total_groups * cheapest_partial_path->pathtarget->width >
+				work_mem * 1024.0)
+			{
+				path = (Path *) create_parallel_sort_path(root,
+														  ordered_rel,
+														  cheapest_partial_path,
+														  root->sort_pathkeys,
+														  total_groups);
+				path = (Path *)
+					create_gather_merge_path(root, ordered_rel,
+											 path,
+											 path->pathtarget,
+											 root->sort_pathkeys, NULL,
+											 &total_groups);
+
+				/* Add projection step if needed */
+				if (path->pathtarget != target)
+					path = apply_projection_to_path(root, ordered_rel,
+													path, target);
+
+				add_path(ordered_rel, path);
+			}
 		}
 	}
 
@@ -6235,7 +6272,8 @@ plan_cluster_use_sort(Oid tableOid, Oid indexOid)
  *		CREATE INDEX should request for use
  *
  * tableOid is the table on which the index is to be built.  indexOid is the
- * OID of an index to be created or reindexed (which must be a btree index).
+ * OID of an index to be created or reindexed (which must be a btree or GIN
+ * index).
  *
  * Return value is the number of parallel worker processes to request.  It
  * may be unsafe to proceed if this is 0.  Note that this does not include the
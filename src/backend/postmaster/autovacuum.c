@@ -65,6 +65,8 @@
 #include <sys/time.h>
 #include <unistd.h>
 
+#include "access/brin.h"
+#include "access/brin_internal.h"
 #include "access/heapam.h"
 #include "access/htup_details.h"
 #include "access/multixact.h"
@@ -74,6 +76,7 @@
 #include "access/xact.h"
 #include "catalog/dependency.h"
 #include "catalog/namespace.h"
+#include "catalog/pg_am.h"
 #include "catalog/pg_database.h"
 #include "commands/dbcommands.h"
 #include "commands/vacuum.h"
@@ -334,6 +337,8 @@ static void relation_needs_vacanalyze(Oid relid, AutoVacOpts *relopts,
 
 static void autovacuum_do_vac_analyze(autovac_table *tab,
 									  BufferAccessStrategy bstrategy);
+static bool brin_needs_summarization(HeapTuple tup, TupleDesc pg_class_desc,
+									 PgStat_StatTabEntry *tabentry);
 static AutoVacOpts *extract_autovac_opts(HeapTuple tup,
 										 TupleDesc pg_class_desc);
 static PgStat_StatTabEntry *get_pgstat_tabentry_relid(Oid relid, bool isshared,
@@ -2057,6 +2062,25 @@ do_autovacuum(void)
 		bool		doanalyze;
 		bool		wraparound;
 
+		/*
+		 * A BRIN index whose statistics still count unsummarized ranges may
+		 * have had summarization requests dropped because the work item
+		 * array was full.  Queue one covering the whole index; it is
+		 * processed along with the other work items below.
+		 */
+		if (classForm->relkind == RELKIND_INDEX &&
+			classForm->relam == BRIN_AM_OID &&
+			classForm->relpersistence != RELPERSISTENCE_TEMP)
+		{
+			tabentry = get_pgstat_tabentry_relid(classForm->oid,
+												 classForm->relisshared,
+												 shared, dbentry);
+			if (brin_needs_summarization(tuple, pg_class_desc, tabentry))
+				AutoVacuumRequestWork(AVW_BRINSummarizeRange, classForm->oid,
+									  InvalidBlockNumber);
+			continue;
+		}
+
 		if (classForm->relkind != RELKIND_RELATION &&
 			classForm->relkind != RELKIND_MATVIEW)
 			continue;
@@ -2655,6 +2679,10 @@ perform_work_item(AutoVacuumWorkItem *workitem)
 									ObjectIdGetDatum(workitem->avw_relation),
 									Int64GetDatum((int64) workitem->avw_blockNumber));
 				break;
+			case AVW_GINCleanPendingList:
+				DirectFunctionCall1(gin_clean_pending_list,
+									ObjectIdGetDatum(workitem->avw_relation));
+				break;
 			default:
 				elog(WARNING, "unrecognized work item found: type %d",
 					 workitem->avw_type);
@@ -2733,6 +2761,32 @@ extract_autovac_opts(HeapTuple tup, TupleDesc pg_class_desc)
 	return av;
 }
 
+/*
+ * brin_needs_summarization
+ *
+ * Check whether a BRIN index has autosummarization enabled and its pgstat
+ * entry counts any unsummarized page ranges.
+ */
+static bool
+brin_needs_summarization(HeapTuple tup, TupleDesc pg_class_desc,
+						 PgStat_StatTabEntry *tabentry)
+{
+	bytea	   *relopts;
+	bool		result;
+
+	if (tabentry == NULL || tabentry->n_unsummarized_ranges <= 0)
+		return false;
+
+	relopts = extractRelOptions(tup, pg_class_desc, brinoptions);
+	if (relopts == NULL)
+		return false;
+
+	result = ((BrinOptions *) relopts)->autosummarize;
+	pfree(relopts);
+
+	return result;
+}
+
 /*
  * get_pgstat_tabentry_relid
  *
@@ -3172,6 +3226,10 @@ autovac_report_workitem(AutoVacuumWorkItem *workitem,
 			snprintf(activity, MAX_AUTOVAC_ACTIV_LEN,
 					 "autovacuum: BRIN summarize");
 			break;
+		case AVW_GINCleanPendingList:
+			snprintf(activity, MAX_AUTOVAC_ACTIV_LEN,
+					 "autovacuum: GIN pending list cleanup");
+			break;
 	}
 
 	/*
@@ -3209,6 +3267,18 @@ AutoVacuumingActive(void)
 /*
  * Request one work item to the next autovacuum run processing our database.
  * Return false if the request can't be recorded.
+ *
+ * An identical request that is already queued and not yet being processed
+ * satisfies the new one, so that callers that keep hitting the same
+ * condition don't fill up the work item array.  A queued request with an
+ * invalid block number applies to the whole relation (for BRIN, it
+ * summarizes all unsummarized ranges), so it satisfies any request for the
+ * same relation.
+ *
+ * If the array is full, a pending request for the same relation is widened
+ * to cover the whole relation instead of dropping the new one; this keeps
+ * bursts of insertions into a single BRIN index from losing summarization
+ * requests, and frees the slots of any other requests it now subsumes.
  */
 bool
 AutoVacuumRequestWork(AutoVacuumWorkItemType type, Oid relationId,
@@ -3216,9 +3286,36 @@ AutoVacuumRequestWork(AutoVacuumWorkItemType type, Oid relationId,
 {
 	int			i;
 	bool		result = false;
+	AutoVacuumWorkItem *sameRel = NULL;
 
 	LWLockAcquire(AutovacuumLock, LW_EXCLUSIVE);
 
+	/*
+	 * Look for a pending work item for the same thing, remembering any
+	 * pending item for the same relation in case we need to widen it.
+	 */
+	for (i = 0; i < NUM_WORKITEMS; i++)
+	{
+		AutoVacuumWorkItem *workitem = &AutoVacuumShmem->av_workItems[i];
+
+		if (!workitem->avw_used ||
+			workitem->avw_active ||
+			workitem->avw_type != type ||
+			workitem->avw_database != MyDatabaseId ||
+			workitem->avw_relation != relationId)
+			continue;
+
+		if (workitem->avw_blockNumber == blkno ||
+			!BlockNumberIsValid(workitem->avw_blockNumber))
+		{
+			LWLockRelease(AutovacuumLock);
+			return true;
+		}
+
+		if (sameRel == NULL)
+			sameRel = workitem;
+	}
+
 	/*
 	 * Locate an unused work item and fill it with the given data.
 	 */
@@ -3241,6 +3338,30 @@ AutoVacuumRequestWork(AutoVacuumWorkItemType type, Oid relationId,
 		break;
 	}
 
+	/*
+	 * No free slot; widen a pending request for the same relation, and
+	 * release the slots of the other pending ones it now covers.
+	 */
+	if (!result && sameRel != NULL)
+	{
+		sameRel->avw_blockNumber = InvalidBlockNumber;
+
+		for (i = 0; i < NUM_WORKITEMS; i++)
+		{
+			AutoVacuumWorkItem *workitem = &AutoVacuumShmem->av_workItems[i];
+
+			if (workitem != sameRel &&
+				workitem->avw_used &&
+				!workitem->avw_active &&
+				workitem->avw_type == type &&
+				workitem->avw_database == MyDatabaseId &&
+				workitem->avw_relation == relationId)
+				workitem->avw_used = false;
+		}
+
+		result = true;
+	}
+
 	LWLockRelease(AutovacuumLock);
 
 	return result;
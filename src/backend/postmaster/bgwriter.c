@@ -237,6 +237,7 @@ BackgroundWriterMain(void)
 		 * Send off activity statistics to the stats collector
 		 */
 		pgstat_send_bgwriter();
+		pgstat_send_wal();
 
 		if (FirstCallSinceLastCheckpoint())
 		{
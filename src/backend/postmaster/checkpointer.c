@@ -493,6 +493,7 @@ CheckpointerMain(void)
 		 * stats message types.)
 		 */
 		pgstat_send_bgwriter();
+		pgstat_send_wal();
 
 		/*
 		 * Sleep until we are signaled or it's time for another checkpoint or
@@ -694,6 +695,7 @@ CheckpointWriteDelay(int flags, double progress)
 		 * Report interim activity statistics to the stats collector.
 		 */
 		pgstat_send_bgwriter();
+		pgstat_send_wal();
 
 		/*
 		 * This sleep used to be connected to bgwriter_delay, typically 200ms.
@@ -15,8 +15,12 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <time.h>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 #include "access/xlog_internal.h"	/* for pg_start/stop_backup */
+#include "catalog/pg_tablespace.h"
 #include "catalog/pg_type.h"
 #include "common/file_perm.h"
 #include "lib/stringinfo.h"
@@ -31,6 +35,7 @@
 #include "replication/basebackup.h"
 #include "replication/walsender.h"
 #include "replication/walsender_private.h"
+#include "replication/walsummary.h"
 #include "storage/bufpage.h"
 #include "storage/checksum.h"
 #include "storage/dsm_impl.h"
@@ -51,6 +56,7 @@ typedef struct
 	bool		includewal;
 	uint32		maxrate;
 	bool		sendtblspcmapfile;
+	int			compression;
 } basebackup_options;
 
 
@@ -58,6 +64,9 @@ static int64 sendDir(const char *path, int basepathlen, bool sizeonly,
 					 List *tablespaces, bool sendtblspclinks);
 static bool sendFile(const char *readfilename, const char *tarfilename,
 					 struct stat *statbuf, bool missing_ok, Oid dboid);
+static bool sendIncrementalFile(const char *readfilename,
+								const char *tarfilename,
+								struct stat *statbuf, Oid dboid);
 static void sendFileWithContent(const char *filename, const char *content);
 static int64 _tarWriteHeader(const char *filename, const char *linktarget,
 							 struct stat *statbuf, bool sizeonly);
@@ -70,7 +79,14 @@ static void parse_basebackup_options(List *options, basebackup_options *opt);
 static void SendXlogRecPtrResult(XLogRecPtr ptr, TimeLineID tli);
 static int	compareWalFileNames(const ListCell *a, const ListCell *b);
 static void throttle(size_t increment);
+static void begin_tar_stream(void);
+static int	send_tar_data(const char *data, size_t len);
+static void end_tar_stream(void);
 static bool is_checksummed_file(const char *fullpath, const char *filename);
+static bool is_incremental_file(const char *fullpath, const char *filename,
+								struct stat *statbuf);
+static bool get_relation_file(const char *readfilename, Oid dboid,
+							  RelFileNode *rnode, BlockNumber *segno);
 
 /* Was the backup currently in-progress initiated in recovery mode? */
 static bool backup_started_in_recovery = false;
@@ -121,6 +137,29 @@ static long long int total_checksum_failures;
 /* Do not verify checksums. */
 static bool noverify_checksums = false;
 
+/*
+ * For an incremental backup, the LSN of the earlier backup it is based on;
+ * InvalidXLogRecPtr for a full backup.
+ */
+static XLogRecPtr incremental_lsn = InvalidXLogRecPtr;
+
+/*
+ * For an incremental backup, the blocks modified by the WAL from
+ * incremental_lsn to the start of this backup, or NULL if that WAL isn't
+ * available.
+ */
+static WalSummary *walsummary = NULL;
+
+/* gzip compression level for the tar streams, or 0 to send them as-is. */
+static int	compression_level = 0;
+
+#ifdef HAVE_LIBZ
+/* State of the gzip stream for the tar file currently being sent. */
+static z_stream zstream;
+static bool zstream_active = false;
+static char zbuffer[TAR_SEND_SIZE];
+#endif
+
 /*
  * The contents of these directories are removed or recreated during server
  * start so they are not included in backups.  The directories themselves are
@@ -233,6 +272,7 @@ perform_base_backup(basebackup_options *opt)
 	List	   *tablespaces = NIL;
 
 	datadirpathlen = strlen(DataDir);
+	compression_level = opt->compression;
 
 	backup_started_in_recovery = RecoveryInProgress();
 
@@ -258,6 +298,39 @@ perform_base_backup(basebackup_options *opt)
 		ListCell   *lc;
 		tablespaceinfo *ti;
 
+		/*
+		 * An incremental backup can only be based on an earlier backup.  Mark
+		 * it in the backup label, so that it won't be started by mistake
+		 * without being combined with that backup first.
+		 */
+		if (!XLogRecPtrIsInvalid(incremental_lsn))
+		{
+			if (incremental_lsn > startptr)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("incremental backup start location %X/%X is past the start of this backup at %X/%X",
+								(uint32) (incremental_lsn >> 32),
+								(uint32) incremental_lsn,
+								(uint32) (startptr >> 32),
+								(uint32) startptr)));
+
+			appendStringInfo(labelfile, "INCREMENTAL FROM LSN: %X/%X\n",
+							 (uint32) (incremental_lsn >> 32),
+							 (uint32) incremental_lsn);
+
+			/*
+			 * Find the modified blocks from the WAL written since then, so
+			 * that files with no modified blocks needn't be read.  If that
+			 * WAL is gone, fall back to comparing the LSN of every page.
+			 */
+			walsummary = SummarizeWAL(incremental_lsn, startptr);
+			if (walsummary == NULL)
+				ereport(NOTICE,
+						(errmsg("WAL since incremental backup start location %X/%X is not available, reading all relation files",
+								(uint32) (incremental_lsn >> 32),
+								(uint32) incremental_lsn)));
+		}
+
 		SendXlogRecPtrResult(startptr, starttli);
 
 		/*
@@ -308,13 +381,8 @@ perform_base_backup(basebackup_options *opt)
 		foreach(lc, tablespaces)
 		{
 			tablespaceinfo *ti = (tablespaceinfo *) lfirst(lc);
-			StringInfoData buf;
 
-			/* Send CopyOutResponse message */
-			pq_beginmessage(&buf, 'H');
-			pq_sendbyte(&buf, 0);	/* overall format */
-			pq_sendint16(&buf, 0);	/* natts */
-			pq_endmessage(&buf);
+			begin_tar_stream();
 
 			if (ti->path == NULL)
 			{
@@ -357,7 +425,7 @@ perform_base_backup(basebackup_options *opt)
 				Assert(lnext(tablespaces, lc) == NULL);
 			}
 			else
-				pq_putemptymessage('c');	/* CopyDone */
+				end_tar_stream();
 		}
 
 		endptr = do_pg_stop_backup(labelfile->data, !opt->nowait, &endtli);
@@ -531,12 +599,11 @@ perform_base_backup(basebackup_options *opt)
 			{
 				CheckXLogRemoved(segno, tli);
 				/* Send the chunk as a CopyData message */
-				if (pq_putmessage('d', buf, cnt))
+				if (send_tar_data(buf, cnt))
 					ereport(ERROR,
 							(errmsg("base backup could not send data, aborting backup")));
 
 				len += cnt;
-				throttle(cnt);
 
 				if (len == wal_segment_size)
 					break;
@@ -593,8 +660,8 @@ perform_base_backup(basebackup_options *opt)
 			sendFileWithContent(pathbuf, "");
 		}
 
-		/* Send CopyDone message for the last tar file */
-		pq_putemptymessage('c');
+		/* Finish the last tar file */
+		end_tar_stream();
 	}
 	SendXlogRecPtrResult(endptr, endtli);
 
@@ -639,8 +706,12 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 	bool		o_maxrate = false;
 	bool		o_tablespace_map = false;
 	bool		o_noverify_checksums = false;
+	bool		o_incremental = false;
+	bool		o_compression = false;
 
 	MemSet(opt, 0, sizeof(*opt));
+	incremental_lsn = InvalidXLogRecPtr;
+	walsummary = NULL;
 	foreach(lopt, options)
 	{
 		DefElem    *defel = (DefElem *) lfirst(lopt);
@@ -727,6 +798,49 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 			noverify_checksums = true;
 			o_noverify_checksums = true;
 		}
+		else if (strcmp(defel->defname, "incremental") == 0)
+		{
+			char	   *lsnstr = strVal(defel->arg);
+			uint32		hi,
+						lo;
+
+			if (o_incremental)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+
+			if (sscanf(lsnstr, "%X/%X", &hi, &lo) != 2 ||
+				(incremental_lsn = ((uint64) hi) << 32 | lo) == InvalidXLogRecPtr)
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("invalid value for parameter \"%s\": \"%s\"",
+								"INCREMENTAL", lsnstr)));
+			o_incremental = true;
+		}
+		else if (strcmp(defel->defname, "compression") == 0)
+		{
+			long		level;
+
+			if (o_compression)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+
+			level = intVal(defel->arg);
+			if (level < 1 || level > 9)
+				ereport(ERROR,
+						(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+						 errmsg("%d is outside the valid range for parameter \"%s\" (%d .. %d)",
+								(int) level, "COMPRESSION", 1, 9)));
+#ifndef HAVE_LIBZ
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("compression is not supported by this build")));
+#endif
+
+			opt->compression = (int) level;
+			o_compression = true;
+		}
 		else
 			elog(ERROR, "option \"%s\" not recognized",
 				 defel->defname);
@@ -934,7 +1048,7 @@ sendFileWithContent(const char *filename, const char *content)
 
 	_tarWriteHeader(filename, NULL, &statbuf, false);
 	/* Send the contents as a CopyData message */
-	pq_putmessage('d', content, len);
+	send_tar_data(content, len);
 
 	/* Pad to 512 byte boundary, per tar format requirements */
 	pad = ((len + 511) & ~511) - len;
@@ -943,7 +1057,7 @@ sendFileWithContent(const char *filename, const char *content)
 		char		buf[512];
 
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		send_tar_data(buf, pad);
 	}
 }
 
@@ -1290,8 +1404,19 @@ sendDir(const char *path, int basepathlen, bool sizeonly, List *tablespaces,
 			bool		sent = false;
 
 			if (!sizeonly)
-				sent = sendFile(pathbuf, pathbuf + basepathlen + 1, &statbuf,
-								true, isDbDir ? pg_atoi(lastDir + 1, sizeof(Oid), 0) : InvalidOid);
+			{
+				Oid			dboid;
+
+				dboid = isDbDir ? pg_atoi(lastDir + 1, sizeof(Oid), 0) : InvalidOid;
+
+				if (!XLogRecPtrIsInvalid(incremental_lsn) &&
+					is_incremental_file(pathbuf, de->d_name, &statbuf))
+					sent = sendIncrementalFile(pathbuf, pathbuf + basepathlen + 1,
+											   &statbuf, dboid);
+				else
+					sent = sendFile(pathbuf, pathbuf + basepathlen + 1, &statbuf,
+									true, dboid);
+			}
 
 			if (sent || sizeonly)
 			{
@@ -1335,6 +1460,64 @@ is_checksummed_file(const char *fullpath, const char *filename)
 		return false;
 }
 
+/*
+ * Check if a file can be sent incrementally.  That's only done for the main
+ * fork of relations: the free space map and the visibility map can change
+ * without their page LSN being advanced, so those forks are always sent in
+ * full.  They are small compared to the main fork anyway.
+ */
+static bool
+is_incremental_file(const char *fullpath, const char *filename,
+					struct stat *statbuf)
+{
+	int			relOidChars;
+	ForkNumber	relForkNum;
+
+	if (statbuf->st_size % BLCKSZ != 0)
+		return false;
+
+	if (!is_checksummed_file(fullpath, filename))
+		return false;
+
+	if (!parse_filename_for_nontemp_relation(filename, &relOidChars,
+											 &relForkNum))
+		return false;
+
+	return relForkNum == MAIN_FORKNUM;
+}
+
+/*
+ * Identify the relation and segment that a file sent incrementally belongs
+ * to, to look it up in the WAL summary.  That's only done for files in the
+ * default and global tablespaces; false is returned for others.
+ */
+static bool
+get_relation_file(const char *readfilename, Oid dboid, RelFileNode *rnode,
+				  BlockNumber *segno)
+{
+	const char *filename = last_dir_separator(readfilename) + 1;
+	const char *segmentpath;
+
+	if (strncmp(readfilename, "./global/", 9) == 0)
+	{
+		rnode->spcNode = GLOBALTABLESPACE_OID;
+		rnode->dbNode = InvalidOid;
+	}
+	else if (strncmp(readfilename, "./base/", 7) == 0)
+	{
+		rnode->spcNode = DEFAULTTABLESPACE_OID;
+		rnode->dbNode = dboid;
+	}
+	else
+		return false;
+
+	rnode->relNode = (Oid) strtoul(filename, NULL, 10);
+	segmentpath = strchr(filename, '.');
+	*segno = segmentpath != NULL ? (BlockNumber) atoi(segmentpath + 1) : 0;
+
+	return true;
+}
+
 /*****
  * Functions for handling tar file format
  *
@@ -1537,12 +1720,11 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 		}
 
 		/* Send the chunk as a CopyData message */
-		if (pq_putmessage('d', buf, cnt))
+		if (send_tar_data(buf, cnt))
 			ereport(ERROR,
 					(errmsg("base backup could not send data, aborting backup")));
 
 		len += cnt;
-		throttle(cnt);
 
 		if (feof(fp) || len >= statbuf->st_size)
 		{
@@ -1564,24 +1746,273 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 		while (len < statbuf->st_size)
 		{
 			cnt = Min(sizeof(buf), statbuf->st_size - len);
-			pq_putmessage('d', buf, cnt);
+			send_tar_data(buf, cnt);
 			len += cnt;
-			throttle(cnt);
+		}
+	}
+
+	/* Pad to 512 byte boundary, per tar format requirements */
+	pad = ((len + 511) & ~511) - len;
+	if (pad > 0)
+	{
+		MemSet(buf, 0, pad);
+		send_tar_data(buf, pad);
+	}
+
+	FreeFile(fp);
+
+	if (checksum_failures > 1)
+	{
+		ereport(WARNING,
+				(errmsg_plural("file \"%s\" has a total of %d checksum verification failure",
+							   "file \"%s\" has a total of %d checksum verification failures",
+							   checksum_failures,
+							   readfilename, checksum_failures)));
+
+		pgstat_report_checksum_failures_in_db(dboid, checksum_failures);
+	}
+
+	total_checksum_failures += checksum_failures;
+
+	return true;
+}
+
+/*
+ * Send a relation file as part of an incremental backup.
+ *
+ * Only the blocks that have been modified since incremental_lsn are sent,
+ * in a file named INCREMENTAL.<filename> laid out as described in
+ * basebackup.h.  The other blocks are taken from the earlier backup when the
+ * backups are combined.  Like in a full backup, blocks modified after the
+ * start of this backup don't need to be read consistently, as they will be
+ * restored from WAL.
+ *
+ * If we have a WAL summary, it tells which blocks were modified, and only
+ * those are read.  A file that was created since incremental_lsn is sent in
+ * full instead.  Without a summary, or if the relation has been truncated,
+ * the whole file is read, and blocks whose page LSN is at least
+ * incremental_lsn are sent, along with any new (all-zeroes) blocks.
+ *
+ * Checksums of the blocks read are verified the same way as in sendFile().
+ *
+ * Returns true if the file was sent, false if it no longer exists.
+ */
+static bool
+sendIncrementalFile(const char *readfilename, const char *tarfilename,
+					struct stat *statbuf, Oid dboid)
+{
+	FILE	   *fp;
+	PGAlignedBlock buf;
+	IncrementalFileHeader hdr;
+	uint32	   *blocks;
+	BlockNumber nblocks;
+	BlockNumber blkno;
+	bool		block_retry = false;
+	bool		verify_checksum;
+	int			checksum_failures = 0;
+	int			segmentno = 0;
+	char	   *segmentpath;
+	const char *filename;
+	char	   *incrfilename;
+	struct stat incrstatbuf;
+	pgoff_t		len;
+	size_t		pad;
+	uint32		i;
+	RelFileNode rnode;
+	BlockNumber segno;
+	bool		use_summary = false;
+	Bitmapset  *modified = NULL;
+	BlockNumber *toread = NULL;
+	BlockNumber ntoread;
+
+	if (walsummary != NULL &&
+		get_relation_file(readfilename, dboid, &rnode, &segno))
+	{
+		switch (WalSummaryGetFile(walsummary, rnode, segno, &modified))
+		{
+			case WALSUMMARY_FILE_CREATED:
+				return sendFile(readfilename, tarfilename, statbuf, true,
+								dboid);
+			case WALSUMMARY_FILE_TRUNCATED:
+				break;
+			case WALSUMMARY_FILE_BLOCKS:
+				use_summary = true;
+				break;
+		}
+	}
+
+	fp = AllocateFile(readfilename, "rb");
+	if (fp == NULL)
+	{
+		if (errno == ENOENT)
+			return false;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", readfilename)));
+	}
+
+	filename = last_dir_separator(readfilename) + 1;
+
+	verify_checksum = !noverify_checksums && DataChecksumsEnabled();
+	if (verify_checksum)
+	{
+		segmentpath = strstr(filename, ".");
+		if (segmentpath != NULL)
+		{
+			segmentno = atoi(segmentpath + 1);
+			if (segmentno == 0)
+				ereport(ERROR,
+						(errmsg("invalid segment number %d in file \"%s\"",
+								segmentno, filename)));
 		}
 	}
 
 	/*
-	 * Pad to 512 byte boundary, per tar format requirements. (This small
-	 * piece of data is probably not worth throttling.)
+	 * First pass: read the blocks the WAL summary lists, or the whole file,
+	 * to find out which blocks need to be sent, and verify checksums while
+	 * we're at it.
 	 */
+	nblocks = statbuf->st_size / BLCKSZ;
+	blocks = palloc(sizeof(uint32) * Max(nblocks, 1));
+	hdr.num_blocks = 0;
+
+	if (use_summary)
+	{
+		int			x = -1;
+
+		toread = palloc(sizeof(BlockNumber) * Max(bms_num_members(modified), 1));
+		ntoread = 0;
+		while ((x = bms_next_member(modified, x)) >= 0 && x < nblocks)
+			toread[ntoread++] = x;
+	}
+	else
+		ntoread = nblocks;
+
+	for (i = 0; i < ntoread; i++)
+	{
+		blkno = use_summary ? toread[i] : i;
+
+		if (use_summary && fseek(fp, (long) blkno * BLCKSZ, SEEK_SET) == -1)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not fseek in file \"%s\": %m",
+							readfilename)));
+
+		if (fread(buf.data, 1, BLCKSZ, fp) != BLCKSZ)
+		{
+			CHECK_FREAD_ERROR(fp, readfilename);
+
+			/*
+			 * The file was truncated concurrently.  The truncation will be
+			 * replayed from WAL, so just leave out the missing blocks.
+			 */
+			nblocks = blkno;
+			break;
+		}
+
+		/* See sendFile() for the reasoning behind these checks */
+		if (verify_checksum && !PageIsNew(buf.data) &&
+			PageGetLSN(buf.data) < startptr)
+		{
+			PageHeader	phdr = (PageHeader) buf.data;
+			uint16		checksum;
+
+			checksum = pg_checksum_page(buf.data, blkno + segmentno * RELSEG_SIZE);
+			if (phdr->pd_checksum != checksum)
+			{
+				/* Reread the block once, it may have been torn */
+				if (!block_retry)
+				{
+					if (fseek(fp, -BLCKSZ, SEEK_CUR) == -1)
+						ereport(ERROR,
+								(errcode_for_file_access(),
+								 errmsg("could not fseek in file \"%s\": %m",
+										readfilename)));
+					block_retry = true;
+					i--;
+					continue;
+				}
+
+				checksum_failures++;
+
+				if (checksum_failures <= 5)
+					ereport(WARNING,
+							(errmsg("checksum verification failed in "
+									"file \"%s\", block %d: calculated "
+									"%X but expected %X",
+									readfilename, blkno, checksum,
+									phdr->pd_checksum)));
+				if (checksum_failures == 5)
+					ereport(WARNING,
+							(errmsg("further checksum verification "
+									"failures in file \"%s\" will not "
+									"be reported", readfilename)));
+			}
+		}
+		block_retry = false;
+
+		if (use_summary || PageIsNew(buf.data) ||
+			PageGetLSN(buf.data) >= incremental_lsn)
+			blocks[hdr.num_blocks++] = blkno;
+	}
+
+	/*
+	 * Second pass: send the header, the list of block numbers and the
+	 * modified blocks.
+	 */
+	hdr.magic = INCREMENTAL_MAGIC;
+	hdr.truncation_block_length = nblocks;
+
+	len = sizeof(hdr) + sizeof(uint32) * hdr.num_blocks +
+		(pgoff_t) BLCKSZ * hdr.num_blocks;
+	memcpy(&incrstatbuf, statbuf, sizeof(struct stat));
+	incrstatbuf.st_size = len;
+
+	incrfilename = psprintf("%.*s%s%s",
+							(int) (strlen(tarfilename) - strlen(filename)),
+							tarfilename, INCREMENTAL_PREFIX, filename);
+	_tarWriteHeader(incrfilename, NULL, &incrstatbuf, false);
+
+	if (send_tar_data((char *) &hdr, sizeof(hdr)) ||
+		(hdr.num_blocks > 0 &&
+		 send_tar_data((char *) blocks, sizeof(uint32) * hdr.num_blocks)))
+		ereport(ERROR,
+				(errmsg("base backup could not send data, aborting backup")));
+
+	for (i = 0; i < hdr.num_blocks; i++)
+	{
+		if (fseek(fp, (long) blocks[i] * BLCKSZ, SEEK_SET) == -1)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not fseek in file \"%s\": %m",
+							readfilename)));
+
+		if (fread(buf.data, 1, BLCKSZ, fp) != BLCKSZ)
+		{
+			CHECK_FREAD_ERROR(fp, readfilename);
+
+			/* Truncated concurrently, will be restored from WAL */
+			MemSet(buf.data, 0, BLCKSZ);
+		}
+
+		if (send_tar_data(buf.data, BLCKSZ))
+			ereport(ERROR,
+					(errmsg("base backup could not send data, aborting backup")));
+	}
+
+	/* Pad to 512 byte boundary, per tar format requirements */
 	pad = ((len + 511) & ~511) - len;
 	if (pad > 0)
 	{
-		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		MemSet(buf.data, 0, pad);
+		send_tar_data(buf.data, pad);
 	}
 
 	FreeFile(fp);
+	pfree(blocks);
+	if (toread != NULL)
+		pfree(toread);
+	pfree(incrfilename);
 
 	if (checksum_failures > 1)
 	{
@@ -1632,7 +2063,7 @@ _tarWriteHeader(const char *filename, const char *linktarget,
 				elog(ERROR, "unrecognized tar error: %d", rc);
 		}
 
-		pq_putmessage('d', h, sizeof(h));
+		send_tar_data(h, sizeof(h));
 	}
 
 	return sizeof(h);
@@ -1730,3 +2161,133 @@ throttle(size_t increment)
 	 */
 	throttled_last = GetCurrentTimestamp();
 }
+
+/*
+ * Start a new tar stream, one per tablespace, by sending a CopyOutResponse
+ * message.  If compression was requested, also set up a fresh gzip stream;
+ * each tar file is sent as a complete gzip file of its own.
+ */
+static void
+begin_tar_stream(void)
+{
+	StringInfoData buf;
+
+	/* Send CopyOutResponse message */
+	pq_beginmessage(&buf, 'H');
+	pq_sendbyte(&buf, 0);		/* overall format */
+	pq_sendint16(&buf, 0);		/* natts */
+	pq_endmessage(&buf);
+
+#ifdef HAVE_LIBZ
+	if (compression_level > 0)
+	{
+		/* Release anything left behind by an earlier, aborted backup */
+		if (zstream_active)
+			deflateEnd(&zstream);
+		zstream_active = false;
+
+		MemSet(&zstream, 0, sizeof(zstream));
+		zstream.zalloc = Z_NULL;
+		zstream.zfree = Z_NULL;
+		zstream.opaque = Z_NULL;
+
+		/* windowBits 15 plus 16 makes zlib write a gzip header and trailer */
+		if (deflateInit2(&zstream, compression_level, Z_DEFLATED, 15 + 16, 8,
+						 Z_DEFAULT_STRATEGY) != Z_OK)
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("could not initialize compression library: %s",
+							zstream.msg ? zstream.msg : "out of memory")));
+		zstream_active = true;
+		zstream.next_out = (Bytef *) zbuffer;
+		zstream.avail_out = sizeof(zbuffer);
+	}
+#endif
+}
+
+/*
+ * Send a chunk of the current tar stream, compressing it first if requested.
+ *
+ * Like pq_putmessage(), returns 0 if OK, EOF if trouble.  Compressed data is
+ * buffered and only sent once a full output buffer has accumulated.  The
+ * transfer rate is limited here, based on what is actually sent over the
+ * network, so the compressed size if compression is used.
+ */
+static int
+send_tar_data(const char *data, size_t len)
+{
+#ifdef HAVE_LIBZ
+	if (compression_level > 0)
+	{
+		Assert(zstream_active);
+
+		zstream.next_in = (Bytef *) unconstify(char *, data);
+		zstream.avail_in = len;
+
+		while (zstream.avail_in > 0)
+		{
+			if (deflate(&zstream, Z_NO_FLUSH) == Z_STREAM_ERROR)
+				elog(ERROR, "could not compress data: %s",
+					 zstream.msg ? zstream.msg : "stream error");
+
+			if (zstream.avail_out == 0)
+			{
+				if (pq_putmessage('d', zbuffer, sizeof(zbuffer)))
+					return EOF;
+				throttle(sizeof(zbuffer));
+				zstream.next_out = (Bytef *) zbuffer;
+				zstream.avail_out = sizeof(zbuffer);
+			}
+		}
+		return 0;
+	}
+#endif
+
+	if (pq_putmessage('d', data, len))
+		return EOF;
+	throttle(len);
+	return 0;
+}
+
+/*
+ * Finish the current tar stream: flush out whatever is left in the gzip
+ * stream, if any, and send a CopyDone message.
+ */
+static void
+end_tar_stream(void)
+{
+#ifdef HAVE_LIBZ
+	if (compression_level > 0)
+	{
+		int			r;
+
+		Assert(zstream_active);
+
+		zstream.next_in = NULL;
+		zstream.avail_in = 0;
+
+		do
+		{
+			size_t		have;
+
+			r = deflate(&zstream, Z_FINISH);
+			if (r == Z_STREAM_ERROR)
+				elog(ERROR, "could not compress data: %s",
+					 zstream.msg ? zstream.msg : "stream error");
+
+			have = sizeof(zbuffer) - zstream.avail_out;
+			if (have > 0 && pq_putmessage('d', zbuffer, have))
+				ereport(ERROR,
+						(errmsg("base backup could not send data, aborting backup")));
+			throttle(have);
+			zstream.next_out = (Bytef *) zbuffer;
+			zstream.avail_out = sizeof(zbuffer);
+		} while (r != Z_STREAM_END);
+
+		deflateEnd(&zstream);
+		zstream_active = false;
+	}
+#endif
+
+	pq_putemptymessage('c');	/* CopyDone */
+}
@@ -91,23 +91,23 @@ CheckLogicalDecodingRequirements(void)
 				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
 				 errmsg("logical decoding requires a database connection")));
 
-	/* ----
-	 * TODO: We got to change that someday soon...
+	/*
+	 * On a standby, the WAL being decoded is generated by the primary, so
+	 * that's whose wal_level counts.  This check is racy, but a later
+	 * XLOG_PARAMETER_CHANGE lowering wal_level invalidates the slots, and
+	 * decoding such a record errors out.
 	 *
-	 * There's basically three things missing to allow this:
-	 * 1) We need to be able to correctly and quickly identify the timeline a
-	 *	  LSN belongs to
-	 * 2) We need to force hot_standby_feedback to be enabled at all times so
-	 *	  the primary cannot remove rows we need.
-	 * 3) support dropping replication slots referring to a database, in
-	 *	  dbase_redo. There can't be any active ones due to HS recovery
-	 *	  conflicts, so that should be relatively easy.
-	 * ----
+	 * Catalog rows needed by the slot are protected on the primary only via
+	 * hot_standby_feedback, which we can't enforce here; if they are removed
+	 * nonetheless, replay invalidates the slot.
 	 */
 	if (RecoveryInProgress())
-		ereport(ERROR,
-				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
-				 errmsg("logical decoding cannot be used while in recovery")));
+	{
+		if (GetActiveWalLevelOnStandby() < WAL_LEVEL_LOGICAL)
+			ereport(ERROR,
+					(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+					 errmsg("logical decoding on standby requires wal_level >= logical on the primary")));
+	}
 }
 
 /*
@@ -398,6 +398,13 @@ CreateDecodingContext(XLogRecPtr start_lsn,
 				 (errmsg("replication slot \"%s\" was not created in this database",
 						 NameStr(slot->data.name)))));
 
+	if (XLogRecPtrIsInvalid(slot->data.restart_lsn))
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("cannot read from logical replication slot \"%s\"",
+						NameStr(slot->data.name)),
+				 errdetail("This slot has been invalidated because it was conflicting with recovery.")));
+
 	if (start_lsn == InvalidXLogRecPtr)
 	{
 		/* continue from last position */
@@ -818,6 +818,10 @@ ReplicationSlotsComputeLogicalRestartLSN(void)
 		restart_lsn = s->data.restart_lsn;
 		SpinLockRelease(&s->mutex);
 
+		/* invalidated slots don't need any WAL */
+		if (restart_lsn == InvalidXLogRecPtr)
+			continue;
+
 		if (result == InvalidXLogRecPtr ||
 			restart_lsn < result)
 			result = restart_lsn;
@@ -963,6 +967,136 @@ restart:
 	LWLockRelease(ReplicationSlotControlLock);
 }
 
+/*
+ * InvalidateConflictingLogicalReplicationSlots -- invalidate logical slots
+ * that need catalog rows removed by a WAL record replayed on a standby.
+ *
+ * All logical slots on database dboid whose catalog_xmin is at or before xid
+ * are invalidated.  InvalidOid stands for any database (the removed rows
+ * belonged to a shared catalog), and InvalidTransactionId for any
+ * catalog_xmin.  Processes using a conflicting slot are terminated first.
+ *
+ * An invalidated slot keeps existing, but with restart_lsn and catalog_xmin
+ * reset it can no longer be used for decoding and has to be dropped.
+ */
+void
+InvalidateConflictingLogicalReplicationSlots(Oid dboid, TransactionId xid)
+{
+	int			i;
+	bool		found_conflict = false;
+
+	if (max_replication_slots <= 0)
+		return;
+
+restart:
+	LWLockAcquire(ReplicationSlotControlLock, LW_SHARED);
+	for (i = 0; i < max_replication_slots; i++)
+	{
+		ReplicationSlot *s;
+		NameData	slotname;
+		TransactionId slot_catalog_xmin;
+		int			active_pid;
+
+		s = &ReplicationSlotCtl->replication_slots[i];
+
+		/* cannot change while ReplicationSlotCtlLock is held */
+		if (!s->in_use)
+			continue;
+
+		/* only logical slots need catalog rows */
+		if (!SlotIsLogical(s))
+			continue;
+
+		/* not our database, skip */
+		if (OidIsValid(dboid) && s->data.database != dboid)
+			continue;
+
+		SpinLockAcquire(&s->mutex);
+		slot_catalog_xmin = s->effective_catalog_xmin;
+
+		/* already invalidated, or the removed rows aren't needed */
+		if (!TransactionIdIsValid(slot_catalog_xmin) ||
+			(TransactionIdIsValid(xid) &&
+			 TransactionIdFollows(slot_catalog_xmin, xid)))
+		{
+			SpinLockRelease(&s->mutex);
+			continue;
+		}
+
+		slotname = s->data.name;
+		active_pid = s->active_pid;
+		if (active_pid == 0)
+		{
+			/* acquire slot, so ReplicationSlotSave can be reused */
+			MyReplicationSlot = s;
+			s->active_pid = MyProcPid;
+		}
+		SpinLockRelease(&s->mutex);
+		LWLockRelease(ReplicationSlotControlLock);
+
+		if (active_pid != 0)
+		{
+			/*
+			 * Terminate the process using the slot and wait for it to let go
+			 * of it, then restart the scan, as the slot may have been dropped
+			 * in the meantime.
+			 */
+			ereport(LOG,
+					(errmsg("terminating process %d because replication slot \"%s\" conflicts with recovery",
+							active_pid, NameStr(slotname))));
+
+			ConditionVariablePrepareToSleep(&s->active_cv);
+			(void) kill(active_pid, SIGTERM);
+
+			for (;;)
+			{
+				int			cur_pid;
+
+				SpinLockAcquire(&s->mutex);
+				cur_pid = s->active_pid;
+				SpinLockRelease(&s->mutex);
+
+				if (cur_pid != active_pid)
+					break;
+
+				ConditionVariableSleep(&s->active_cv,
+									   WAIT_EVENT_REPLICATION_SLOT_DROP);
+			}
+			ConditionVariableCancelSleep();
+			goto restart;
+		}
+
+		SpinLockAcquire(&s->mutex);
+		s->effective_xmin = InvalidTransactionId;
+		s->effective_catalog_xmin = InvalidTransactionId;
+		s->data.catalog_xmin = InvalidTransactionId;
+		s->data.restart_lsn = InvalidXLogRecPtr;
+		SpinLockRelease(&s->mutex);
+
+		ReplicationSlotMarkDirty();
+		ReplicationSlotSave();
+		ReplicationSlotRelease();
+
+		ereport(LOG,
+				(errmsg("invalidating replication slot \"%s\" because it conflicts with recovery",
+						NameStr(slotname)),
+				 TransactionIdIsValid(xid) ?
+				 errdetail("The slot's catalog_xmin %u is at or before the removed rows' xid %u.",
+						   slot_catalog_xmin, xid) :
+				 errdetail("Logical decoding on standby requires wal_level >= logical on the primary.")));
+
+		found_conflict = true;
+		goto restart;
+	}
+	LWLockRelease(ReplicationSlotControlLock);
+
+	if (found_conflict)
+	{
+		ReplicationSlotsComputeRequiredXmin(false);
+		ReplicationSlotsComputeRequiredLSN();
+	}
+}
+
 
 /*
  * Check whether the server's configuration supports using replication
@@ -1023,8 +1157,19 @@ ReplicationSlotReserveWal(void)
 		 * the location of the last redo LSN. While that slightly increases
 		 * the chance that we have to retry, it's where a base backup has to
 		 * start replay at.
+		 *
+		 * A logical slot on a standby can't log a standby snapshot; it starts
+		 * at the last replayed record and waits for the primary to log the
+		 * next one, see pg_log_standby_snapshot().
 		 */
-		if (!RecoveryInProgress() && SlotIsLogical(slot))
+		if (SlotIsLogical(slot) && RecoveryInProgress())
+		{
+			restart_lsn = GetXLogReplayRecPtr(NULL);
+			SpinLockAcquire(&slot->mutex);
+			slot->data.restart_lsn = restart_lsn;
+			SpinLockRelease(&slot->mutex);
+		}
+		else if (SlotIsLogical(slot))
 		{
 			XLogRecPtr	flushptr;
 
@@ -772,6 +772,13 @@ logical_read_xlog_page(XLogReaderState *state, XLogRecPtr targetPagePtr, int req
 	WALReadError errinfo;
 	XLogSegNo	segno;
 
+	/*
+	 * When decoding on a standby, follow the timeline of the replayed WAL.
+	 * RecoveryInProgress() will update ThisTimeLineID on promotion.
+	 */
+	if (RecoveryInProgress())
+		(void) GetXLogReplayRecPtr(&ThisTimeLineID);
+
 	XLogReadDetermineTimeline(state, targetPagePtr, reqLen);
 	sendTimeLineIsHistoric = (state->currTLI != ThisTimeLineID);
 	sendTimeLine = state->currTLI;
@@ -0,0 +1,322 @@
+/*-------------------------------------------------------------------------
+ *
+ * walsummary.c
+ *	  Summarize the blocks modified by a range of WAL
+ *
+ * An incremental base backup needs to know which blocks of each relation
+ * have been modified since the earlier backup it is based on.  The WAL
+ * written in between answers that without reading the relation files: with
+ * wal_level of replica or higher, every modification of a block in the main
+ * fork of a permanent relation is WAL-logged with a reference to that block.
+ * The exceptions are files that are created, truncated or copied wholesale,
+ * which are recorded separately: the summary then reports the whole file as
+ * new, or asks for it to be scanned.
+ *
+ * The summary is built by reading the WAL from pg_wal when the backup
+ * starts, so that WAL must still be there.  If it isn't, SummarizeWAL()
+ * returns NULL and the caller has to find modified blocks some other way.
+ *
+ * Portions Copyright (c) 2010-2020, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  src/backend/replication/walsummary.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/rmgr.h"
+#include "access/xlog.h"
+#include "access/xlog_internal.h"
+#include "access/xlogreader.h"
+#include "access/xlogutils.h"
+#include "catalog/storage_xlog.h"
+#include "commands/dbcommands_xlog.h"
+#include "miscadmin.h"
+#include "replication/walsummary.h"
+#include "storage/fd.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+
+/*
+ * Blocks referenced in one segment file of a relation's main fork.  The
+ * block numbers are relative to the start of the segment file.
+ */
+typedef struct WalSummaryFileKey
+{
+	RelFileNode rnode;
+	BlockNumber segno;
+} WalSummaryFileKey;
+
+typedef struct WalSummaryFileEntry
+{
+	WalSummaryFileKey key;		/* hash key; must be first */
+	Bitmapset  *blocks;
+} WalSummaryFileEntry;
+
+/*
+ * Relations whose main fork was created or truncated.  An entry whose
+ * relNode is InvalidOid stands for a whole database, created by copying
+ * another one.
+ */
+typedef struct WalSummaryRelEntry
+{
+	RelFileNode rnode;			/* hash key; must be first */
+	bool		created;
+	bool		truncated;
+} WalSummaryRelEntry;
+
+struct WalSummary
+{
+	HTAB	   *files;
+	HTAB	   *relations;
+};
+
+static bool wal_is_available(XLogRecPtr start_lsn, XLogRecPtr end_lsn);
+static void summarize_record(WalSummary *summary, XLogReaderState *record);
+static WalSummaryRelEntry *summary_relation(WalSummary *summary,
+											RelFileNode rnode);
+
+/*
+ * Summarize the WAL records that start between start_lsn, which must be the
+ * start of a record, and end_lsn.
+ *
+ * Returns NULL if the WAL is no longer available, or can't be read from
+ * start_lsn.
+ */
+WalSummary *
+SummarizeWAL(XLogRecPtr start_lsn, XLogRecPtr end_lsn)
+{
+	WalSummary *summary;
+	XLogReaderState *xlogreader;
+	XLogRecord *record;
+	char	   *errormsg;
+	HASHCTL		ctl;
+
+	if (!wal_is_available(start_lsn, end_lsn))
+		return NULL;
+
+	summary = palloc(sizeof(WalSummary));
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(WalSummaryFileKey);
+	ctl.entrysize = sizeof(WalSummaryFileEntry);
+	ctl.hcxt = CurrentMemoryContext;
+	summary->files = hash_create("WAL summary files", 1024, &ctl,
+								 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(RelFileNode);
+	ctl.entrysize = sizeof(WalSummaryRelEntry);
+	ctl.hcxt = CurrentMemoryContext;
+	summary->relations = hash_create("WAL summary relations", 64, &ctl,
+									 HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+	xlogreader = XLogReaderAllocate(wal_segment_size, NULL,
+									read_local_xlog_page, NULL);
+	if (!xlogreader)
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory"),
+				 errdetail("Failed while allocating a WAL reading processor.")));
+
+	record = XLogReadRecord(xlogreader, start_lsn, &errormsg);
+	while (record != NULL)
+	{
+		CHECK_FOR_INTERRUPTS();
+
+		summarize_record(summary, xlogreader);
+
+		/* Records starting at or past end_lsn aren't needed */
+		if (xlogreader->EndRecPtr >= end_lsn)
+			break;
+
+		record = XLogReadRecord(xlogreader, InvalidXLogRecPtr, &errormsg);
+	}
+
+	if (record == NULL)
+	{
+		ereport(DEBUG1,
+				(errmsg("could not read WAL from %X/%X to %X/%X",
+						(uint32) (start_lsn >> 32), (uint32) start_lsn,
+						(uint32) (end_lsn >> 32), (uint32) end_lsn),
+				 errormsg ? errdetail_internal("%s", errormsg) : 0));
+		XLogReaderFree(xlogreader);
+		hash_destroy(summary->files);
+		hash_destroy(summary->relations);
+		pfree(summary);
+		return NULL;
+	}
+
+	XLogReaderFree(xlogreader);
+
+	return summary;
+}
+
+/*
+ * Tell what the summary knows about segment segno of the main fork of
+ * relation rnode.  For WALSUMMARY_FILE_BLOCKS, *blocks is set to the
+ * modified blocks, numbered from the start of the segment file; NULL means
+ * none.
+ */
+WalSummaryFileStatus
+WalSummaryGetFile(WalSummary *summary, RelFileNode rnode, BlockNumber segno,
+				  Bitmapset **blocks)
+{
+	RelFileNode dbnode;
+	WalSummaryRelEntry *relentry;
+	WalSummaryFileKey key;
+	WalSummaryFileEntry *fileentry;
+
+	dbnode = rnode;
+	dbnode.relNode = InvalidOid;
+	relentry = hash_search(summary->relations, &dbnode, HASH_FIND, NULL);
+	if (relentry != NULL && relentry->created)
+		return WALSUMMARY_FILE_CREATED;
+
+	relentry = hash_search(summary->relations, &rnode, HASH_FIND, NULL);
+	if (relentry != NULL && relentry->created)
+		return WALSUMMARY_FILE_CREATED;
+	if (relentry != NULL && relentry->truncated)
+		return WALSUMMARY_FILE_TRUNCATED;
+
+	MemSet(&key, 0, sizeof(key));
+	key.rnode = rnode;
+	key.segno = segno;
+	fileentry = hash_search(summary->files, &key, HASH_FIND, NULL);
+	*blocks = fileentry != NULL ? fileentry->blocks : NULL;
+
+	return WALSUMMARY_FILE_BLOCKS;
+}
+
+/*
+ * Check that all WAL segments covering start_lsn to end_lsn are present in
+ * pg_wal, on some timeline.
+ */
+static bool
+wal_is_available(XLogRecPtr start_lsn, XLogRecPtr end_lsn)
+{
+	XLogSegNo	startsegno;
+	XLogSegNo	endsegno;
+	XLogSegNo	segno;
+	bool	   *present;
+	DIR		   *dir;
+	struct dirent *de;
+	bool		result = true;
+
+	XLByteToSeg(start_lsn, startsegno, wal_segment_size);
+	XLByteToSeg(end_lsn, endsegno, wal_segment_size);
+
+	/* Quick exit if we know some of it has been removed already */
+	if (XLogGetLastRemovedSegno() >= startsegno)
+		return false;
+
+	present = palloc0(sizeof(bool) * (endsegno - startsegno + 1));
+
+	dir = AllocateDir(XLOGDIR);
+	while ((de = ReadDir(dir, XLOGDIR)) != NULL)
+	{
+		TimeLineID	tli;
+
+		if (!IsXLogFileName(de->d_name))
+			continue;
+
+		XLogFromFileName(de->d_name, &tli, &segno, wal_segment_size);
+		if (segno >= startsegno && segno <= endsegno)
+			present[segno - startsegno] = true;
+	}
+	FreeDir(dir);
+
+	for (segno = startsegno; segno <= endsegno; segno++)
+	{
+		if (!present[segno - startsegno])
+		{
+			result = false;
+			break;
+		}
+	}
+	pfree(present);
+
+	return result;
+}
+
+/*
+ * Add the blocks referenced by one WAL record to the summary, and note any
+ * relation files or databases it creates or truncates.
+ */
+static void
+summarize_record(WalSummary *summary, XLogReaderState *record)
+{
+	uint8		rmid = XLogRecGetRmid(record);
+	uint8		info = XLogRecGetInfo(record) & ~XLR_INFO_MASK;
+	int			block_id;
+
+	if (rmid == RM_SMGR_ID)
+	{
+		if (info == XLOG_SMGR_CREATE)
+		{
+			xl_smgr_create *xlrec = (xl_smgr_create *) XLogRecGetData(record);
+
+			if (xlrec->forkNum == MAIN_FORKNUM)
+				summary_relation(summary, xlrec->rnode)->created = true;
+		}
+		else if (info == XLOG_SMGR_TRUNCATE)
+		{
+			xl_smgr_truncate *xlrec = (xl_smgr_truncate *) XLogRecGetData(record);
+
+			if ((xlrec->flags & SMGR_TRUNCATE_HEAP) != 0)
+				summary_relation(summary, xlrec->rnode)->truncated = true;
+		}
+	}
+	else if (rmid == RM_DBASE_ID && info == XLOG_DBASE_CREATE)
+	{
+		xl_dbase_create_rec *xlrec = (xl_dbase_create_rec *) XLogRecGetData(record);
+		RelFileNode dbnode;
+
+		dbnode.spcNode = xlrec->tablespace_id;
+		dbnode.dbNode = xlrec->db_id;
+		dbnode.relNode = InvalidOid;
+		summary_relation(summary, dbnode)->created = true;
+	}
+
+	for (block_id = 0; block_id <= record->max_block_id; block_id++)
+	{
+		WalSummaryFileKey key;
+		WalSummaryFileEntry *entry;
+		ForkNumber	forknum;
+		BlockNumber blkno;
+		bool		found;
+
+		MemSet(&key, 0, sizeof(key));
+		if (!XLogRecGetBlockTag(record, block_id, &key.rnode, &forknum,
+								&blkno))
+			continue;
+		if (forknum != MAIN_FORKNUM)
+			continue;
+
+		key.segno = blkno / RELSEG_SIZE;
+		entry = hash_search(summary->files, &key, HASH_ENTER, &found);
+		if (!found)
+			entry->blocks = NULL;
+		entry->blocks = bms_add_member(entry->blocks, blkno % RELSEG_SIZE);
+	}
+}
+
+/*
+ * Find or make the summary's entry for a relation or database.
+ */
+static WalSummaryRelEntry *
+summary_relation(WalSummary *summary, RelFileNode rnode)
+{
+	WalSummaryRelEntry *entry;
+	bool		found;
+
+	entry = hash_search(summary->relations, &rnode, HASH_ENTER, &found);
+	if (!found)
+	{
+		entry->created = false;
+		entry->truncated = false;
+	}
+
+	return entry;
+}
@@ -205,6 +205,34 @@ BarrierArriveAndDetach(Barrier *barrier)
 	return BarrierDetachImpl(barrier, true);
 }
 
+/*
+ * Arrive at a barrier, and detach all but the last to arrive.  Returns true if
+ * the caller was the last to arrive, and is therefore still attached.  The
+ * last to arrive advances the phase without waiting.
+ *
+ * This allows a wait-free election of one participant to carry on with a
+ * phase that must not start until all others have finished the current one,
+ * when it isn't safe to wait for them.  No participant may be waiting at the
+ * barrier when this is used.
+ */
+bool
+BarrierArriveAndDetachExceptLast(Barrier *barrier)
+{
+	SpinLockAcquire(&barrier->mutex);
+	if (barrier->participants > 1)
+	{
+		--barrier->participants;
+		SpinLockRelease(&barrier->mutex);
+
+		return false;
+	}
+	Assert(barrier->participants == 1);
+	++barrier->phase;
+	SpinLockRelease(&barrier->mutex);
+
+	return true;
+}
+
 /*
  * Attach to a barrier.  All waiting participants will now wait for this
  * participant to call BarrierArriveAndWait(), BarrierDetach() or
@@ -23,6 +23,7 @@
 #include "access/xloginsert.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "replication/slot.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
 #include "storage/proc.h"
@@ -291,7 +292,9 @@ ResolveRecoveryConflictWithVirtualXIDs(VirtualTransactionId *waitlist,
 }
 
 void
-ResolveRecoveryConflictWithSnapshot(TransactionId latestRemovedXid, RelFileNode node)
+ResolveRecoveryConflictWithSnapshot(TransactionId latestRemovedXid,
+									bool isCatalogRel,
+									RelFileNode node)
 {
 	VirtualTransactionId *backends;
 
@@ -312,6 +315,16 @@ ResolveRecoveryConflictWithSnapshot(TransactionId latestRemovedXid, RelFileNode
 
 	ResolveRecoveryConflictWithVirtualXIDs(backends,
 										   PROCSIG_RECOVERY_CONFLICT_SNAPSHOT);
+
+	/*
+	 * Logical decoding on this standby reads the catalogs with historic
+	 * snapshots going back to each slot's catalog_xmin.  If the primary
+	 * removed catalog rows such a snapshot could still see, the slots
+	 * concerned are useless now.
+	 */
+	if (isCatalogRel)
+		InvalidateConflictingLogicalReplicationSlots(node.dbNode,
+													 latestRemovedXid);
 }
 
 void
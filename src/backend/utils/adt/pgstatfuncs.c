@@ -16,6 +16,7 @@
 
 #include "access/htup_details.h"
 #include "access/xlog.h"
+#include "access/xlogprefetch.h"
 #include "catalog/pg_authid.h"
 #include "catalog/pg_type.h"
 #include "common/ip.h"
@@ -180,6 +181,22 @@ pg_stat_get_dead_tuples(PG_FUNCTION_ARGS)
 }
 
 
+Datum
+pg_stat_get_unsummarized_ranges(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	int64		result;
+	PgStat_StatTabEntry *tabentry;
+
+	if ((tabentry = pgstat_fetch_stat_tabentry(relid)) == NULL)
+		result = 0;
+	else
+		result = (int64) (tabentry->n_unsummarized_ranges);
+
+	PG_RETURN_INT64(result);
+}
+
+
 Datum
 pg_stat_get_mod_since_analyze(PG_FUNCTION_ARGS)
 {
@@ -1968,3 +1985,184 @@ pg_stat_get_archiver(PG_FUNCTION_ARGS)
 	PG_RETURN_DATUM(HeapTupleGetDatum(
 									  heap_form_tuple(tupdesc, values, nulls)));
 }
+
+/*
+ * Returns WAL statistics, one row per backend type.
+ */
+Datum
+pg_stat_get_wal(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_WAL_COLS	10
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	PgStat_WalStats *wal_stats;
+	int			i;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	/* Get statistics about WAL activity */
+	wal_stats = pgstat_fetch_stat_wal();
+
+	for (i = 0; i < BACKEND_NUM_TYPES; i++)
+	{
+		PgStat_WalCounts *counts = &wal_stats->counts[i];
+		Datum		values[PG_STAT_GET_WAL_COLS];
+		bool		nulls[PG_STAT_GET_WAL_COLS];
+		char		buf[256];
+
+		MemSet(values, 0, sizeof(values));
+		MemSet(nulls, 0, sizeof(nulls));
+
+		values[0] = CStringGetTextDatum(pgstat_get_backend_desc((BackendType) i));
+		values[1] = Int64GetDatum(counts->wal_records);
+		values[2] = Int64GetDatum(counts->wal_fpi);
+
+		/* Convert to numeric, like pg_stat_statements does */
+		snprintf(buf, sizeof buf, UINT64_FORMAT, (uint64) counts->wal_bytes);
+		values[3] = DirectFunctionCall3(numeric_in,
+										CStringGetDatum(buf),
+										ObjectIdGetDatum(0),
+										Int32GetDatum(-1));
+
+		values[4] = Int64GetDatum(counts->wal_buffers_full);
+		values[5] = Int64GetDatum(counts->wal_write);
+		values[6] = Int64GetDatum(counts->wal_sync);
+		/* convert counters from microsec to millisec for display */
+		values[7] = Float8GetDatum(((double) counts->wal_write_time) / 1000.0);
+		values[8] = Float8GetDatum(((double) counts->wal_sync_time) / 1000.0);
+
+		if (wal_stats->stat_reset_timestamp == 0)
+			nulls[9] = true;
+		else
+			values[9] = TimestampTzGetDatum(wal_stats->stat_reset_timestamp);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
+
+Datum
+pg_stat_get_group_commit(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[5];
+	bool		nulls[5];
+	uint64		requests;
+	uint64		flushes;
+	double		flush_time;
+	int			commit_delay;
+
+	/* Initialise values and NULL flags arrays */
+	MemSet(values, 0, sizeof(values));
+	MemSet(nulls, 0, sizeof(nulls));
+
+	/* Initialise attributes information in the tuple descriptor */
+	tupdesc = CreateTemplateTupleDesc(5);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "flush_requests",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "flushes",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "avg_batch_size",
+					   FLOAT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "avg_flush_time",
+					   FLOAT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 5, "commit_delay",
+					   INT4OID, -1, 0);
+
+	BlessTupleDesc(tupdesc);
+
+	GetXLogGroupCommitStats(&requests, &flushes, &flush_time, &commit_delay);
+
+	/* Fill values and NULLs */
+	values[0] = Int64GetDatum((int64) requests);
+	values[1] = Int64GetDatum((int64) flushes);
+	if (flushes == 0)
+	{
+		nulls[2] = true;
+		nulls[3] = true;
+	}
+	else
+	{
+		values[2] = Float8GetDatum((double) requests / flushes);
+		/* convert to msec */
+		values[3] = Float8GetDatum(flush_time / 1000.0);
+	}
+	values[4] = Int32GetDatum(commit_delay);
+
+	/* Returns the record as Datum */
+	PG_RETURN_DATUM(HeapTupleGetDatum(
+									  heap_form_tuple(tupdesc, values, nulls)));
+}
+
+Datum
+pg_stat_get_prefetch_recovery(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[6];
+	bool		nulls[6];
+	XLogPrefetchStats stats;
+
+	/* Initialise values and NULL flags arrays */
+	MemSet(values, 0, sizeof(values));
+	MemSet(nulls, 0, sizeof(nulls));
+
+	/* Initialise attributes information in the tuple descriptor */
+	tupdesc = CreateTemplateTupleDesc(6);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "prefetch",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "skip_hit",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "skip_new",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "skip_fpw",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 5, "skip_seq",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 6, "distance",
+					   INT8OID, -1, 0);
+
+	BlessTupleDesc(tupdesc);
+
+	XLogPrefetchGetStats(&stats);
+
+	/* Fill values and NULLs */
+	values[0] = Int64GetDatum((int64) stats.prefetch);
+	values[1] = Int64GetDatum((int64) stats.skip_hit);
+	values[2] = Int64GetDatum((int64) stats.skip_new);
+	values[3] = Int64GetDatum((int64) stats.skip_fpw);
+	values[4] = Int64GetDatum((int64) stats.skip_seq);
+	values[5] = Int64GetDatum((int64) stats.distance);
+
+	/* Returns the record as Datum */
+	PG_RETURN_DATUM(HeapTupleGetDatum(
+									  heap_form_tuple(tupdesc, values, nulls)));
+}
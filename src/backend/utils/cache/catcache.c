@@ -63,6 +63,17 @@
 /* Cache management header --- pointer is NULL until created */
 static CatCacheHeader *CacheHdr = NULL;
 
+/* GUC parameter: limit on CacheHdr->ch_size, in kB; 0 means no limit */
+int			catalog_cache_max_size = 0;
+
+/*
+ * Approximate memory used by a cache entry, as tracked in ch_size.  Negative
+ * entries' separately allocated keys aren't counted.
+ */
+#define CatCTupSize(ct) \
+	((ct)->negative ? sizeof(CatCTup) : \
+	 sizeof(CatCTup) + MAXIMUM_ALIGNOF + (ct)->tuple.t_len)
+
 static inline HeapTuple SearchCatCacheInternal(CatCache *cache,
 											   int nkeys,
 											   Datum v1, Datum v2,
@@ -88,6 +99,7 @@ static void CatCachePrintStats(int code, Datum arg);
 #endif
 static void CatCacheRemoveCTup(CatCache *cache, CatCTup *ct);
 static void CatCacheRemoveCList(CatCache *cache, CatCList *cl);
+static void CatCacheEvict(void);
 static void CatalogCacheInitializeCache(CatCache *cache);
 static CatCTup *CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp,
 										Datum *arguments,
@@ -471,8 +483,11 @@ CatCacheRemoveCTup(CatCache *cache, CatCTup *ct)
 		return;					/* nothing left to do */
 	}
 
-	/* delink from linked list */
+	/* delink from linked lists */
 	dlist_delete(&ct->cache_elem);
+	dlist_delete(&ct->lru_elem);
+
+	CacheHdr->ch_size -= CatCTupSize(ct);
 
 	/*
 	 * Free keys when we're dealing with a negative entry, normal entries just
@@ -488,6 +503,39 @@ CatCacheRemoveCTup(CatCache *cache, CatCTup *ct)
 	--CacheHdr->ch_ntup;
 }
 
+/*
+ *		CatCacheEvict
+ *
+ * Remove least recently used entries until the memory used by all caches is
+ * within catalog_cache_max_size, or nothing more can be removed.
+ *
+ * Entries that are referenced, directly or through a CatCList, can't be
+ * removed; we move them to the front of the LRU list as we pass them, since
+ * they are evidently in use, and so that we don't keep rescanning them.
+ */
+static void
+CatCacheEvict(void)
+{
+	Size		limit = (Size) catalog_cache_max_size * 1024;
+	int			nskipped = 0;
+
+	while (CacheHdr->ch_size > limit && nskipped < CacheHdr->ch_ntup)
+	{
+		CatCTup    *ct = dlist_tail_element(CatCTup, lru_elem,
+											&CacheHdr->ch_lru);
+
+		if (ct->refcount > 0 ||
+			(ct->c_list != NULL && ct->c_list->refcount > 0))
+		{
+			dlist_move_head(&CacheHdr->ch_lru, &ct->lru_elem);
+			nskipped++;
+			continue;
+		}
+
+		CatCacheRemoveCTup(ct->my_cache, ct);
+	}
+}
+
 /*
  *		CatCacheRemoveCList
  *
@@ -680,6 +728,18 @@ ResetCatalogCache(CatCache *cache)
 	}
 }
 
+/*
+ *		CatalogCacheMemoryUsed
+ *
+ * Return the memory used by tuples in all catalog caches, as compared
+ * against catalog_cache_max_size.
+ */
+Size
+CatalogCacheMemoryUsed(void)
+{
+	return CacheHdr != NULL ? CacheHdr->ch_size : 0;
+}
+
 /*
  *		ResetCatalogCaches
  *
@@ -802,6 +862,8 @@ InitCatCache(int id,
 		CacheHdr = (CatCacheHeader *) palloc(sizeof(CatCacheHeader));
 		slist_init(&CacheHdr->ch_caches);
 		CacheHdr->ch_ntup = 0;
+		CacheHdr->ch_size = 0;
+		dlist_init(&CacheHdr->ch_lru);
 #ifdef CATCACHE_STATS
 		/* set up to dump stats at backend exit */
 		on_proc_exit(CatCachePrintStats, 0);
@@ -1263,6 +1325,7 @@ SearchCatCacheInternal(CatCache *cache,
 		 * near the front of the hashbucket's list.)
 		 */
 		dlist_move_head(bucket, &ct->cache_elem);
+		dlist_move_head(&CacheHdr->ch_lru, &ct->lru_elem);
 
 		/*
 		 * If it's a positive entry, bump its refcount and return it. If it's
@@ -1810,6 +1873,13 @@ CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp, Datum *arguments,
 	HeapTuple	dtp;
 	MemoryContext oldcxt;
 
+	/*
+	 * Make room for the new entry first, if the caches are over their memory
+	 * limit; doing it afterwards could evict the new entry itself.
+	 */
+	if (catalog_cache_max_size > 0)
+		CatCacheEvict();
+
 	/* negative entries have no tuple associated */
 	if (ntp)
 	{
@@ -1890,9 +1960,11 @@ CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp, Datum *arguments,
 	ct->hash_value = hashValue;
 
 	dlist_push_head(&cache->cc_bucket[hashIndex], &ct->cache_elem);
+	dlist_push_head(&CacheHdr->ch_lru, &ct->lru_elem);
 
 	cache->cc_ntup++;
 	CacheHdr->ch_ntup++;
+	CacheHdr->ch_size += CatCTupSize(ct);
 
 	/*
 	 * If the hash table has become too full, enlarge the buckets array. Quite
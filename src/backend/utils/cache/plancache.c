@@ -11,6 +11,10 @@
  * The logic for choosing generic or custom plans is in choose_custom_plan,
  * which see for comments.
  *
+ * Generic plans can also be shared with other backends through the shared
+ * plan cache (see sharedplancache.c), if that is enabled.  BuildCachedPlan
+ * looks there before running the planner, and stores what it makes there.
+ *
  * Cache invalidation is driven off sinval events.  Any CachedPlanSource
  * that matches the event is marked invalid, as is its generic CachedPlan
  * if it has one.  When (and if) the next demand for a cached plan occurs,
@@ -56,8 +60,11 @@
 
 #include <limits.h>
 
+#include "access/htup_details.h"
 #include "access/transam.h"
+#include "access/xact.h"
 #include "catalog/namespace.h"
+#include "catalog/pg_index.h"
 #include "executor/executor.h"
 #include "miscadmin.h"
 #include "nodes/nodeFuncs.h"
@@ -69,8 +76,11 @@
 #include "tcop/utility.h"
 #include "utils/inval.h"
 #include "utils/memutils.h"
+#include "utils/rel.h"
+#include "utils/relcache.h"
 #include "utils/resowner_private.h"
 #include "utils/rls.h"
+#include "utils/sharedplancache.h"
 #include "utils/snapmgr.h"
 #include "utils/syscache.h"
 
@@ -102,6 +112,15 @@ static List *RevalidateCachedQuery(CachedPlanSource *plansource,
 static bool CheckCachedPlan(CachedPlanSource *plansource);
 static CachedPlan *BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 								   ParamListInfo boundParams, QueryEnvironment *queryEnv);
+static bool PlanIsShareable(CachedPlanSource *plansource, List *qlist,
+							QueryEnvironment *queryEnv);
+static List *FetchSharedPlan(const char *querystr, int cursor_options,
+							 const SharedPlanCacheGeneration *generation);
+static void StoreSharedPlan(const char *querystr, int cursor_options,
+							List *plist,
+							const SharedPlanCacheGeneration *generation);
+static uint64 SharedPlanDependencyMask(List *plist);
+static TransactionId SharedPlanCheckXmin(List *plist);
 static bool choose_custom_plan(CachedPlanSource *plansource,
 							   ParamListInfo boundParams);
 static double cached_plan_cost(CachedPlan *plan, bool include_planner);
@@ -883,6 +902,8 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	bool		is_transient;
 	MemoryContext plan_context;
 	MemoryContext oldcxt = CurrentMemoryContext;
+	char	   *shared_querystr = NULL;
+	SharedPlanCacheGeneration shared_generation;
 	ListCell   *lc;
 
 	/*
@@ -928,9 +949,46 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	}
 
 	/*
-	 * Generate the plan.
+	 * A generic plan might be available from the shared plan cache.  The
+	 * cache is keyed by the serialized query tree, which we must compute
+	 * before the planner scribbles on it.  Any invalidation processed after
+	 * we read the cache generations advances them; anything processed before
+	 * that which affects our query tree has cleared is_valid.
+	 *
+	 * A transaction that has an XID may have changed the catalogs, and any
+	 * plan it makes could depend on those uncommitted changes, while plans
+	 * made by others wouldn't take them into account.  So such transactions
+	 * don't use the shared plan cache at all.
 	 */
-	plist = pg_plan_queries(qlist, plansource->cursor_options, boundParams);
+	plist = NIL;
+	if (boundParams == NULL && SharedPlanCacheEnabled() &&
+		!TransactionIdIsValid(GetTopTransactionIdIfAny()) &&
+		PlanIsShareable(plansource, qlist, queryEnv))
+	{
+		SharedPlanCacheGetGeneration(&shared_generation);
+		if (plansource->is_valid)
+		{
+			shared_querystr = nodeToString(qlist);
+			plist = FetchSharedPlan(shared_querystr,
+									plansource->cursor_options,
+									&shared_generation);
+		}
+	}
+
+	/*
+	 * Generate the plan, if we didn't get one, and offer it to other
+	 * backends.
+	 */
+	if (plist == NIL)
+	{
+		plist = pg_plan_queries(qlist, plansource->cursor_options, boundParams);
+
+		/* planning might have assigned an XID, through a function call */
+		if (shared_querystr != NULL &&
+			!TransactionIdIsValid(GetTopTransactionIdIfAny()))
+			StoreSharedPlan(shared_querystr, plansource->cursor_options,
+							plist, &shared_generation);
+	}
 
 	/* Release snapshot if we got one */
 	if (snapshot_set)
@@ -1007,6 +1065,196 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	return plan;
 }
 
+/*
+ * PlanIsShareable: can the generic plan for this query go into the shared
+ * plan cache?
+ *
+ * Utility statements are excluded since they can't necessarily be
+ * serialized, as are queries referencing ephemeral named relations, which
+ * are private to the backend.  One-shot plans aren't worth sharing.
+ */
+static bool
+PlanIsShareable(CachedPlanSource *plansource, List *qlist,
+				QueryEnvironment *queryEnv)
+{
+	ListCell   *lc;
+
+	if (plansource->is_oneshot || queryEnv != NULL)
+		return false;
+
+	foreach(lc, qlist)
+	{
+		Query	   *query = lfirst_node(Query, lc);
+
+		if (query->commandType == CMD_UTILITY)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * FetchSharedPlan: get a generic plan from the shared plan cache.
+ *
+ * querystr is the serialized query tree, and generation holds the shared
+ * plan cache generations it's known to be valid in.  Returns NIL if there is
+ * no usable plan.
+ */
+static List *
+FetchSharedPlan(const char *querystr, int cursor_options,
+				const SharedPlanCacheGeneration *generation)
+{
+	char	   *planstr;
+	List	   *plist;
+
+	planstr = SharedPlanCacheLookup(querystr, cursor_options, generation);
+	if (planstr == NULL)
+		return NIL;
+
+	plist = (List *) stringToNode(planstr);
+	pfree(planstr);
+
+	/*
+	 * The planner would have locked any relations it added to the range
+	 * table, such as inheritance children, so we must do the same.  If that
+	 * caused any invalidation to be processed, the plan may be stale; give
+	 * up on it and plan afresh.
+	 */
+	AcquireExecutorLocks(plist, true);
+	if (!SharedPlanCacheIsCurrent(generation, SharedPlanDependencyMask(plist)))
+	{
+		AcquireExecutorLocks(plist, false);
+		return NIL;
+	}
+
+	return plist;
+}
+
+/*
+ * StoreSharedPlan: offer a freshly made generic plan to the shared plan cache.
+ *
+ * Transient plans can't be shared, since their validity depends on our own
+ * TransactionXmin.  Neither can plans that use an index that is only safe
+ * to use for a new enough TransactionXmin be used by everyone, so we also
+ * tell the cache which TransactionXmin fetchers need (see
+ * SharedPlanCheckXmin).
+ */
+static void
+StoreSharedPlan(const char *querystr, int cursor_options, List *plist,
+				const SharedPlanCacheGeneration *generation)
+{
+	char	   *planstr;
+	ListCell   *lc;
+
+	foreach(lc, plist)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+
+		if (plannedstmt->transientPlan)
+			return;
+	}
+
+	planstr = nodeToString(plist);
+	SharedPlanCacheInsert(querystr, cursor_options, planstr,
+						  SharedPlanDependencyMask(plist),
+						  SharedPlanCheckXmin(plist), generation);
+	pfree(planstr);
+}
+
+/*
+ * SharedPlanDependencyMask: get the shared plan cache's mask of partitions
+ * for all relations and objects a plan depends on.
+ */
+static uint64
+SharedPlanDependencyMask(List *plist)
+{
+	uint64		depmask = 0;
+	ListCell   *lc;
+
+	foreach(lc, plist)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+		ListCell   *lc2;
+
+		foreach(lc2, plannedstmt->relationOids)
+			depmask |= UINT64CONST(1) <<
+				SharedPlanCacheRelationPartition(lfirst_oid(lc2));
+
+		foreach(lc2, plannedstmt->invalItems)
+		{
+			PlanInvalItem *item = (PlanInvalItem *) lfirst(lc2);
+
+			depmask |= UINT64CONST(1) <<
+				SharedPlanCacheObjectPartition(item->cacheId, item->hashValue);
+		}
+	}
+
+	return depmask;
+}
+
+/*
+ * SharedPlanCheckXmin: get the xmin a backend's TransactionXmin must follow
+ * for it to use a plan, or InvalidTransactionId if there's no such
+ * restriction.
+ *
+ * The planner only uses an index marked indcheckxmin once its pg_index row's
+ * xmin precedes TransactionXmin (see get_relation_info), so if the plan's
+ * relations have any such index, the plan may only be given to backends
+ * for which that holds too.  We don't know which indexes the plan actually
+ * uses, so consider all indexes of its relations.
+ */
+static TransactionId
+SharedPlanCheckXmin(List *plist)
+{
+	TransactionId checkxmin = InvalidTransactionId;
+	ListCell   *lc;
+
+	foreach(lc, plist)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+		ListCell   *lc2;
+
+		foreach(lc2, plannedstmt->relationOids)
+		{
+			Relation	rel = RelationIdGetRelation(lfirst_oid(lc2));
+			List	   *indexoidlist;
+			ListCell   *lc3;
+
+			if (!RelationIsValid(rel))
+				continue;
+			if (!rel->rd_rel->relhasindex)
+			{
+				RelationClose(rel);
+				continue;
+			}
+
+			indexoidlist = RelationGetIndexList(rel);
+			foreach(lc3, indexoidlist)
+			{
+				HeapTuple	indexTuple;
+				TransactionId xmin;
+
+				indexTuple = SearchSysCache1(INDEXRELID,
+											 ObjectIdGetDatum(lfirst_oid(lc3)));
+				if (!HeapTupleIsValid(indexTuple))
+					continue;
+				if (((Form_pg_index) GETSTRUCT(indexTuple))->indcheckxmin)
+				{
+					xmin = HeapTupleHeaderGetXmin(indexTuple->t_data);
+					if (!TransactionIdIsValid(checkxmin) ||
+						TransactionIdFollows(xmin, checkxmin))
+						checkxmin = xmin;
+				}
+				ReleaseSysCache(indexTuple);
+			}
+			list_free(indexoidlist);
+			RelationClose(rel);
+		}
+	}
+
+	return checkxmin;
+}
+
 /*
  * choose_custom_plan: choose whether to use custom or generic plan
  *
@@ -1765,6 +2013,11 @@ PlanCacheRelCallback(Datum arg, Oid relid)
 {
 	dlist_iter	iter;
 
+	if (relid == InvalidOid)
+		SharedPlanCacheInvalidate();
+	else
+		SharedPlanCacheInvalidatePartition(SharedPlanCacheRelationPartition(relid));
+
 	dlist_foreach(iter, &saved_plan_list)
 	{
 		CachedPlanSource *plansource = dlist_container(CachedPlanSource,
@@ -1849,6 +2102,12 @@ PlanCacheObjectCallback(Datum arg, int cacheid, uint32 hashvalue)
 {
 	dlist_iter	iter;
 
+	if (hashvalue == 0)
+		SharedPlanCacheInvalidate();
+	else
+		SharedPlanCacheInvalidatePartition(SharedPlanCacheObjectPartition(cacheid,
+																		  hashvalue));
+
 	dlist_foreach(iter, &saved_plan_list)
 	{
 		CachedPlanSource *plansource = dlist_container(CachedPlanSource,
@@ -1956,6 +2215,7 @@ PlanCacheObjectCallback(Datum arg, int cacheid, uint32 hashvalue)
 static void
 PlanCacheSysCallback(Datum arg, int cacheid, uint32 hashvalue)
 {
+	SharedPlanCacheInvalidate();
 	ResetPlanCache();
 }
 
@@ -0,0 +1,640 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedplancache.c
+ *	  Cluster-wide cache of generic plans, in shared memory.
+ *
+ * Generic plans are normally built and kept by each backend separately (see
+ * plancache.c), so a large number of sessions running the same statements
+ * each pay for planning them, and each holds its own copy of the plans.
+ * When shared_plan_cache_size is set, plancache.c additionally stores each
+ * generic plan it builds here, and other backends needing a generic plan for
+ * an identical query fetch it from here instead of running the planner.
+ *
+ * Plan trees are pointer-linked structures in backend-local memory, so the
+ * shared copies are kept in serialized (nodeToString) form in a DSA area
+ * carved out of the main shared memory segment, and are deserialized by
+ * the fetching backend.  Entries are keyed by database, user, cursor options,
+ * a fingerprint of the planner-related settings in effect (those shown by
+ * EXPLAIN (SETTINGS)), and a hash of the serialized, rewritten query tree;
+ * since that tree has all names already resolved to OIDs, this also accounts
+ * for the search_path in use.  The full query tree string is stored with the
+ * entry and compared on lookup, so collisions of that hash are harmless.  A
+ * collision of the settings fingerprint can only cause a plan made under
+ * different settings to be used, which is still a correct plan.
+ *
+ * Invalidation works with shared generation counters, which are advanced by
+ * the plan cache invalidation events that any backend processes (see
+ * plancache.c's inval.c callbacks).  Relcache invalidations of a particular
+ * relation, and syscache invalidations of a particular function or type,
+ * advance one of SHARED_PLAN_CACHE_PARTITIONS counters, chosen by hashing
+ * the relation's OID or the object's syscache hash value; all other events,
+ * which plans don't record dependencies on, advance a global counter.  Each
+ * entry remembers the global counter and the sum of the counters of the
+ * partitions its relations and objects (the plan's relationOids and
+ * invalItems) fall into, as they were when the caller started to build the
+ * query tree, and it is ignored, and eventually replaced or swept, once any
+ * of those counters has moved on.  So creating and dropping temporary
+ * tables, say, only invalidates the plans that happen to share a partition
+ * with them.  Since the backend committing a catalog change runs those
+ * callbacks itself before releasing its locks, no entry made before the
+ * change can be fetched after it.
+ *
+ * The planner only uses an index marked indcheckxmin if the pg_index row's
+ * xmin precedes our TransactionXmin, as the index might otherwise lack
+ * entries for HOT chains that older snapshots can see.  A plan using such an
+ * index is therefore only valid for backends whose TransactionXmin is new
+ * enough too.  Entries record the newest such xmin among the indexes of the
+ * plan's relations, and backends with an older TransactionXmin don't fetch
+ * them.
+ *
+ * Hits and misses of lookups are counted, and can be seen with
+ * pg_shared_plan_cache_stats().
+ *
+ * The cache never grows beyond its configured size; if it's full of valid
+ * entries, new plans are simply not added.
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/utils/cache/sharedplancache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "access/transam.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "utils/builtins.h"
+#include "utils/dsa.h"
+#include "utils/guc.h"
+#include "utils/guc_tables.h"
+#include "utils/hashutils.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/sharedplancache.h"
+#include "utils/snapmgr.h"
+
+/*
+ * Number of hash table entries to provide per kilobyte of cache space,
+ * rounded down.  This assumes an average serialized query tree plus plan
+ * takes about 4kB.
+ */
+#define SHARED_PLAN_CACHE_KB_PER_ENTRY	4
+#define SHARED_PLAN_CACHE_MIN_ENTRIES	64
+
+/* Hash key for a shared plan */
+typedef struct SharedPlanCacheKey
+{
+	Oid			dbid;			/* database the query was planned in */
+	Oid			userid;			/* user the query was planned as */
+	int			cursor_options; /* cursor options it was planned with */
+	uint32		settingshash;	/* fingerprint of planner settings */
+	uint32		queryhash;		/* hash of the query tree string */
+} SharedPlanCacheKey;
+
+/* Hash table entry for a shared plan */
+typedef struct SharedPlanCacheEntry
+{
+	SharedPlanCacheKey key;		/* hash key; must be first */
+	uint64		generation;		/* global generation it was made in */
+	uint64		depmask;		/* partitions it depends on */
+	uint64		depsum;			/* sum of their generations */
+	TransactionId checkxmin;	/* TransactionXmin must follow this, if valid */
+	dsa_pointer data;			/* query tree string, then plan string */
+	Size		querylen;		/* length of query tree string */
+	Size		planlen;		/* length of plan string, excluding NUL */
+} SharedPlanCacheEntry;
+
+/* Shared control struct; the in-place DSA area follows it */
+typedef struct SharedPlanCacheCtl
+{
+	pg_atomic_uint64 generation;	/* current global generation */
+	pg_atomic_uint64 partgeneration[SHARED_PLAN_CACHE_PARTITIONS];
+	pg_atomic_uint64 hits;		/* lookups that found a plan */
+	pg_atomic_uint64 misses;	/* lookups that didn't */
+} SharedPlanCacheCtl;
+
+#define SharedPlanCacheAreaSpace() \
+	((char *) SharedPlanCache + MAXALIGN(sizeof(SharedPlanCacheCtl)))
+
+/* GUC parameter */
+int			shared_plan_cache_size = 0;
+
+static SharedPlanCacheCtl *SharedPlanCache = NULL;
+static HTAB *SharedPlanCacheHash = NULL;
+
+/* backend-local handle for the DSA area, set up on first use */
+static dsa_area *SharedPlanCacheArea = NULL;
+
+static long shared_plan_cache_max_entries(void);
+static size_t shared_plan_cache_area_size(void);
+static dsa_area *shared_plan_cache_area(void);
+static uint32 shared_plan_cache_settings_hash(void);
+static void shared_plan_cache_make_key(SharedPlanCacheKey *key,
+									   const char *querystr, Size querylen,
+									   int cursor_options);
+static uint64 shared_plan_cache_dep_sum(const uint64 *partgeneration,
+										uint64 depmask);
+static bool shared_plan_cache_entry_is_current(SharedPlanCacheEntry *entry,
+											   const SharedPlanCacheGeneration *generation);
+static void shared_plan_cache_sweep(dsa_area *area);
+
+
+static long
+shared_plan_cache_max_entries(void)
+{
+	return Max(shared_plan_cache_size / SHARED_PLAN_CACHE_KB_PER_ENTRY,
+			   SHARED_PLAN_CACHE_MIN_ENTRIES);
+}
+
+static size_t
+shared_plan_cache_area_size(void)
+{
+	return Max((size_t) shared_plan_cache_size * 1024, dsa_minimum_size());
+}
+
+/*
+ * Report shared-memory space needed by SharedPlanCacheShmemInit
+ */
+Size
+SharedPlanCacheShmemSize(void)
+{
+	Size		size;
+
+	if (!SharedPlanCacheEnabled())
+		return 0;
+
+	size = MAXALIGN(sizeof(SharedPlanCacheCtl));
+	size = add_size(size, shared_plan_cache_area_size());
+	size = add_size(size, hash_estimate_size(shared_plan_cache_max_entries(),
+											 sizeof(SharedPlanCacheEntry)));
+
+	return size;
+}
+
+/*
+ * Allocate and initialize shared plan cache shared memory
+ */
+void
+SharedPlanCacheShmemInit(void)
+{
+	HASHCTL		info;
+	long		max_entries;
+	bool		found;
+
+	if (!SharedPlanCacheEnabled())
+		return;
+
+	SharedPlanCache = (SharedPlanCacheCtl *)
+		ShmemInitStruct("Shared Plan Cache Ctl",
+						MAXALIGN(sizeof(SharedPlanCacheCtl)) +
+						shared_plan_cache_area_size(),
+						&found);
+
+	if (!found)
+	{
+		dsa_area   *area;
+		int			i;
+
+		pg_atomic_init_u64(&SharedPlanCache->generation, 0);
+		for (i = 0; i < SHARED_PLAN_CACHE_PARTITIONS; i++)
+			pg_atomic_init_u64(&SharedPlanCache->partgeneration[i], 0);
+		pg_atomic_init_u64(&SharedPlanCache->hits, 0);
+		pg_atomic_init_u64(&SharedPlanCache->misses, 0);
+
+		/*
+		 * Create the DSA area in place, and don't let it grow beyond that:
+		 * the cache size is fixed, and the postmaster can't be creating DSM
+		 * segments on behalf of backends anyway.  Pin it, so that it lives on
+		 * when no backend is attached.
+		 */
+		area = dsa_create_in_place(SharedPlanCacheAreaSpace(),
+								   shared_plan_cache_area_size(),
+								   LWTRANCHE_SHARED_PLAN_CACHE_DSA,
+								   NULL);
+		dsa_pin(area);
+		dsa_set_size_limit(area, shared_plan_cache_area_size());
+		dsa_detach(area);
+	}
+
+	max_entries = shared_plan_cache_max_entries();
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(SharedPlanCacheKey);
+	info.entrysize = sizeof(SharedPlanCacheEntry);
+
+	SharedPlanCacheHash = ShmemInitHash("Shared Plan Cache Hash",
+										max_entries, max_entries,
+										&info,
+										HASH_ELEM | HASH_BLOBS | HASH_FIXED_SIZE);
+}
+
+/*
+ * Attach to the DSA area, if not done yet in this backend.
+ */
+static dsa_area *
+shared_plan_cache_area(void)
+{
+	if (SharedPlanCacheArea == NULL)
+	{
+		MemoryContext oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+		SharedPlanCacheArea = dsa_attach_in_place(SharedPlanCacheAreaSpace(),
+												  NULL);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	return SharedPlanCacheArea;
+}
+
+/*
+ * Compute a fingerprint of the settings that affect planning, that is, of
+ * those that EXPLAIN (SETTINGS) would show.
+ */
+static uint32
+shared_plan_cache_settings_hash(void)
+{
+	struct config_generic **gucs;
+	int			num;
+	int			i;
+	uint32		hash = 0;
+
+	gucs = get_explain_guc_options(&num);
+
+	for (i = 0; i < num; i++)
+	{
+		const char *name = gucs[i]->name;
+		char	   *setting = GetConfigOptionByName(name, NULL, true);
+
+		hash = hash_combine(hash,
+							DatumGetUInt32(hash_any((const unsigned char *) name,
+													strlen(name))));
+		if (setting != NULL)
+		{
+			hash = hash_combine(hash,
+								DatumGetUInt32(hash_any((const unsigned char *) setting,
+														strlen(setting))));
+			pfree(setting);
+		}
+	}
+
+	pfree(gucs);
+
+	return hash;
+}
+
+static void
+shared_plan_cache_make_key(SharedPlanCacheKey *key,
+						   const char *querystr, Size querylen,
+						   int cursor_options)
+{
+	/* ensure any padding bytes are zeroed, since we use HASH_BLOBS */
+	MemSet(key, 0, sizeof(SharedPlanCacheKey));
+	key->dbid = MyDatabaseId;
+	key->userid = GetUserId();
+	key->cursor_options = cursor_options;
+	key->settingshash = shared_plan_cache_settings_hash();
+	key->queryhash = DatumGetUInt32(hash_any((const unsigned char *) querystr,
+											 (int) querylen));
+}
+
+/*
+ * Sum of the generations of the partitions in depmask.  As the generations
+ * only ever increase, the sum stays the same only as long as none of them
+ * changes.
+ */
+static uint64
+shared_plan_cache_dep_sum(const uint64 *partgeneration, uint64 depmask)
+{
+	uint64		sum = 0;
+	int			i;
+
+	for (i = 0; i < SHARED_PLAN_CACHE_PARTITIONS; i++)
+	{
+		if (depmask & (UINT64CONST(1) << i))
+			sum += partgeneration[i];
+	}
+
+	return sum;
+}
+
+/*
+ * Is the entry valid as of the given generations?
+ */
+static bool
+shared_plan_cache_entry_is_current(SharedPlanCacheEntry *entry,
+								   const SharedPlanCacheGeneration *generation)
+{
+	return entry->generation == generation->global &&
+		entry->depsum == shared_plan_cache_dep_sum(generation->part,
+												   entry->depmask);
+}
+
+/*
+ * Remove all entries that are no longer valid.
+ *
+ * Caller must hold SharedPlanCacheLock exclusively.
+ */
+static void
+shared_plan_cache_sweep(dsa_area *area)
+{
+	SharedPlanCacheGeneration current;
+	HASH_SEQ_STATUS status;
+	SharedPlanCacheEntry *entry;
+
+	SharedPlanCacheGetGeneration(&current);
+
+	hash_seq_init(&status, SharedPlanCacheHash);
+	while ((entry = (SharedPlanCacheEntry *) hash_seq_search(&status)) != NULL)
+	{
+		if (shared_plan_cache_entry_is_current(entry, &current))
+			continue;
+
+		dsa_free(area, entry->data);
+		hash_search(SharedPlanCacheHash, &entry->key, HASH_REMOVE, NULL);
+	}
+}
+
+/*
+ * SharedPlanCacheGetGeneration
+ *		Read the current invalidation generations.
+ *
+ * Callers must do this before analyzing what they are going to look up or
+ * insert, and pass the result to SharedPlanCacheLookup or
+ * SharedPlanCacheInsert.
+ */
+void
+SharedPlanCacheGetGeneration(SharedPlanCacheGeneration *generation)
+{
+	int			i;
+
+	Assert(SharedPlanCache != NULL);
+
+	generation->global = pg_atomic_read_u64(&SharedPlanCache->generation);
+	for (i = 0; i < SHARED_PLAN_CACHE_PARTITIONS; i++)
+		generation->part[i] =
+			pg_atomic_read_u64(&SharedPlanCache->partgeneration[i]);
+}
+
+/*
+ * SharedPlanCacheIsCurrent
+ *		Check that no invalidation has occurred since the given generations
+ *		were read, other than of relations or objects outside the partitions
+ *		in depmask.
+ */
+bool
+SharedPlanCacheIsCurrent(const SharedPlanCacheGeneration *generation,
+						 uint64 depmask)
+{
+	SharedPlanCacheGeneration current;
+
+	SharedPlanCacheGetGeneration(&current);
+
+	return current.global == generation->global &&
+		shared_plan_cache_dep_sum(current.part, depmask) ==
+		shared_plan_cache_dep_sum(generation->part, depmask);
+}
+
+/*
+ * SharedPlanCacheRelationPartition
+ *		Return the partition invalidations of the given relation are
+ *		counted in.
+ */
+int
+SharedPlanCacheRelationPartition(Oid relid)
+{
+	return murmurhash32(relid) % SHARED_PLAN_CACHE_PARTITIONS;
+}
+
+/*
+ * SharedPlanCacheObjectPartition
+ *		Return the partition invalidations of the syscache entry with the
+ *		given cache ID and hash value are counted in.
+ */
+int
+SharedPlanCacheObjectPartition(int cacheid, uint32 hashvalue)
+{
+	return hash_combine(murmurhash32((uint32) cacheid), hashvalue) %
+		SHARED_PLAN_CACHE_PARTITIONS;
+}
+
+/*
+ * SharedPlanCacheInvalidate
+ *		Invalidate all shared plans.
+ *
+ * This is called from inval.c callbacks, so it mustn't fail.
+ */
+void
+SharedPlanCacheInvalidate(void)
+{
+	if (SharedPlanCache != NULL)
+		pg_atomic_fetch_add_u64(&SharedPlanCache->generation, 1);
+}
+
+/*
+ * SharedPlanCacheInvalidatePartition
+ *		Invalidate the shared plans that depend on a relation or object in
+ *		the given partition.
+ *
+ * This is called from inval.c callbacks, so it mustn't fail.
+ */
+void
+SharedPlanCacheInvalidatePartition(int partition)
+{
+	Assert(partition >= 0 && partition < SHARED_PLAN_CACHE_PARTITIONS);
+
+	if (SharedPlanCache != NULL)
+		pg_atomic_fetch_add_u64(&SharedPlanCache->partgeneration[partition], 1);
+}
+
+/*
+ * SharedPlanCacheLookup
+ *		Find the serialized plan stored for the given serialized query tree
+ *		and cursor options.
+ *
+ * Returns a palloc'd copy of the plan string, or NULL if there is no such
+ * plan that's valid as of the given generations and for our TransactionXmin.
+ */
+char *
+SharedPlanCacheLookup(const char *querystr, int cursor_options,
+					  const SharedPlanCacheGeneration *generation)
+{
+	dsa_area   *area = shared_plan_cache_area();
+	Size		querylen = strlen(querystr);
+	SharedPlanCacheKey key;
+	SharedPlanCacheEntry *entry;
+	char	   *result = NULL;
+
+	shared_plan_cache_make_key(&key, querystr, querylen, cursor_options);
+
+	LWLockAcquire(SharedPlanCacheLock, LW_SHARED);
+
+	entry = (SharedPlanCacheEntry *) hash_search(SharedPlanCacheHash, &key,
+												 HASH_FIND, NULL);
+	if (entry != NULL &&
+		shared_plan_cache_entry_is_current(entry, generation) &&
+		entry->querylen == querylen &&
+		(!TransactionIdIsValid(entry->checkxmin) ||
+		 TransactionIdPrecedes(entry->checkxmin, TransactionXmin)))
+	{
+		char	   *data = dsa_get_address(area, entry->data);
+
+		if (memcmp(data, querystr, querylen) == 0)
+		{
+			result = palloc(entry->planlen + 1);
+			memcpy(result, data + querylen, entry->planlen + 1);
+		}
+	}
+
+	LWLockRelease(SharedPlanCacheLock);
+
+	if (result != NULL)
+		pg_atomic_fetch_add_u64(&SharedPlanCache->hits, 1);
+	else
+		pg_atomic_fetch_add_u64(&SharedPlanCache->misses, 1);
+
+	return result;
+}
+
+/*
+ * SharedPlanCacheInsert
+ *		Store a serialized plan for the given serialized query tree and
+ *		cursor options.
+ *
+ * depmask gives the partitions of the relations and objects the plan depends
+ * on, and checkxmin, if valid, the xmin a backend's TransactionXmin has to
+ * follow for the plan to be usable by it.  Nothing happens if an
+ * invalidation the plan might depend on has occurred since the given
+ * generations were read, or if there isn't room.
+ */
+void
+SharedPlanCacheInsert(const char *querystr, int cursor_options,
+					  const char *planstr, uint64 depmask,
+					  TransactionId checkxmin,
+					  const SharedPlanCacheGeneration *generation)
+{
+	dsa_area   *area = shared_plan_cache_area();
+	Size		querylen = strlen(querystr);
+	Size		planlen = strlen(planstr);
+	SharedPlanCacheKey key;
+	SharedPlanCacheEntry *entry;
+	dsa_pointer data;
+	bool		found;
+
+	shared_plan_cache_make_key(&key, querystr, querylen, cursor_options);
+
+	LWLockAcquire(SharedPlanCacheLock, LW_EXCLUSIVE);
+
+	if (!SharedPlanCacheIsCurrent(generation, depmask))
+	{
+		LWLockRelease(SharedPlanCacheLock);
+		return;
+	}
+
+	/* Someone else might have beaten us to it */
+	entry = (SharedPlanCacheEntry *) hash_search(SharedPlanCacheHash, &key,
+												 HASH_FIND, NULL);
+	if (entry != NULL && shared_plan_cache_entry_is_current(entry, generation))
+	{
+		LWLockRelease(SharedPlanCacheLock);
+		return;
+	}
+
+	/*
+	 * Make room for the new strings.  If the area is full, get rid of stale
+	 * entries and try once more.
+	 */
+	data = dsa_allocate_extended(area, querylen + planlen + 1,
+								 DSA_ALLOC_NO_OOM | DSA_ALLOC_HUGE);
+	if (!DsaPointerIsValid(data))
+	{
+		shared_plan_cache_sweep(area);
+		data = dsa_allocate_extended(area, querylen + planlen + 1,
+									 DSA_ALLOC_NO_OOM | DSA_ALLOC_HUGE);
+		if (!DsaPointerIsValid(data))
+		{
+			LWLockRelease(SharedPlanCacheLock);
+			return;
+		}
+	}
+
+	entry = (SharedPlanCacheEntry *) hash_search(SharedPlanCacheHash, &key,
+												 HASH_ENTER_NULL, &found);
+	if (entry == NULL)
+	{
+		shared_plan_cache_sweep(area);
+		entry = (SharedPlanCacheEntry *) hash_search(SharedPlanCacheHash, &key,
+													 HASH_ENTER_NULL, &found);
+		if (entry == NULL)
+		{
+			dsa_free(area, data);
+			LWLockRelease(SharedPlanCacheLock);
+			return;
+		}
+	}
+	else if (found)
+	{
+		/* replace a stale plan, or one for a colliding query */
+		dsa_free(area, entry->data);
+	}
+
+	memcpy(dsa_get_address(area, data), querystr, querylen);
+	memcpy((char *) dsa_get_address(area, data) + querylen, planstr,
+		   planlen + 1);
+
+	entry->generation = generation->global;
+	entry->depmask = depmask;
+	entry->depsum = shared_plan_cache_dep_sum(generation->part, depmask);
+	entry->checkxmin = checkxmin;
+	entry->data = data;
+	entry->querylen = querylen;
+	entry->planlen = planlen;
+
+	LWLockRelease(SharedPlanCacheLock);
+}
+
+/*
+ * pg_shared_plan_cache_stats
+ *		Report the shared plan cache's lookup counters and number of entries.
+ */
+Datum
+pg_shared_plan_cache_stats(PG_FUNCTION_ARGS)
+{
+#define PG_SHARED_PLAN_CACHE_STATS_COLS	3
+	TupleDesc	tupdesc;
+	Datum		values[PG_SHARED_PLAN_CACHE_STATS_COLS];
+	bool		nulls[PG_SHARED_PLAN_CACHE_STATS_COLS];
+	int64		entries = 0;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	MemSet(values, 0, sizeof(values));
+	MemSet(nulls, 0, sizeof(nulls));
+
+	if (SharedPlanCache != NULL)
+	{
+		LWLockAcquire(SharedPlanCacheLock, LW_SHARED);
+		entries = hash_get_num_entries(SharedPlanCacheHash);
+		LWLockRelease(SharedPlanCacheLock);
+
+		values[0] = Int64GetDatum((int64) pg_atomic_read_u64(&SharedPlanCache->hits));
+		values[1] = Int64GetDatum((int64) pg_atomic_read_u64(&SharedPlanCache->misses));
+	}
+	else
+	{
+		values[0] = Int64GetDatum(0);
+		values[1] = Int64GetDatum(0);
+	}
+	values[2] = Int64GetDatum(entries);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
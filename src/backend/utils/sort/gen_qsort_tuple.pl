@@ -22,6 +22,10 @@
 #     Instead of sorting arbitrary objects, we're always sorting SortTuples.
 #     Add CHECK_FOR_INTERRUPTS().
 #
+# Besides the generic versions, variants are generated for leading sort keys
+# whose comparator is one of the ssup_datum_*_cmp functions.  Those compare
+# datum1 inline, and only fall back to comparetup to break ties.
+#
 # CAUTION: if you change this file, see also qsort.c and qsort_arg.c
 #
 
@@ -53,6 +57,66 @@ print <<'EOM';
 EOM
 emit_qsort_implementation();
 
+$SUFFIX      = 'ssup_int32';
+$EXTRAARGS   = ', SortSupport ssup';
+$EXTRAPARAMS = ', ssup';
+$CMPPARAMS   = ', ssup';
+print <<'EOM';
+
+#define cmp_ssup_int32(a, b, ssup) \
+	ApplyInt32SortComparator((a)->datum1, (a)->isnull1, \
+							 (b)->datum1, (b)->isnull1, ssup)
+
+EOM
+emit_qsort_implementation();
+
+$SUFFIX      = 'tuple_int32';
+$EXTRAARGS   = ', Tuplesortstate *state';
+$EXTRAPARAMS = ', state';
+$CMPPARAMS   = ', state';
+print <<'EOM';
+
+#define cmp_tuple_int32(a, b, state) \
+	qsort_tuple_int32_compare(a, b, state)
+
+EOM
+emit_qsort_implementation();
+
+print <<'EOM';
+
+#ifdef USE_FLOAT8_BYVAL
+EOM
+
+$SUFFIX      = 'ssup_signed';
+$EXTRAARGS   = ', SortSupport ssup';
+$EXTRAPARAMS = ', ssup';
+$CMPPARAMS   = ', ssup';
+print <<'EOM';
+
+#define cmp_ssup_signed(a, b, ssup) \
+	ApplySignedSortComparator((a)->datum1, (a)->isnull1, \
+							  (b)->datum1, (b)->isnull1, ssup)
+
+EOM
+emit_qsort_implementation();
+
+$SUFFIX      = 'tuple_signed';
+$EXTRAARGS   = ', Tuplesortstate *state';
+$EXTRAPARAMS = ', state';
+$CMPPARAMS   = ', state';
+print <<'EOM';
+
+#define cmp_tuple_signed(a, b, state) \
+	qsort_tuple_signed_compare(a, b, state)
+
+EOM
+emit_qsort_implementation();
+
+print <<'EOM';
+
+#endif							/* USE_FLOAT8_BYVAL */
+EOM
+
 sub emit_qsort_boilerplate
 {
 	print <<'EOM';
@@ -96,6 +96,7 @@
 
 #include <limits.h>
 
+#include "access/gin_private.h"
 #include "access/hash.h"
 #include "access/htup_details.h"
 #include "access/nbtree.h"
@@ -413,10 +414,18 @@ struct Tuplesortstate
 
 	/*
 	 * This variable is shared by the single-key MinimalTuple case and the
-	 * Datum case (which both use qsort_ssup()).  Otherwise it's NULL.
+	 * Datum case (which both use qsort_ssup() or one of its specialized
+	 * variants).  Otherwise it's NULL.
 	 */
 	SortSupport onlyKey;
 
+	/*
+	 * Does datum1 hold the value of the leading sort key (possibly
+	 * abbreviated)?  If so, and the leading key's comparator is known, a
+	 * specialized sort routine can compare it inline.
+	 */
+	bool		haveDatum1;
+
 	/*
 	 * Additional state for managing "abbreviated key" sortsupport routines
 	 * (which currently may be used by all cases except the hash index case).
@@ -448,6 +457,9 @@ struct Tuplesortstate
 	uint32		low_mask;
 	uint32		max_buckets;
 
+	/* These are specific to the index_gin subcase: */
+	GinState   *ginstate;		/* for comparing keys */
+
 	/*
 	 * These variables are specific to the Datum case; they are set by
 	 * tuplesort_begin_datum and used only by the DatumTuple routines.
@@ -605,6 +617,7 @@ static void dumptuples(Tuplesortstate *state, bool alltuples);
 static void make_bounded_heap(Tuplesortstate *state);
 static void sort_bounded_heap(Tuplesortstate *state);
 static void tuplesort_sort_memtuples(Tuplesortstate *state);
+static bool radix_sort_memtuples(Tuplesortstate *state, int keybytes);
 static void tuplesort_heap_insert(Tuplesortstate *state, SortTuple *tuple);
 static void tuplesort_heap_replace_top(Tuplesortstate *state, SortTuple *tuple);
 static void tuplesort_heap_delete_top(Tuplesortstate *state);
@@ -635,6 +648,14 @@ static void writetup_index(Tuplesortstate *state, int tapenum,
 						   SortTuple *stup);
 static void readtup_index(Tuplesortstate *state, SortTuple *stup,
 						  int tapenum, unsigned int len);
+static int	comparetup_index_gin(const SortTuple *a, const SortTuple *b,
+								 Tuplesortstate *state);
+static void copytup_index_gin(Tuplesortstate *state, SortTuple *stup,
+							  void *tup);
+static void writetup_index_gin(Tuplesortstate *state, int tapenum,
+							   SortTuple *stup);
+static void readtup_index_gin(Tuplesortstate *state, SortTuple *stup,
+							  int tapenum, unsigned int len);
 static int	comparetup_datum(const SortTuple *a, const SortTuple *b,
 							 Tuplesortstate *state);
 static void copytup_datum(Tuplesortstate *state, SortTuple *stup, void *tup);
@@ -648,15 +669,57 @@ static void worker_nomergeruns(Tuplesortstate *state);
 static void leader_takeover_tapes(Tuplesortstate *state);
 static void free_sort_tuple(Tuplesortstate *state, SortTuple *stup);
 
+/*
+ * Comparators for the qsort_tuple_xxx() variants: compare the leading key
+ * inline, and fall back to comparetup only to break ties.
+ */
+static inline int
+qsort_tuple_int32_compare(SortTuple *a, SortTuple *b, Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplyInt32SortComparator(a->datum1, a->isnull1,
+									   b->datum1, b->isnull1,
+									   state->sortKeys);
+	if (compare != 0)
+		return compare;
+
+	return state->comparetup(a, b, state);
+}
+
+#ifdef USE_FLOAT8_BYVAL
+static inline int
+qsort_tuple_signed_compare(SortTuple *a, SortTuple *b, Tuplesortstate *state)
+{
+	int			compare;
+
+	compare = ApplySignedSortComparator(a->datum1, a->isnull1,
+										b->datum1, b->isnull1,
+										state->sortKeys);
+	if (compare != 0)
+		return compare;
+
+	return state->comparetup(a, b, state);
+}
+#endif
+
 /*
  * Special versions of qsort just for SortTuple objects.  qsort_tuple() sorts
  * any variant of SortTuples, using the appropriate comparetup function.
  * qsort_ssup() is specialized for the case where the comparetup function
  * reduces to ApplySortComparator(), that is single-key MinimalTuple sorts
- * and Datum sorts.
+ * and Datum sorts.  The _int32 and _signed variants of both additionally
+ * inline the comparator of leading keys that use ssup_datum_int32_cmp or
+ * ssup_datum_signed_cmp.
  */
 #include "qsort_tuple.c"
 
+/*
+ * Minimum number of tuples to use radix sort for.  Below that, quicksort
+ * with an inlined comparator is about as fast, and needs no extra memory.
+ */
+#define RADIX_SORT_MIN_TUPLES	10000
+
 
 /*
  *		tuplesort_begin_xxx
@@ -706,10 +769,15 @@ tuplesort_begin_common(int workMem, SortCoordinate coordinate,
 	 * fragmentation. Note that the memtuples array of SortTuples is allocated
 	 * in the parent context, not this context, because there is no need to
 	 * free memtuples early.
+	 *
+	 * Tuples are only ever freed all at once, right before the context is
+	 * reset, so we use a bump context, which packs them more densely than an
+	 * AllocSet would.  Bounded sorts are the exception; see
+	 * tuplesort_set_bound().
 	 */
-	tuplecontext = AllocSetContextCreate(sortcontext,
-										 "Caller tuples",
-										 ALLOCSET_DEFAULT_SIZES);
+	tuplecontext = BumpContextCreate(sortcontext,
+									 "Caller tuples",
+									 ALLOCSET_DEFAULT_SIZES);
 
 	/*
 	 * Make the Tuplesortstate within the per-sort context.  This way, we
@@ -871,6 +939,8 @@ tuplesort_begin_heap(TupleDesc tupDesc,
 	if (nkeys == 1 && !state->sortKeys->abbrev_converter)
 		state->onlyKey = state->sortKeys;
 
+	state->haveDatum1 = true;
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -966,6 +1036,9 @@ tuplesort_begin_cluster(TupleDesc tupDesc,
 
 	pfree(indexScanKey);
 
+	/* datum1 is only set if the leading index column is a plain column */
+	state->haveDatum1 = (state->indexInfo->ii_IndexAttrNumbers[0] != 0);
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -1044,6 +1117,8 @@ tuplesort_begin_index_btree(Relation heapRel,
 
 	pfree(indexScanKey);
 
+	state->haveDatum1 = true;
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -1095,6 +1170,115 @@ tuplesort_begin_index_hash(Relation heapRel,
 	return state;
 }
 
+Tuplesortstate *
+tuplesort_begin_index_gist(Relation heapRel,
+						   Relation indexRel,
+						   int workMem,
+						   SortCoordinate coordinate,
+						   bool randomAccess)
+{
+	Tuplesortstate *state = tuplesort_begin_common(workMem, coordinate,
+												   randomAccess);
+	MemoryContext oldcontext;
+	int			i;
+
+	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG,
+			 "begin index sort: workMem = %d, randomAccess = %c",
+			 workMem, randomAccess ? 't' : 'f');
+#endif
+
+	state->nKeys = IndexRelationGetNumberOfKeyAttributes(indexRel);
+
+	state->comparetup = comparetup_index_btree;
+	state->copytup = copytup_index;
+	state->writetup = writetup_index;
+	state->readtup = readtup_index;
+	state->abbrevNext = 10;
+
+	state->heapRel = heapRel;
+	state->indexRel = indexRel;
+
+	/* Prepare SortSupport data for each column */
+	state->sortKeys = (SortSupport) palloc0(state->nKeys *
+											sizeof(SortSupportData));
+
+	for (i = 0; i < state->nKeys; i++)
+	{
+		SortSupport sortKey = state->sortKeys + i;
+
+		sortKey->ssup_cxt = CurrentMemoryContext;
+		sortKey->ssup_collation = indexRel->rd_indcollation[i];
+		sortKey->ssup_nulls_first = false;
+		sortKey->ssup_attno = i + 1;
+		/* Convey if abbreviation optimization is applicable in principle */
+		sortKey->abbreviate = (i == 0);
+
+		AssertState(sortKey->ssup_attno != 0);
+
+		/* Look for a sort support function */
+		PrepareSortSupportFromGistIndexRel(indexRel, sortKey);
+	}
+
+	state->haveDatum1 = true;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return state;
+}
+
+/*
+ * Begin a sort of GinBuildTuples, used by parallel GIN index builds.  Tuples
+ * are ordered by index column and key, and then by their first heap TID.
+ */
+Tuplesortstate *
+tuplesort_begin_index_gin(Relation heapRel,
+						  Relation indexRel,
+						  int workMem,
+						  SortCoordinate coordinate,
+						  bool randomAccess)
+{
+	Tuplesortstate *state = tuplesort_begin_common(workMem, coordinate,
+												   randomAccess);
+	MemoryContext oldcontext;
+
+	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG,
+			 "begin index sort: gin, workMem = %d, randomAccess = %c",
+			 workMem, randomAccess ? 't' : 'f');
+#endif
+
+	state->nKeys = IndexRelationGetNumberOfKeyAttributes(indexRel);
+
+	TRACE_POSTGRESQL_SORT_START(INDEX_SORT,
+								false,	/* no unique check */
+								state->nKeys,
+								workMem,
+								randomAccess,
+								PARALLEL_SORT(state));
+
+	state->comparetup = comparetup_index_gin;
+	state->copytup = copytup_index_gin;
+	state->writetup = writetup_index_gin;
+	state->readtup = readtup_index_gin;
+
+	state->heapRel = heapRel;
+	state->indexRel = indexRel;
+
+	state->ginstate = (GinState *) palloc(sizeof(GinState));
+	initGinState(state->ginstate, indexRel);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return state;
+}
+
 Tuplesortstate *
 tuplesort_begin_datum(Oid datumType, Oid sortOperator, Oid sortCollation,
 					  bool nullsFirstFlag, int workMem,
@@ -1165,6 +1349,8 @@ tuplesort_begin_datum(Oid datumType, Oid sortOperator, Oid sortCollation,
 	if (!state->sortKeys->abbrev_converter)
 		state->onlyKey = state->sortKeys;
 
+	state->haveDatum1 = true;
+
 	MemoryContextSwitchTo(oldcontext);
 
 	return state;
@@ -1209,6 +1395,16 @@ tuplesort_set_bound(Tuplesortstate *state, int64 bound)
 	state->bounded = true;
 	state->bound = (int) bound;
 
+	/*
+	 * A bounded sort discards tuples one at a time as it goes, and a bump
+	 * context would never reuse their space.  No tuples have been loaded
+	 * yet, so just replace the tuple context with an AllocSet.
+	 */
+	MemoryContextDelete(state->tuplecontext);
+	state->tuplecontext = AllocSetContextCreate(state->sortcontext,
+												"Caller tuples",
+												ALLOCSET_DEFAULT_SIZES);
+
 	/*
 	 * Bounded sorts are not an effective target for abbreviated key
 	 * optimization.  Disable by setting state to be consistent with no
@@ -1547,6 +1743,28 @@ tuplesort_putindextuplevalues(Tuplesortstate *state, Relation rel,
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * Collect one GinBuildTuple while collecting input data for sort.
+ *
+ * The tuple is copied, so caller may free it afterwards.
+ */
+void
+tuplesort_putgintuple(Tuplesortstate *state, GinBuildTuple *tuple)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(state->sortcontext);
+	SortTuple	stup;
+
+	/*
+	 * Copy the given tuple into memory we control, and decrease availMem.
+	 * Then call the common code.
+	 */
+	COPYTUP(state, &stup, (void *) tuple);
+
+	puttuple_common(state, &stup);
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
 /*
  * Accept one Datum while collecting input data for sort.
  *
@@ -2226,6 +2444,26 @@ tuplesort_getindextuple(Tuplesortstate *state, bool forward)
 	return (IndexTuple) stup.tuple;
 }
 
+/*
+ * Fetch the next GinBuildTuple in either forward or back direction.
+ * Returns NULL if no more tuples.  Returned tuple belongs to tuplesort memory
+ * context, and must not be freed by caller.  Caller may not rely on tuple
+ * remaining valid after any further manipulation of tuplesort.
+ */
+GinBuildTuple *
+tuplesort_getgintuple(Tuplesortstate *state, bool forward)
+{
+	MemoryContext oldcontext = MemoryContextSwitchTo(state->sortcontext);
+	SortTuple	stup;
+
+	if (!tuplesort_gettuple_common(state, forward, &stup))
+		stup.tuple = NULL;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return (GinBuildTuple *) stup.tuple;
+}
+
 /*
  * Fetch the next Datum in either forward or back direction.
  * Returns false if no more datums.
@@ -2999,10 +3237,9 @@ dumptuples(Tuplesortstate *state, bool alltuples)
 
 	/*
 	 * Reset tuple memory.  We've freed all of the tuples that we previously
-	 * allocated.  It's important to avoid fragmentation when there is a stark
-	 * change in the sizes of incoming tuples.  Fragmentation due to
-	 * AllocSetFree's bucketing by size class might be particularly bad if
-	 * this step wasn't taken.
+	 * allocated, but the bump context doesn't reclaim any of that space until
+	 * it is reset.  Doing so here also avoids fragmentation when there is a
+	 * stark change in the sizes of incoming tuples.
 	 */
 	MemoryContextReset(state->tuplecontext);
 
@@ -3314,8 +3551,35 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 	{
 		/* Can we use the single-key sort function? */
 		if (state->onlyKey != NULL)
-			qsort_ssup(state->memtuples, state->memtupcount,
-					   state->onlyKey);
+		{
+			SortSupport onlyKey = state->onlyKey;
+
+			/* Large sorts of integer keys are faster with radix sort */
+			if (onlyKey->comparator == ssup_datum_int32_cmp)
+			{
+				if (!radix_sort_memtuples(state, sizeof(int32)))
+					qsort_ssup_int32(state->memtuples, state->memtupcount,
+									 onlyKey);
+			}
+#ifdef USE_FLOAT8_BYVAL
+			else if (onlyKey->comparator == ssup_datum_signed_cmp)
+			{
+				if (!radix_sort_memtuples(state, sizeof(int64)))
+					qsort_ssup_signed(state->memtuples, state->memtupcount,
+									  onlyKey);
+			}
+#endif
+			else
+				qsort_ssup(state->memtuples, state->memtupcount, onlyKey);
+		}
+		else if (state->haveDatum1 &&
+				 state->sortKeys[0].comparator == ssup_datum_int32_cmp)
+			qsort_tuple_int32(state->memtuples, state->memtupcount, state);
+#ifdef USE_FLOAT8_BYVAL
+		else if (state->haveDatum1 &&
+				 state->sortKeys[0].comparator == ssup_datum_signed_cmp)
+			qsort_tuple_signed(state->memtuples, state->memtupcount, state);
+#endif
 		else
 			qsort_tuple(state->memtuples,
 						state->memtupcount,
@@ -3324,6 +3588,146 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 	}
 }
 
+/*
+ * Map an integer sort key to an unsigned value with the same ordering, for
+ * radix sorting.  Only the low keybytes bytes of the result are meaningful.
+ */
+static inline uint64
+radix_sort_key(Datum datum, int keybytes, bool reverse)
+{
+	uint64		key;
+
+	/* flip the sign bit, so that unsigned order matches signed order */
+	if (keybytes == sizeof(int32))
+		key = (uint32) DatumGetInt32(datum) ^ ((uint32) 1 << 31);
+	else
+		key = (uint64) DatumGetInt64(datum) ^ (UINT64CONST(1) << 63);
+
+	if (reverse)
+		key = ~key;
+
+	return key;
+}
+
+/*
+ * Sort memtuples with a least-significant-digit radix sort, one byte of the
+ * key per pass.
+ *
+ * This is only usable for single-key sorts whose comparator is
+ * ssup_datum_int32_cmp or ssup_datum_signed_cmp, as datum1 then is an
+ * integer that fully determines the sort order.  keybytes is the width of
+ * that integer.  Radix sort needs a second array as large as memtuples, so
+ * returns false without doing anything if there's not enough memory left
+ * for that, or if there are too few tuples for it to be worthwhile.
+ */
+static bool
+radix_sort_memtuples(Tuplesortstate *state, int keybytes)
+{
+	SortSupport ssup = state->onlyKey;
+	SortTuple  *memtuples = state->memtuples;
+	int			memtupcount = state->memtupcount;
+	SortTuple  *aux;
+	SortTuple  *src;
+	SortTuple  *dst;
+	size_t	  (*counts)[256];
+	int			lo;
+	int			hi;
+	int			nkeys;
+	int			i;
+	int			pass;
+
+	if (memtupcount < RADIX_SORT_MIN_TUPLES)
+		return false;
+	if (state->availMem < (int64) (memtupcount * sizeof(SortTuple)))
+		return false;
+
+	/*
+	 * NULLs all sort together, at one end.  Move them there first, and radix
+	 * sort the range of non-NULL keys lo .. hi - 1.
+	 */
+	lo = 0;
+	hi = memtupcount;
+	for (i = 0; i < memtupcount; i++)
+	{
+		if (memtuples[i].isnull1 && ssup->ssup_nulls_first)
+		{
+			SortTuple	tmp = memtuples[lo];
+
+			memtuples[lo++] = memtuples[i];
+			memtuples[i] = tmp;
+		}
+	}
+	for (i = memtupcount - 1; i >= lo; i--)
+	{
+		if (memtuples[i].isnull1 && !ssup->ssup_nulls_first)
+		{
+			SortTuple	tmp = memtuples[--hi];
+
+			memtuples[hi] = memtuples[i];
+			memtuples[i] = tmp;
+		}
+	}
+	nkeys = hi - lo;
+	if (nkeys < 2)
+		return true;
+
+	aux = (SortTuple *) MemoryContextAllocHuge(state->sortcontext,
+											   nkeys * sizeof(SortTuple));
+
+	/* Compute the histograms of all passes at once */
+	counts = palloc0(sizeof(size_t) * 256 * keybytes);
+	for (i = lo; i < hi; i++)
+	{
+		uint64		key = radix_sort_key(memtuples[i].datum1, keybytes,
+										 ssup->ssup_reverse);
+
+		for (pass = 0; pass < keybytes; pass++)
+			counts[pass][(key >> (pass * 8)) & 0xFF]++;
+	}
+
+	src = memtuples + lo;
+	dst = aux;
+	for (pass = 0; pass < keybytes; pass++)
+	{
+		size_t		offsets[256];
+		size_t		offset = 0;
+		uint64		key;
+		int			digit;
+		SortTuple  *tmp;
+
+		/* Nothing to do if all keys have the same value in this byte */
+		key = radix_sort_key(src[0].datum1, keybytes, ssup->ssup_reverse);
+		if (counts[pass][(key >> (pass * 8)) & 0xFF] == nkeys)
+			continue;
+
+		for (digit = 0; digit < 256; digit++)
+		{
+			offsets[digit] = offset;
+			offset += counts[pass][digit];
+		}
+
+		for (i = 0; i < nkeys; i++)
+		{
+			key = radix_sort_key(src[i].datum1, keybytes, ssup->ssup_reverse);
+			dst[offsets[(key >> (pass * 8)) & 0xFF]++] = src[i];
+		}
+
+		tmp = src;
+		src = dst;
+		dst = tmp;
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	if (src != memtuples + lo)
+		memcpy(memtuples + lo, src, nkeys * sizeof(SortTuple));
+
+	pfree(counts);
+	pfree(aux);
+
+	return true;
+}
+
 /*
  * Insert a new tuple into an empty or existing heap, maintaining the
  * heap invariant.  Caller is responsible for ensuring there's room.
@@ -4187,6 +4591,74 @@ readtup_index(Tuplesortstate *state, SortTuple *stup,
 								 &stup->isnull1);
 }
 
+/*
+ * Routines specialized for the GIN index case
+ */
+
+static int
+comparetup_index_gin(const SortTuple *a, const SortTuple *b,
+					 Tuplesortstate *state)
+{
+	return ginCompareBuildTuples(state->ginstate,
+								 (GinBuildTuple *) a->tuple,
+								 (GinBuildTuple *) b->tuple);
+}
+
+static void
+copytup_index_gin(Tuplesortstate *state, SortTuple *stup, void *tup)
+{
+	GinBuildTuple *tuple = (GinBuildTuple *) tup;
+	MemoryContext oldcontext = MemoryContextSwitchTo(state->tuplecontext);
+
+	stup->tuple = palloc(tuple->tuplen);
+	memcpy(stup->tuple, tuple, tuple->tuplen);
+	USEMEM(state, GetMemoryChunkSpace(stup->tuple));
+	/* comparetup_index_gin works on the tuple itself */
+	stup->datum1 = (Datum) 0;
+	stup->isnull1 = false;
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+static void
+writetup_index_gin(Tuplesortstate *state, int tapenum, SortTuple *stup)
+{
+	GinBuildTuple *tuple = (GinBuildTuple *) stup->tuple;
+	unsigned int tuplen;
+
+	tuplen = tuple->tuplen + sizeof(tuplen);
+	LogicalTapeWrite(state->tapeset, tapenum,
+					 (void *) &tuplen, sizeof(tuplen));
+	LogicalTapeWrite(state->tapeset, tapenum,
+					 (void *) tuple, tuple->tuplen);
+	if (state->randomAccess)	/* need trailing length word? */
+		LogicalTapeWrite(state->tapeset, tapenum,
+						 (void *) &tuplen, sizeof(tuplen));
+
+	if (!state->slabAllocatorUsed)
+	{
+		FREEMEM(state, GetMemoryChunkSpace(tuple));
+		pfree(tuple);
+	}
+}
+
+static void
+readtup_index_gin(Tuplesortstate *state, SortTuple *stup,
+				  int tapenum, unsigned int len)
+{
+	unsigned int tuplen = len - sizeof(unsigned int);
+	GinBuildTuple *tuple = (GinBuildTuple *) readtup_alloc(state, tuplen);
+
+	LogicalTapeReadExact(state->tapeset, tapenum,
+						 tuple, tuplen);
+	if (state->randomAccess)	/* need trailing length word? */
+		LogicalTapeReadExact(state->tapeset, tapenum,
+							 &tuplen, sizeof(tuplen));
+	stup->tuple = (void *) tuple;
+	stup->datum1 = (Datum) 0;
+	stup->isnull1 = false;
+}
+
 /*
  * Routines specialized for DatumTuple case
  */
@@ -4358,6 +4830,29 @@ tuplesort_attach_shared(Sharedsort *shared, dsm_segment *seg)
 	SharedFileSetAttach(&shared->fileset, seg);
 }
 
+/*
+ * tuplesort_reset_shared - reset shared tuplesort state for reuse
+ *
+ * Must be called from leader process, after the leader and all workers have
+ * called tuplesort_end() for the previous parallel sort, and before workers
+ * are launched for the next one.  Files left behind by the previous sort are
+ * deleted, since new workers will reuse their names.
+ */
+void
+tuplesort_reset_shared(Sharedsort *shared)
+{
+	int			i;
+
+	SharedFileSetDeleteAll(&shared->fileset);
+
+	shared->currentWorker = 0;
+	shared->workersFinished = 0;
+	for (i = 0; i < shared->nTapes; i++)
+	{
+		shared->tapes[i].firstblocknumber = 0L;
+	}
+}
+
 /*
  * worker_get_identifier - Assign and return ordinal identifier for worker
  *
@@ -4529,3 +5024,37 @@ free_sort_tuple(Tuplesortstate *state, SortTuple *stup)
 	FREEMEM(state, GetMemoryChunkSpace(stup->tuple));
 	pfree(stup->tuple);
 }
+
+/*
+ * Datum comparators for sort keys that compare like plain integers.  See
+ * the declarations in sortsupport.h.
+ */
+#ifdef USE_FLOAT8_BYVAL
+int
+ssup_datum_signed_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	int64		xx = DatumGetInt64(x);
+	int64		yy = DatumGetInt64(y);
+
+	if (xx < yy)
+		return -1;
+	else if (xx > yy)
+		return 1;
+	else
+		return 0;
+}
+#endif
+
+int
+ssup_datum_int32_cmp(Datum x, Datum y, SortSupport ssup)
+{
+	int32		xx = DatumGetInt32(x);
+	int32		yy = DatumGetInt32(y);
+
+	if (xx < yy)
+		return -1;
+	else if (xx > yy)
+		return 1;
+	else
+		return 0;
+}
@@ -74,6 +74,7 @@ typedef struct WriteTarState
 	pgoff_t		filesz;
 #ifdef HAVE_LIBZ
 	gzFile		ztarfile;
+	z_stream   *progresszs;		/* to count uncompressed size for progress */
 #endif
 } WriteTarState;
 
@@ -123,6 +124,7 @@ static bool checksum_failure = false;
 static bool showprogress = false;
 static int	verbose = 0;
 static int	compresslevel = 0;
+static int	server_compresslevel = 0;
 static IncludeWal includewal = STREAM_WAL;
 static bool fastcheckpoint = false;
 static bool writerecoveryconf = false;
@@ -135,6 +137,7 @@ static bool temp_replication_slot = true;
 static bool create_slot = false;
 static bool no_slot = false;
 static bool verify_checksums = true;
+static char *incremental_lsn = NULL;
 
 static bool success = false;
 static bool made_new_pgdata = false;
@@ -177,6 +180,9 @@ static void progress_report(int tablespacenum, const char *filename, bool force)
 
 static void ReceiveTarFile(PGconn *conn, PGresult *res, int rownum);
 static void ReceiveTarCopyChunk(size_t r, char *copybuf, void *callback_data);
+#ifdef HAVE_LIBZ
+static size_t CountDecompressedBytes(z_stream *zs, char *buf, size_t r);
+#endif
 static void ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum);
 static void ReceiveTarAndUnpackCopyChunk(size_t r, char *copybuf,
 										 void *callback_data);
@@ -372,10 +378,13 @@ usage(void)
 			 "                         include required WAL files with specified method\n"));
 	printf(_("  -z, --gzip             compress tar output\n"));
 	printf(_("  -Z, --compress=0-9     compress tar output with given compression level\n"));
+	printf(_("      --server-compress=1-9\n"
+			 "                         have the server compress the backup with given level\n"));
 	printf(_("\nGeneral options:\n"));
 	printf(_("  -c, --checkpoint=fast|spread\n"
 			 "                         set fast or spread checkpointing\n"));
 	printf(_("  -C, --create-slot      create replication slot\n"));
+	printf(_("  -i, --incremental=LSN  only send relation blocks changed since LSN\n"));
 	printf(_("  -l, --label=LABEL      set backup label\n"));
 	printf(_("  -n, --no-clean         do not clean up after errors\n"));
 	printf(_("  -N, --no-sync          do not wait for changes to be written safely to disk\n"));
@@ -916,9 +925,13 @@ parse_max_rate(char *src)
  */
 static void
 ReceiveCopyData(PGconn *conn, WriteDataCallback callback,
-				void *callback_data)
+				void *callback_data, bool decompress)
 {
 	PGresult   *res;
+#ifdef HAVE_LIBZ
+	z_stream	zs;
+	char		zbuf[32768];
+#endif
 
 	/* Get the COPY data stream. */
 	res = PQgetResult(conn);
@@ -930,6 +943,21 @@ ReceiveCopyData(PGconn *conn, WriteDataCallback callback,
 	}
 	PQclear(res);
 
+#ifdef HAVE_LIBZ
+	if (decompress)
+	{
+		memset(&zs, 0, sizeof(zs));
+		/* windowBits 15 plus 32 accepts a gzip header */
+		if (inflateInit2(&zs, 15 + 32) != Z_OK)
+		{
+			pg_log_error("could not initialize compression library");
+			exit(1);
+		}
+	}
+#else
+	Assert(!decompress);
+#endif
+
 	/* Loop over chunks until done. */
 	while (1)
 	{
@@ -949,10 +977,46 @@ ReceiveCopyData(PGconn *conn, WriteDataCallback callback,
 			exit(1);
 		}
 
-		(*callback) (r, copybuf, callback_data);
+#ifdef HAVE_LIBZ
+		if (decompress)
+		{
+			/*
+			 * The server compressed the stream, so inflate it and pass the
+			 * uncompressed data on to the callback.
+			 */
+			zs.next_in = (Bytef *) copybuf;
+			zs.avail_in = r;
+			while (1)
+			{
+				int			zr;
+
+				zs.next_out = (Bytef *) zbuf;
+				zs.avail_out = sizeof(zbuf);
+				zr = inflate(&zs, Z_NO_FLUSH);
+				if (zr != Z_OK && zr != Z_STREAM_END && zr != Z_BUF_ERROR)
+				{
+					pg_log_error("could not decompress data: %s",
+								 zs.msg ? zs.msg : "unknown error");
+					exit(1);
+				}
+				if (zs.avail_out < sizeof(zbuf))
+					(*callback) (sizeof(zbuf) - zs.avail_out, zbuf,
+								 callback_data);
+				if (zs.avail_out != 0 || zr == Z_STREAM_END)
+					break;
+			}
+		}
+		else
+#endif
+			(*callback) (r, copybuf, callback_data);
 
 		PQfreemem(copybuf);
 	}
+
+#ifdef HAVE_LIBZ
+	if (decompress)
+		inflateEnd(&zs);
+#endif
 }
 
 /*
@@ -983,6 +1047,49 @@ writeTarData(WriteTarState *state, char *buf, int r)
 	}
 }
 
+#ifdef HAVE_LIBZ
+/*
+ * Write a piece of tar data as a gzip member of its own.  This is used to
+ * append data to a tar file that was compressed by the server, which we
+ * write out as-is; a sequence of gzip members is a valid gzip file.
+ */
+static void
+writeTarDataAsGzipMember(WriteTarState *state, char *buf, int r)
+{
+	z_stream	zs;
+	char	   *out;
+	uLong		outlen;
+
+	memset(&zs, 0, sizeof(zs));
+	if (deflateInit2(&zs, server_compresslevel, Z_DEFLATED, 15 + 16, 8,
+					 Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		pg_log_error("could not initialize compression library");
+		exit(1);
+	}
+
+	/* leave room for the gzip header and trailer, too */
+	outlen = deflateBound(&zs, r) + 18;
+	out = pg_malloc(outlen);
+
+	zs.next_in = (Bytef *) buf;
+	zs.avail_in = r;
+	zs.next_out = (Bytef *) out;
+	zs.avail_out = outlen;
+	if (deflate(&zs, Z_FINISH) != Z_STREAM_END)
+	{
+		pg_log_error("could not compress data: %s",
+					 zs.msg ? zs.msg : "unknown error");
+		exit(1);
+	}
+
+	writeTarData(state, out, outlen - zs.avail_out);
+
+	deflateEnd(&zs);
+	pg_free(out);
+}
+#endif
+
 /*
  * Receive a tar format file from the connection to the server, and write
  * the data from this file directly into a tar file. If compression is
@@ -991,6 +1098,10 @@ writeTarData(WriteTarState *state, char *buf, int r)
  * The file will be named base.tar[.gz] if it's for the main data directory
  * or <tablespaceoid>.tar[.gz] if it's for another tablespace.
  *
+ * If the server compressed the stream, it is written to the file as-is,
+ * unless we need to add the recovery configuration to it.  In that case,
+ * it is decompressed and compressed again locally at the same level.
+ *
  * No attempt to inspect or validate the contents of the file is done.
  */
 static void
@@ -998,6 +1109,9 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 {
 	char		zerobuf[1024];
 	WriteTarState state;
+	int			tarcompresslevel = compresslevel;
+	bool		decompress = false;
+	bool		server_compressed = false;
 
 	memset(&state, 0, sizeof(state));
 	state.tablespacenum = rownum;
@@ -1008,6 +1122,17 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 	if (PQserverVersion(conn) >= MINIMUM_VERSION_FOR_RECOVERY_GUC)
 		state.is_recovery_guc_supported = true;
 
+	if (server_compresslevel != 0)
+	{
+		if (state.basetablespace && writerecoveryconf)
+		{
+			decompress = true;
+			tarcompresslevel = server_compresslevel;
+		}
+		else
+			server_compressed = true;
+	}
+
 	if (state.basetablespace)
 	{
 		/*
@@ -1020,14 +1145,14 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 #endif
 
 #ifdef HAVE_LIBZ
-			if (compresslevel != 0)
+			if (tarcompresslevel != 0)
 			{
 				state.ztarfile = gzdopen(dup(fileno(stdout)), "wb");
-				if (gzsetparams(state.ztarfile, compresslevel,
+				if (gzsetparams(state.ztarfile, tarcompresslevel,
 								Z_DEFAULT_STRATEGY) != Z_OK)
 				{
 					pg_log_error("could not set compression level %d: %s",
-								 compresslevel, get_gz_error(state.ztarfile));
+								 tarcompresslevel, get_gz_error(state.ztarfile));
 					exit(1);
 				}
 			}
@@ -1039,16 +1164,16 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 		else
 		{
 #ifdef HAVE_LIBZ
-			if (compresslevel != 0)
+			if (tarcompresslevel != 0)
 			{
 				snprintf(state.filename, sizeof(state.filename),
 						 "%s/base.tar.gz", basedir);
 				state.ztarfile = gzopen(state.filename, "wb");
-				if (gzsetparams(state.ztarfile, compresslevel,
+				if (gzsetparams(state.ztarfile, tarcompresslevel,
 								Z_DEFAULT_STRATEGY) != Z_OK)
 				{
 					pg_log_error("could not set compression level %d: %s",
-								 compresslevel, get_gz_error(state.ztarfile));
+								 tarcompresslevel, get_gz_error(state.ztarfile));
 					exit(1);
 				}
 			}
@@ -1056,7 +1181,8 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 #endif
 			{
 				snprintf(state.filename, sizeof(state.filename),
-						 "%s/base.tar", basedir);
+						 "%s/base.tar%s", basedir,
+						 server_compressed ? ".gz" : "");
 				state.tarfile = fopen(state.filename, "wb");
 			}
 		}
@@ -1067,31 +1193,32 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 		 * Specific tablespace
 		 */
 #ifdef HAVE_LIBZ
-		if (compresslevel != 0)
+		if (tarcompresslevel != 0)
 		{
 			snprintf(state.filename, sizeof(state.filename),
 					 "%s/%s.tar.gz",
 					 basedir, PQgetvalue(res, rownum, 0));
 			state.ztarfile = gzopen(state.filename, "wb");
-			if (gzsetparams(state.ztarfile, compresslevel,
+			if (gzsetparams(state.ztarfile, tarcompresslevel,
 							Z_DEFAULT_STRATEGY) != Z_OK)
 			{
 				pg_log_error("could not set compression level %d: %s",
-							 compresslevel, get_gz_error(state.ztarfile));
+							 tarcompresslevel, get_gz_error(state.ztarfile));
 				exit(1);
 			}
 		}
 		else
 #endif
 		{
-			snprintf(state.filename, sizeof(state.filename), "%s/%s.tar",
-					 basedir, PQgetvalue(res, rownum, 0));
+			snprintf(state.filename, sizeof(state.filename), "%s/%s.tar%s",
+					 basedir, PQgetvalue(res, rownum, 0),
+					 server_compressed ? ".gz" : "");
 			state.tarfile = fopen(state.filename, "wb");
 		}
 	}
 
 #ifdef HAVE_LIBZ
-	if (compresslevel != 0)
+	if (tarcompresslevel != 0)
 	{
 		if (!state.ztarfile)
 		{
@@ -1104,7 +1231,7 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 	else
 #endif
 	{
-		/* Either no zlib support, or zlib support but compresslevel = 0 */
+		/* Either no zlib support, or zlib support but no local compression */
 		if (!state.tarfile)
 		{
 			pg_log_error("could not create file \"%s\": %m", state.filename);
@@ -1112,7 +1239,33 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 		}
 	}
 
-	ReceiveCopyData(conn, ReceiveTarCopyChunk, &state);
+#ifdef HAVE_LIBZ
+
+	/*
+	 * The server's size estimate is of the uncompressed data, so when
+	 * writing out compressed data as-is, inflate it as well just to count it.
+	 */
+	if (server_compressed && showprogress)
+	{
+		state.progresszs = pg_malloc0(sizeof(z_stream));
+		/* windowBits 15 plus 32 accepts a gzip header */
+		if (inflateInit2(state.progresszs, 15 + 32) != Z_OK)
+		{
+			pg_log_error("could not initialize compression library");
+			exit(1);
+		}
+	}
+#endif
+
+	ReceiveCopyData(conn, ReceiveTarCopyChunk, &state, decompress);
+
+#ifdef HAVE_LIBZ
+	if (state.progresszs != NULL)
+	{
+		inflateEnd(state.progresszs);
+		pg_free(state.progresszs);
+	}
+#endif
 
 	/*
 	 * End of copy data. If requested, and this is the base tablespace, write
@@ -1171,7 +1324,12 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 	}
 
 	/* 2 * 512 bytes empty data at end of file */
-	writeTarData(&state, zerobuf, sizeof(zerobuf));
+#ifdef HAVE_LIBZ
+	if (server_compressed)
+		writeTarDataAsGzipMember(&state, zerobuf, sizeof(zerobuf));
+	else
+#endif
+		writeTarData(&state, zerobuf, sizeof(zerobuf));
 
 #ifdef HAVE_LIBZ
 	if (state.ztarfile != NULL)
@@ -1389,10 +1547,51 @@ ReceiveTarCopyChunk(size_t r, char *copybuf, void *callback_data)
 			}
 		}
 	}
-	totaldone += r;
+
+#ifdef HAVE_LIBZ
+	if (state->progresszs != NULL)
+		totaldone += CountDecompressedBytes(state->progresszs, copybuf, r);
+	else
+#endif
+		totaldone += r;
 	progress_report(state->tablespacenum, state->filename, false);
 }
 
+#ifdef HAVE_LIBZ
+/*
+ * Return the uncompressed size of a chunk of a gzip stream, throwing away
+ * the uncompressed data itself.
+ */
+static size_t
+CountDecompressedBytes(z_stream *zs, char *buf, size_t r)
+{
+	char		zbuf[32768];
+	size_t		count = 0;
+
+	zs->next_in = (Bytef *) buf;
+	zs->avail_in = r;
+	while (1)
+	{
+		int			zr;
+
+		zs->next_out = (Bytef *) zbuf;
+		zs->avail_out = sizeof(zbuf);
+		zr = inflate(zs, Z_NO_FLUSH);
+		if (zr != Z_OK && zr != Z_STREAM_END && zr != Z_BUF_ERROR)
+		{
+			pg_log_error("could not decompress data: %s",
+						 zs->msg ? zs->msg : "unknown error");
+			exit(1);
+		}
+		count += sizeof(zbuf) - zs->avail_out;
+		if (zs->avail_out != 0 || zr == Z_STREAM_END)
+			break;
+	}
+
+	return count;
+}
+#endif
+
 
 /*
  * Retrieve tablespace path, either relocated or original depending on whether
@@ -1442,7 +1641,8 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 				get_tablespace_mapping(PQgetvalue(res, rownum, 1)),
 				sizeof(state.current_path));
 
-	ReceiveCopyData(conn, ReceiveTarAndUnpackCopyChunk, &state);
+	ReceiveCopyData(conn, ReceiveTarAndUnpackCopyChunk, &state,
+					server_compresslevel != 0);
 
 
 	if (state.file)
@@ -1651,6 +1851,8 @@ BaseBackup(void)
 	char	   *basebkp;
 	char		escaped_label[MAXPGPATH];
 	char	   *maxrate_clause = NULL;
+	char	   *incremental_clause = NULL;
+	char	   *compression_clause = NULL;
 	int			i;
 	char		xlogstart[64];
 	char		xlogend[64];
@@ -1678,6 +1880,24 @@ BaseBackup(void)
 		exit(1);
 	}
 
+	if (incremental_lsn && serverMajor < 1300)
+	{
+		const char *serverver = PQparameterStatus(conn, "server_version");
+
+		pg_log_error("incremental backups are not supported by server version %s",
+					 serverver ? serverver : "'unknown'");
+		exit(1);
+	}
+
+	if (server_compresslevel != 0 && serverMajor < 1300)
+	{
+		const char *serverver = PQparameterStatus(conn, "server_version");
+
+		pg_log_error("server-side compression is not supported by server version %s",
+					 serverver ? serverver : "'unknown'");
+		exit(1);
+	}
+
 	/*
 	 * If WAL streaming was requested, also check that the server is new
 	 * enough for that.
@@ -1712,6 +1932,12 @@ BaseBackup(void)
 	if (maxrate > 0)
 		maxrate_clause = psprintf("MAX_RATE %u", maxrate);
 
+	if (incremental_lsn)
+		incremental_clause = psprintf("INCREMENTAL '%s'", incremental_lsn);
+
+	if (server_compresslevel != 0)
+		compression_clause = psprintf("COMPRESSION %d", server_compresslevel);
+
 	if (verbose)
 		pg_log_info("initiating base backup, waiting for checkpoint to complete");
 
@@ -1725,7 +1951,7 @@ BaseBackup(void)
 	}
 
 	basebkp =
-		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s",
+		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s %s %s",
 				 escaped_label,
 				 showprogress ? "PROGRESS" : "",
 				 includewal == FETCH_WAL ? "WAL" : "",
@@ -1733,7 +1959,9 @@ BaseBackup(void)
 				 includewal == NO_WAL ? "" : "NOWAIT",
 				 maxrate_clause ? maxrate_clause : "",
 				 format == 't' ? "TABLESPACE_MAP" : "",
-				 verify_checksums ? "" : "NOVERIFY_CHECKSUMS");
+				 verify_checksums ? "" : "NOVERIFY_CHECKSUMS",
+				 incremental_clause ? incremental_clause : "",
+				 compression_clause ? compression_clause : "");
 
 	if (PQsendQuery(conn, basebkp) == 0)
 	{
@@ -2030,6 +2258,7 @@ main(int argc, char **argv)
 		{"format", required_argument, NULL, 'F'},
 		{"checkpoint", required_argument, NULL, 'c'},
 		{"create-slot", no_argument, NULL, 'C'},
+		{"incremental", required_argument, NULL, 'i'},
 		{"max-rate", required_argument, NULL, 'r'},
 		{"write-recovery-conf", no_argument, NULL, 'R'},
 		{"slot", required_argument, NULL, 'S'},
@@ -2052,6 +2281,7 @@ main(int argc, char **argv)
 		{"waldir", required_argument, NULL, 1},
 		{"no-slot", no_argument, NULL, 2},
 		{"no-verify-checksums", no_argument, NULL, 3},
+		{"server-compress", required_argument, NULL, 4},
 		{NULL, 0, NULL, 0}
 	};
 	int			c;
@@ -2079,7 +2309,7 @@ main(int argc, char **argv)
 
 	atexit(cleanup_directories_atexit);
 
-	while ((c = getopt_long(argc, argv, "CD:F:r:RS:T:X:l:nNzZ:d:c:h:p:U:s:wWkvP",
+	while ((c = getopt_long(argc, argv, "CD:F:i:r:RS:T:X:l:nNzZ:d:c:h:p:U:s:wWkvP",
 							long_options, &option_index)) != -1)
 	{
 		switch (c)
@@ -2087,6 +2317,20 @@ main(int argc, char **argv)
 			case 'C':
 				create_slot = true;
 				break;
+			case 'i':
+				{
+					uint32		hi,
+								lo;
+
+					if (sscanf(optarg, "%X/%X", &hi, &lo) != 2)
+					{
+						pg_log_error("invalid incremental backup location \"%s\"",
+									 optarg);
+						exit(1);
+					}
+					incremental_lsn = pg_strdup(optarg);
+				}
+				break;
 			case 'D':
 				basedir = pg_strdup(optarg);
 				break;
@@ -2220,6 +2464,14 @@ main(int argc, char **argv)
 			case 3:
 				verify_checksums = false;
 				break;
+			case 4:
+				server_compresslevel = atoi(optarg);
+				if (server_compresslevel < 1 || server_compresslevel > 9)
+				{
+					pg_log_error("invalid compression level \"%s\"", optarg);
+					exit(1);
+				}
+				break;
 			default:
 
 				/*
@@ -2265,6 +2517,14 @@ main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (server_compresslevel != 0 && compresslevel != 0)
+	{
+		pg_log_error("cannot use both client-side and server-side compression");
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+
 	if (format == 't' && includewal == STREAM_WAL && strcmp(basedir, "-") == 0)
 	{
 		pg_log_error("cannot stream write-ahead logs in tar mode to stdout");
@@ -2335,7 +2595,7 @@ main(int argc, char **argv)
 	}
 
 #ifndef HAVE_LIBZ
-	if (compresslevel != 0)
+	if (compresslevel != 0 || server_compresslevel != 0)
 	{
 		pg_log_error("this build does not support compression");
 		exit(1);
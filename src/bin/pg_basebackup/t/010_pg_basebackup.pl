@@ -4,9 +4,10 @@ use Cwd;
 use Config;
 use File::Basename qw(basename dirname);
 use File::Path qw(rmtree);
+use IO::Uncompress::Gunzip qw(gunzip $GunzipError);
 use PostgresNode;
 use TestLib;
-use Test::More tests => 106;
+use Test::More tests => 114;
 
 program_help_ok('pg_basebackup');
 program_version_ok('pg_basebackup');
@@ -174,6 +175,55 @@ $node->command_ok([ 'pg_basebackup', '-D', "$tempdir/tarbackup", '-Ft' ],
 ok(-f "$tempdir/tarbackup/base.tar", 'backup tar was created');
 rmtree("$tempdir/tarbackup");
 
+SKIP:
+{
+	skip "postgres was not built with ZLIB support", 8
+	  if (!check_pg_config("#define HAVE_LIBZ 1"));
+
+	$node->command_ok(
+		[
+			'pg_basebackup', '-D', "$tempdir/tarbackup_sc", '-Ft',
+			'--server-compress=5'
+		],
+		'tar format with server-side compression');
+	ok(-f "$tempdir/tarbackup_sc/base.tar.gz",
+		'compressed backup tar was created');
+	rmtree("$tempdir/tarbackup_sc");
+
+	$node->command_ok(
+		[ 'pg_basebackup', '-D', "$tempdir/backup_sc", '--server-compress=1' ],
+		'plain format with server-side compression');
+	ok(-f "$tempdir/backup_sc/PG_VERSION", 'backup was unpacked');
+	rmtree("$tempdir/backup_sc");
+
+	# With -R, the main tar file is decompressed and compressed again so
+	# that the recovery configuration can be added to it.
+	$node->command_ok(
+		[
+			'pg_basebackup', '-D', "$tempdir/tarbackup_scR", '-Ft', '-R',
+			'-P', '--server-compress=5'
+		],
+		'tar format with server-side compression and -R');
+	my $tar;
+	gunzip("$tempdir/tarbackup_scR/base.tar.gz" => \$tar, MultiStream => 1)
+	  or die "gunzip failed: $GunzipError";
+	like($tar, qr/standby\.signal/,
+		'compressed backup tar contains standby.signal');
+	my $port = $node->port;
+	like(
+		$tar,
+		qr/primary_conninfo = '.*port=$port.*'\n/,
+		'compressed backup tar sets primary_conninfo');
+	rmtree("$tempdir/tarbackup_scR");
+
+	$node->command_fails(
+		[
+			'pg_basebackup', '-D', "$tempdir/tarbackup_sc", '-Ft', '-z',
+			'--server-compress=1'
+		],
+		'client-side and server-side compression cannot be combined');
+}
+
 $node->command_fails(
 	[ 'pg_basebackup', '-D', "$tempdir/backup_foo", '-Fp', "-T=/foo" ],
 	'-T with empty old directory fails');
@@ -0,0 +1,751 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_combinebackup.c
+ *	  Combine a full base backup with incremental backups taken after it,
+ *	  reconstructing a data directory that can be started.
+ *
+ * An incremental backup has the same layout as a full one, except that
+ * relation files that have changed only partly are stored as
+ * INCREMENTAL.<filename>, containing just the modified blocks (see
+ * replication/basebackup.h).  The newest backup determines which files
+ * exist in the result: each of its files is copied, or reconstructed by
+ * taking the most recent full copy of the file from an earlier backup and
+ * applying the incremental files that follow it, in order.  A relation
+ * created after an earlier backup is reconstructed from the first
+ * incremental file that contains all of its blocks.
+ *
+ * Copyright (c) 2010-2020, PostgreSQL Global Development Group
+ *
+ * IDENTIFICATION
+ *	  src/bin/pg_combinebackup/pg_combinebackup.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres_fe.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "access/xlogdefs.h"
+#include "common/controldata_utils.h"
+#include "common/file_perm.h"
+#include "common/file_utils.h"
+#include "common/logging.h"
+#include "getopt_long.h"
+#include "replication/basebackup.h"
+
+/* Information about one of the backups given on the command line */
+typedef struct BackupInfo
+{
+	char	   *path;
+	XLogRecPtr	start_lsn;		/* START WAL LOCATION */
+	XLogRecPtr	incremental_lsn;	/* INCREMENTAL FROM LSN, or invalid */
+	uint64		system_identifier;
+} BackupInfo;
+
+static BackupInfo *backups;
+static int	nbackups;
+
+static char *output_dir = NULL;
+static bool do_sync = true;
+static bool success = false;
+static bool made_output_dir = false;
+static bool found_output_dir = false;
+
+static const char *progname;
+
+static void usage(void);
+static void cleanup_directories_atexit(void);
+static void read_backup_info(BackupInfo *backup);
+static void check_no_tablespaces(BackupInfo *backup);
+static void combine_directory(const char *relpath);
+static void reconstruct_file(const char *relpath, const char *filename);
+static int	read_incremental_header(const char *incpath,
+									IncrementalFileHeader *hdr,
+									uint32 **blocks);
+static bool incremental_file_is_complete(const char *incpath);
+static void apply_incremental_file(const char *incpath, const char *outpath);
+static void copy_file(const char *src, const char *dst);
+static void write_backup_label(const char *src, const char *dst);
+
+static void
+usage(void)
+{
+	printf(_("%s reconstructs a data directory from a full base backup and later incremental backups.\n\n"),
+		   progname);
+	printf(_("Usage:\n"));
+	printf(_("  %s [OPTION]... BACKUPDIR...\n"), progname);
+	printf(_("\nOptions:\n"));
+	printf(_("  -o, --output=DIRECTORY write the combined backup into directory\n"));
+	printf(_("  -N, --no-sync          do not wait for changes to be written safely to disk\n"));
+	printf(_("  -V, --version          output version information, then exit\n"));
+	printf(_("  -?, --help             show this help, then exit\n"));
+	printf(_("\nThe backups must be given from oldest to newest, starting with a full\n"
+			 "backup, each incremental backup being based on the one before it.\n\n"));
+	printf(_("Report bugs to <pgsql-bugs@lists.postgresql.org>.\n"));
+}
+
+static void
+cleanup_directories_atexit(void)
+{
+	if (success)
+		return;
+
+	if (made_output_dir)
+	{
+		pg_log_info("removing output directory \"%s\"", output_dir);
+		if (!rmtree(output_dir, true))
+			pg_log_error("failed to remove output directory");
+	}
+	else if (found_output_dir)
+	{
+		pg_log_info("removing contents of output directory \"%s\"", output_dir);
+		if (!rmtree(output_dir, false))
+			pg_log_error("failed to remove contents of output directory");
+	}
+}
+
+/*
+ * Read the backup_label and pg_control files of a backup.
+ */
+static void
+read_backup_info(BackupInfo *backup)
+{
+	char		path[MAXPGPATH];
+	char		line[MAXPGPATH];
+	FILE	   *fp;
+	uint32		hi,
+				lo;
+	ControlFileData *controlfile;
+	bool		crc_ok;
+
+	snprintf(path, sizeof(path), "%s/backup_label", backup->path);
+	fp = fopen(path, "r");
+	if (fp == NULL)
+	{
+		pg_log_error("could not open file \"%s\": %m", path);
+		exit(1);
+	}
+
+	backup->start_lsn = InvalidXLogRecPtr;
+	backup->incremental_lsn = InvalidXLogRecPtr;
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		if (sscanf(line, "START WAL LOCATION: %X/%X", &hi, &lo) == 2)
+			backup->start_lsn = ((uint64) hi) << 32 | lo;
+		else if (sscanf(line, "INCREMENTAL FROM LSN: %X/%X", &hi, &lo) == 2)
+			backup->incremental_lsn = ((uint64) hi) << 32 | lo;
+	}
+	if (ferror(fp))
+	{
+		pg_log_error("could not read file \"%s\": %m", path);
+		exit(1);
+	}
+	fclose(fp);
+
+	if (XLogRecPtrIsInvalid(backup->start_lsn))
+	{
+		pg_log_error("could not find START WAL LOCATION in file \"%s\"", path);
+		exit(1);
+	}
+
+	controlfile = get_controlfile(backup->path, &crc_ok);
+	if (!crc_ok)
+	{
+		pg_log_error("pg_control CRC value is incorrect in backup \"%s\"",
+					 backup->path);
+		exit(1);
+	}
+	backup->system_identifier = controlfile->system_identifier;
+	pg_free(controlfile);
+}
+
+/*
+ * User-defined tablespaces are stored outside the data directory of a plain
+ * format backup, so we can't combine them.
+ */
+static void
+check_no_tablespaces(BackupInfo *backup)
+{
+	char		path[MAXPGPATH];
+	DIR		   *dir;
+	struct dirent *de;
+
+	snprintf(path, sizeof(path), "%s/pg_tblspc", backup->path);
+	dir = opendir(path);
+	if (dir == NULL)
+	{
+		pg_log_error("could not open directory \"%s\": %m", path);
+		exit(1);
+	}
+	while (errno = 0, (de = readdir(dir)) != NULL)
+	{
+		if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+			continue;
+
+		pg_log_error("backup \"%s\" contains tablespaces, which are not supported",
+					 backup->path);
+		exit(1);
+	}
+	if (errno)
+	{
+		pg_log_error("could not read directory \"%s\": %m", path);
+		exit(1);
+	}
+	closedir(dir);
+}
+
+/*
+ * Recreate the directory "relpath" of the newest backup in the output
+ * directory, with all its files and subdirectories.
+ */
+static void
+combine_directory(const char *relpath)
+{
+	BackupInfo *newest = &backups[nbackups - 1];
+	char		srcdir[MAXPGPATH];
+	DIR		   *dir;
+	struct dirent *de;
+
+	snprintf(srcdir, sizeof(srcdir), "%s/%s", newest->path, relpath);
+	dir = opendir(srcdir);
+	if (dir == NULL)
+	{
+		pg_log_error("could not open directory \"%s\": %m", srcdir);
+		exit(1);
+	}
+
+	while (errno = 0, (de = readdir(dir)) != NULL)
+	{
+		char		srcpath[MAXPGPATH];
+		char		dstpath[MAXPGPATH];
+		char		entryrelpath[MAXPGPATH];
+		struct stat st;
+
+		if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+			continue;
+
+		if (relpath[0] == '\0')
+			strlcpy(entryrelpath, de->d_name, sizeof(entryrelpath));
+		else
+			snprintf(entryrelpath, sizeof(entryrelpath), "%s/%s",
+					 relpath, de->d_name);
+		snprintf(srcpath, sizeof(srcpath), "%s/%s", newest->path, entryrelpath);
+		snprintf(dstpath, sizeof(dstpath), "%s/%s", output_dir, entryrelpath);
+
+		/* Follow symbolic links, such as a pg_wal created with --waldir */
+		if (stat(srcpath, &st) != 0)
+		{
+			pg_log_error("could not stat file \"%s\": %m", srcpath);
+			exit(1);
+		}
+
+		if (S_ISDIR(st.st_mode))
+		{
+			if (mkdir(dstpath, pg_dir_create_mode) != 0)
+			{
+				pg_log_error("could not create directory \"%s\": %m", dstpath);
+				exit(1);
+			}
+			combine_directory(entryrelpath);
+		}
+		else if (!S_ISREG(st.st_mode))
+			pg_log_warning("skipping special file \"%s\"", srcpath);
+		else if (strncmp(de->d_name, INCREMENTAL_PREFIX,
+						 INCREMENTAL_PREFIX_LENGTH) == 0)
+			reconstruct_file(relpath, de->d_name + INCREMENTAL_PREFIX_LENGTH);
+		else if (relpath[0] == '\0' && strcmp(de->d_name, "backup_label") == 0)
+			write_backup_label(srcpath, dstpath);
+		else
+			copy_file(srcpath, dstpath);
+	}
+	if (errno)
+	{
+		pg_log_error("could not read directory \"%s\": %m", srcdir);
+		exit(1);
+	}
+	closedir(dir);
+}
+
+/*
+ * Reconstruct relation file "filename" in directory "relpath", which is
+ * incremental in the newest backup.
+ */
+static void
+reconstruct_file(const char *relpath, const char *filename)
+{
+	char		path[MAXPGPATH];
+	char		outpath[MAXPGPATH];
+	struct stat st;
+	bool		copied = false;
+	int			first;
+	int			i;
+
+	snprintf(outpath, sizeof(outpath), "%s/%s/%s", output_dir, relpath, filename);
+
+	/*
+	 * Find the most recent backup containing a full copy of the file.  All
+	 * backups after it must contain an incremental file for it.  A relation
+	 * created after an earlier backup has all of its blocks in the first
+	 * incremental file taken after that, since they were all written through
+	 * WAL, so we can start from an empty file instead.  Otherwise, the file
+	 * was created without going through WAL, and we can't know its contents.
+	 */
+	for (first = nbackups - 1; first > 0; first--)
+	{
+		snprintf(path, sizeof(path), "%s/%s/%s%s",
+				 backups[first].path, relpath, INCREMENTAL_PREFIX, filename);
+		if (incremental_file_is_complete(path))
+			break;
+
+		snprintf(path, sizeof(path), "%s/%s/%s",
+				 backups[first - 1].path, relpath, filename);
+		if (stat(path, &st) == 0)
+		{
+			copy_file(path, outpath);
+			copied = true;
+			break;
+		}
+		else if (errno != ENOENT)
+		{
+			pg_log_error("could not stat file \"%s\": %m", path);
+			exit(1);
+		}
+
+		snprintf(path, sizeof(path), "%s/%s/%s%s",
+				 backups[first - 1].path, relpath, INCREMENTAL_PREFIX,
+				 filename);
+		if (stat(path, &st) != 0)
+		{
+			pg_log_error("file \"%s/%s\" is incremental in backup \"%s\", but not present in backup \"%s\"",
+						 relpath, filename, backups[first].path,
+						 backups[first - 1].path);
+			exit(1);
+		}
+	}
+	if (first == 0)
+	{
+		pg_log_error("could not find a full copy of file \"%s/%s\"",
+					 relpath, filename);
+		exit(1);
+	}
+
+	if (!copied)
+	{
+		int			fd;
+
+		if ((fd = open(outpath, O_RDWR | O_CREAT | O_EXCL | PG_BINARY,
+					   pg_file_create_mode)) < 0)
+		{
+			pg_log_error("could not create file \"%s\": %m", outpath);
+			exit(1);
+		}
+		close(fd);
+	}
+
+	for (i = first; i < nbackups; i++)
+	{
+		snprintf(path, sizeof(path), "%s/%s/%s%s",
+				 backups[i].path, relpath, INCREMENTAL_PREFIX, filename);
+		apply_incremental_file(path, outpath);
+	}
+}
+
+/*
+ * Read the header and the block numbers of an incremental file.  The caller
+ * must free *blocks.
+ */
+static int
+read_incremental_header(const char *incpath, IncrementalFileHeader *hdr,
+						uint32 **blocks)
+{
+	int			fd;
+	int			rb;
+
+	if ((fd = open(incpath, O_RDONLY | PG_BINARY, 0)) < 0)
+	{
+		pg_log_error("could not open file \"%s\": %m", incpath);
+		exit(1);
+	}
+
+	rb = read(fd, hdr, sizeof(IncrementalFileHeader));
+	if (rb != sizeof(IncrementalFileHeader) || hdr->magic != INCREMENTAL_MAGIC)
+	{
+		if (rb < 0)
+			pg_log_error("could not read file \"%s\": %m", incpath);
+		else
+			pg_log_error("file \"%s\" is not a valid incremental file", incpath);
+		exit(1);
+	}
+
+	*blocks = pg_malloc(sizeof(uint32) * Max(hdr->num_blocks, 1));
+	if (hdr->num_blocks > 0)
+	{
+		rb = read(fd, *blocks, sizeof(uint32) * hdr->num_blocks);
+		if (rb != sizeof(uint32) * hdr->num_blocks)
+		{
+			if (rb < 0)
+				pg_log_error("could not read file \"%s\": %m", incpath);
+			else
+				pg_log_error("file \"%s\" is not a valid incremental file", incpath);
+			exit(1);
+		}
+	}
+
+	return fd;
+}
+
+/*
+ * Check whether an incremental file contains every block of the relation
+ * file, so that it doesn't need an earlier copy of the file to be applied to.
+ */
+static bool
+incremental_file_is_complete(const char *incpath)
+{
+	IncrementalFileHeader hdr;
+	uint32	   *blocks;
+	bool		complete;
+	uint32		i;
+
+	close(read_incremental_header(incpath, &hdr, &blocks));
+
+	/* The server sends the block numbers in ascending order */
+	complete = (hdr.num_blocks == hdr.truncation_block_length);
+	for (i = 0; complete && i < hdr.num_blocks; i++)
+		complete = (blocks[i] == i);
+
+	pg_free(blocks);
+
+	return complete;
+}
+
+/*
+ * Apply an incremental file to the (full) file at "outpath": truncate or
+ * extend it to the length recorded in the incremental file, and overwrite
+ * the blocks it contains.
+ */
+static void
+apply_incremental_file(const char *incpath, const char *outpath)
+{
+	IncrementalFileHeader hdr;
+	uint32	   *blocks;
+	PGAlignedBlock buf;
+	int			infd;
+	int			outfd;
+	int			rb;
+	uint32		i;
+
+	infd = read_incremental_header(incpath, &hdr, &blocks);
+
+	if ((outfd = open(outpath, O_RDWR | PG_BINARY, 0)) < 0)
+	{
+		pg_log_error("could not open file \"%s\": %m", outpath);
+		exit(1);
+	}
+
+	if (ftruncate(outfd, (off_t) hdr.truncation_block_length * BLCKSZ) != 0)
+	{
+		pg_log_error("could not truncate file \"%s\": %m", outpath);
+		exit(1);
+	}
+
+	for (i = 0; i < hdr.num_blocks; i++)
+	{
+		if (blocks[i] >= hdr.truncation_block_length)
+		{
+			pg_log_error("file \"%s\" is not a valid incremental file", incpath);
+			exit(1);
+		}
+
+		rb = read(infd, buf.data, BLCKSZ);
+		if (rb != BLCKSZ)
+		{
+			if (rb < 0)
+				pg_log_error("could not read file \"%s\": %m", incpath);
+			else
+				pg_log_error("could not read file \"%s\": read %d of %d",
+							 incpath, rb, BLCKSZ);
+			exit(1);
+		}
+
+		errno = 0;
+		if (pg_pwrite(outfd, buf.data, BLCKSZ,
+					  (off_t) blocks[i] * BLCKSZ) != BLCKSZ)
+		{
+			/* if write didn't set errno, assume problem is no disk space */
+			if (errno == 0)
+				errno = ENOSPC;
+			pg_log_error("could not write file \"%s\": %m", outpath);
+			exit(1);
+		}
+	}
+
+	close(outfd);
+	close(infd);
+	pg_free(blocks);
+}
+
+/*
+ * Copy a regular file.
+ */
+static void
+copy_file(const char *src, const char *dst)
+{
+	char	   *buf;
+	int			srcfd;
+	int			dstfd;
+	int			nbytes;
+
+	if ((srcfd = open(src, O_RDONLY | PG_BINARY, 0)) < 0)
+	{
+		pg_log_error("could not open file \"%s\": %m", src);
+		exit(1);
+	}
+
+	if ((dstfd = open(dst, O_RDWR | O_CREAT | O_EXCL | PG_BINARY,
+					  pg_file_create_mode)) < 0)
+	{
+		pg_log_error("could not create file \"%s\": %m", dst);
+		exit(1);
+	}
+
+#define COPY_BUF_SIZE (64 * BLCKSZ)
+
+	buf = pg_malloc(COPY_BUF_SIZE);
+
+	while ((nbytes = read(srcfd, buf, COPY_BUF_SIZE)) > 0)
+	{
+		errno = 0;
+		if (write(dstfd, buf, nbytes) != nbytes)
+		{
+			/* if write didn't set errno, assume problem is no disk space */
+			if (errno == 0)
+				errno = ENOSPC;
+			pg_log_error("could not write file \"%s\": %m", dst);
+			exit(1);
+		}
+	}
+	if (nbytes < 0)
+	{
+		pg_log_error("could not read file \"%s\": %m", src);
+		exit(1);
+	}
+
+	pg_free(buf);
+	close(dstfd);
+	close(srcfd);
+}
+
+/*
+ * Copy the backup_label of the newest backup, leaving out the line that
+ * marks it as incremental so that the server will start from the result.
+ */
+static void
+write_backup_label(const char *src, const char *dst)
+{
+	char		line[MAXPGPATH];
+	FILE	   *in;
+	FILE	   *out;
+	int			fd;
+
+	if ((in = fopen(src, "r")) == NULL)
+	{
+		pg_log_error("could not open file \"%s\": %m", src);
+		exit(1);
+	}
+
+	if ((fd = open(dst, O_WRONLY | O_CREAT | O_EXCL, pg_file_create_mode)) < 0 ||
+		(out = fdopen(fd, "w")) == NULL)
+	{
+		pg_log_error("could not create file \"%s\": %m", dst);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		if (strncmp(line, "INCREMENTAL FROM LSN:", 21) == 0)
+			continue;
+		if (fputs(line, out) == EOF)
+		{
+			pg_log_error("could not write file \"%s\": %m", dst);
+			exit(1);
+		}
+	}
+	if (ferror(in))
+	{
+		pg_log_error("could not read file \"%s\": %m", src);
+		exit(1);
+	}
+
+	fclose(in);
+	if (fclose(out) != 0)
+	{
+		pg_log_error("could not write file \"%s\": %m", dst);
+		exit(1);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	static struct option long_options[] = {
+		{"output", required_argument, NULL, 'o'},
+		{"no-sync", no_argument, NULL, 'N'},
+		{NULL, 0, NULL, 0}
+	};
+
+	int			c;
+	int			option_index;
+	int			i;
+
+	pg_logging_init(argv[0]);
+	set_pglocale_pgservice(argv[0], PG_TEXTDOMAIN("pg_combinebackup"));
+	progname = get_progname(argv[0]);
+
+	if (argc > 1)
+	{
+		if (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-?") == 0)
+		{
+			usage();
+			exit(0);
+		}
+		if (strcmp(argv[1], "--version") == 0 || strcmp(argv[1], "-V") == 0)
+		{
+			puts("pg_combinebackup (PostgreSQL) " PG_VERSION);
+			exit(0);
+		}
+	}
+
+	while ((c = getopt_long(argc, argv, "No:", long_options, &option_index)) != -1)
+	{
+		switch (c)
+		{
+			case 'N':
+				do_sync = false;
+				break;
+			case 'o':
+				output_dir = pg_strdup(optarg);
+				canonicalize_path(output_dir);
+				break;
+			default:
+				fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
+				exit(1);
+		}
+	}
+
+	if (optind >= argc)
+	{
+		pg_log_error("no input directories specified");
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
+		exit(1);
+	}
+
+	if (output_dir == NULL)
+	{
+		pg_log_error("no output directory specified");
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
+		exit(1);
+	}
+
+	/* Read and cross-check the backups */
+	nbackups = argc - optind;
+	backups = pg_malloc0(sizeof(BackupInfo) * nbackups);
+	for (i = 0; i < nbackups; i++)
+	{
+		BackupInfo *backup = &backups[i];
+
+		backup->path = pg_strdup(argv[optind + i]);
+		canonicalize_path(backup->path);
+		read_backup_info(backup);
+		check_no_tablespaces(backup);
+
+		if (i == 0)
+		{
+			if (!XLogRecPtrIsInvalid(backup->incremental_lsn))
+			{
+				pg_log_error("backup \"%s\" is an incremental backup, but the first backup must be a full backup",
+							 backup->path);
+				exit(1);
+			}
+			continue;
+		}
+
+		if (XLogRecPtrIsInvalid(backup->incremental_lsn))
+		{
+			pg_log_error("backup \"%s\" is not an incremental backup",
+						 backup->path);
+			exit(1);
+		}
+
+		if (backup->system_identifier != backups[0].system_identifier)
+		{
+			pg_log_error("backup \"%s\" is from a different database system than backup \"%s\"",
+						 backup->path, backups[0].path);
+			exit(1);
+		}
+
+		/*
+		 * Every block modified since the preceding backup started must be in
+		 * this one.  Blocks modified while that backup was running are
+		 * restored from WAL when it's recovered, but that only happens for
+		 * this backup's WAL range here.
+		 */
+		if (backup->incremental_lsn > backups[i - 1].start_lsn)
+		{
+			pg_log_error("backup \"%s\" contains changes since %X/%X, but the preceding backup \"%s\" starts at %X/%X",
+						 backup->path,
+						 (uint32) (backup->incremental_lsn >> 32),
+						 (uint32) backup->incremental_lsn,
+						 backups[i - 1].path,
+						 (uint32) (backups[i - 1].start_lsn >> 32),
+						 (uint32) backups[i - 1].start_lsn);
+			exit(1);
+		}
+	}
+
+	/* Create the output directory with the permissions of the newest backup */
+	if (!GetDataDirectoryCreatePerm(backups[nbackups - 1].path))
+	{
+		pg_log_error("could not read permissions of directory \"%s\": %m",
+					 backups[nbackups - 1].path);
+		exit(1);
+	}
+	umask(pg_mode_mask);
+
+	atexit(cleanup_directories_atexit);
+
+	switch (pg_check_dir(output_dir))
+	{
+		case 0:
+			if (pg_mkdir_p(output_dir, pg_dir_create_mode) == -1)
+			{
+				pg_log_error("could not create directory \"%s\": %m",
+							 output_dir);
+				exit(1);
+			}
+			made_output_dir = true;
+			break;
+		case 1:
+			found_output_dir = true;
+			break;
+		case 2:
+		case 3:
+		case 4:
+			pg_log_error("directory \"%s\" exists but is not empty", output_dir);
+			exit(1);
+		case -1:
+			pg_log_error("could not access directory \"%s\": %m", output_dir);
+			exit(1);
+	}
+
+	combine_directory("");
+
+	if (do_sync)
+		fsync_pgdata(output_dir, PG_VERSION_NUM);
+
+	success = true;
+	return 0;
+}
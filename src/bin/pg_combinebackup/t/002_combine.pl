@@ -0,0 +1,77 @@
+# Take a full and an incremental backup, combine them and check the result
+use strict;
+use warnings;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 10;
+
+my $node = get_new_node('main');
+$node->init(allows_streaming => 1);
+
+# Keep the WAL written since the full backup for the incremental one
+$node->append_conf('postgresql.conf', 'wal_keep_segments = 20');
+$node->start;
+
+$node->safe_psql('postgres',
+	'CREATE TABLE t AS SELECT a FROM generate_series(1, 10000) a;'
+	  . 'CREATE TABLE unchanged AS SELECT a FROM generate_series(1, 1000) a;');
+$node->safe_psql('postgres', 'VACUUM unchanged');
+
+my $backup_path = $node->backup_dir;
+$node->command_ok(
+	[ 'pg_basebackup', '-D', "$backup_path/full", '--no-sync' ],
+	'full backup');
+
+# The incremental backup is based on the start location of the full one
+my ($lsn) = slurp_file("$backup_path/full/backup_label") =~
+  /^START WAL LOCATION: (\S+)/m;
+
+$node->safe_psql('postgres',
+	    'UPDATE t SET a = -a WHERE a % 100 = 0;'
+	  . 'CREATE TABLE t2 AS SELECT 1 AS b;');
+
+# A database copied from template1 doesn't go through WAL block by block
+$node->safe_psql('postgres', 'CREATE DATABASE newdb');
+$node->safe_psql('newdb', 'CREATE TABLE t3 AS SELECT 3 AS c');
+
+# The WAL since the full backup is still in pg_wal, so the modified blocks
+# are taken from it
+my ($stdout, $stderr) = run_command(
+	[ 'pg_basebackup', '-D', "$backup_path/incr", '--no-sync', '-i', $lsn ]);
+ok(-f "$backup_path/incr/backup_label", 'incremental backup');
+unlike($stderr, qr/is not available/, 'modified blocks found from WAL');
+
+my @incremental_files = glob "$backup_path/incr/base/*/INCREMENTAL.*";
+ok(@incremental_files > 0, 'incremental backup contains incremental files');
+
+my $t2_path = $node->safe_psql('postgres', "SELECT pg_relation_filepath('t2')");
+ok(-f "$backup_path/incr/$t2_path", 'new relation is sent in full');
+
+my $unchanged_path =
+  $node->safe_psql('postgres', "SELECT pg_relation_filepath('unchanged')");
+$unchanged_path =~ s{([^/]+)$}{INCREMENTAL.$1};
+is(-s "$backup_path/incr/$unchanged_path",
+	12, 'unchanged relation is sent without blocks');
+
+command_fails_like(
+	[ 'pg_combinebackup', '-o', "$backup_path/bad", "$backup_path/incr" ],
+	qr/must be a full backup/,
+	'incremental backup alone cannot be combined');
+
+command_ok(
+	[
+		'pg_combinebackup', '-o', "$backup_path/combined", '--no-sync',
+		"$backup_path/full", "$backup_path/incr"
+	],
+	'combine backups');
+
+my $restored = get_new_node('restored');
+$restored->init_from_backup($node, 'combined');
+$restored->start;
+
+my $query = 'SELECT count(*), sum(a) FROM t, t2';
+is($restored->safe_psql('postgres', $query),
+	$node->safe_psql('postgres', $query),
+	'combined backup contains the same data');
+is($restored->safe_psql('newdb', 'SELECT c FROM t3'),
+	'3', 'combined backup contains the new database');
@@ -18,6 +18,7 @@
 #include "fmgr.h"
 #include "lib/rbtree.h"
 #include "storage/bufmgr.h"
+#include "storage/shm_toc.h"
 
 /*
  * Storage type for GIN's reloptions
@@ -27,9 +28,11 @@ typedef struct GinOptions
 	int32		vl_len_;		/* varlena header (do not touch directly!) */
 	bool		useFastUpdate;	/* use fast updates? */
 	int			pendingListCleanupSize; /* maximum size of pending list */
+	bool		useAutoCleanup; /* let autovacuum clean up pending list? */
 } GinOptions;
 
 #define GIN_DEFAULT_USE_FASTUPDATE	true
+#define GIN_DEFAULT_USE_AUTOCLEANUP false
 #define GinGetUseFastUpdate(relation) \
 	(AssertMacro(relation->rd_rel->relkind == RELKIND_INDEX && \
 				 relation->rd_rel->relam == GIN_AM_OID), \
@@ -42,6 +45,11 @@ typedef struct GinOptions
 	 ((GinOptions *) (relation)->rd_options)->pendingListCleanupSize != -1 ? \
 	 ((GinOptions *) (relation)->rd_options)->pendingListCleanupSize : \
 	 gin_pending_list_limit)
+#define GinGetUseAutoCleanup(relation) \
+	(AssertMacro(relation->rd_rel->relkind == RELKIND_INDEX && \
+				 relation->rd_rel->relam == GIN_AM_OID), \
+	 (relation)->rd_options ? \
+	 ((GinOptions *) (relation)->rd_options)->useAutoCleanup : GIN_DEFAULT_USE_AUTOCLEANUP)
 
 
 /* Macros for buffer lock/unlock operations */
@@ -109,6 +117,30 @@ extern OffsetNumber gintuple_get_attrnum(GinState *ginstate, IndexTuple tuple);
 extern Datum gintuple_get_key(GinState *ginstate, IndexTuple tuple,
 							  GinNullCategory *category);
 
+/*
+ * In a parallel index build, each participant accumulates entries with
+ * ginbulk.c and passes them to the leader through a shared tuplesort in this
+ * format: one key together with a sorted array of heap TIDs.  The key data
+ * (the Datum itself for pass-by-value keys) starts at a MAXALIGN'd offset,
+ * the TIDs follow it.
+ */
+typedef struct GinBuildTuple
+{
+	int			tuplen;			/* length of the whole tuple, in bytes */
+	OffsetNumber attrnum;		/* index column the key belongs to */
+	GinNullCategory category;	/* key category */
+	int			keylen;			/* length of key data, 0 for null keys */
+	int			nitems;			/* number of heap TIDs */
+	char		data[FLEXIBLE_ARRAY_MEMBER];
+} GinBuildTuple;
+
+#define GinBuildTupleKeyOffset	MAXALIGN(offsetof(GinBuildTuple, data))
+#define GinBuildTupleGetKeyData(tup) \
+	((char *) (tup) + GinBuildTupleKeyOffset)
+#define GinBuildTupleGetItems(tup) \
+	((ItemPointer) ((char *) (tup) + \
+					SHORTALIGN(GinBuildTupleKeyOffset + (tup)->keylen)))
+
 /* gininsert.c */
 extern IndexBuildResult *ginbuild(Relation heap, Relation index,
 								  struct IndexInfo *indexInfo);
@@ -121,6 +153,9 @@ extern void ginEntryInsert(GinState *ginstate,
 						   OffsetNumber attnum, Datum key, GinNullCategory category,
 						   ItemPointerData *items, uint32 nitem,
 						   GinStatsData *buildStats);
+extern int	ginCompareBuildTuples(GinState *ginstate,
+								  GinBuildTuple *a, GinBuildTuple *b);
+extern void _gin_parallel_build_main(dsm_segment *seg, shm_toc *toc);
 
 /* ginbtree.c */
 
@@ -127,11 +127,14 @@ typedef struct xl_btree_delete
 {
 	TransactionId latestRemovedXid;
 	int			nitems;
+	bool		isCatalogRel;	/* to handle recovery conflict during logical
+								 * decoding on standby */
 
-	/* TARGET OFFSET NUMBERS FOLLOW AT THE END */
+	/* TARGET OFFSET NUMBERS FOLLOW */
+	OffsetNumber offsets[FLEXIBLE_ARRAY_MEMBER];
 } xl_btree_delete;
 
-#define SizeOfBtreeDelete	(offsetof(xl_btree_delete, nitems) + sizeof(int))
+#define SizeOfBtreeDelete	offsetof(xl_btree_delete, offsets)
 
 /*
  * This is what we need to know about page reuse within btree.  This record
@@ -145,6 +148,8 @@ typedef struct xl_btree_reuse_page
 	RelFileNode node;
 	BlockNumber block;
 	TransactionId latestRemovedXid;
+	bool		isCatalogRel;	/* to handle recovery conflict during logical
+								 * decoding on standby */
 } xl_btree_reuse_page;
 
 #define SizeOfBtreeReusePage	(sizeof(xl_btree_reuse_page))
@@ -0,0 +1,44 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogprefetch.h
+ *		Declarations for the recovery prefetching module.
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *		src/include/access/xlogprefetch.h
+ *-------------------------------------------------------------------------
+ */
+#ifndef XLOGPREFETCH_H
+#define XLOGPREFETCH_H
+
+#include "access/xlogdefs.h"
+
+/* GUC parameter */
+extern int	max_recovery_prefetch_distance;
+
+typedef struct XLogPrefetcher XLogPrefetcher;
+
+/* Counters exposed through pg_stat_prefetch_recovery */
+typedef struct XLogPrefetchStats
+{
+	uint64		prefetch;		/* prefetch requests issued */
+	uint64		skip_hit;		/* blocks already in shared buffers */
+	uint64		skip_new;		/* blocks that will be initialized, or whose
+								 * relation file doesn't exist */
+	uint64		skip_fpw;		/* blocks restored from full page images */
+	uint64		skip_seq;		/* repeated or sequential block references */
+	uint64		distance;		/* bytes of WAL currently decoded ahead */
+} XLogPrefetchStats;
+
+extern Size XLogPrefetchShmemSize(void);
+extern void XLogPrefetchShmemInit(void);
+extern void XLogPrefetchGetStats(XLogPrefetchStats *stats);
+
+extern XLogPrefetcher *XLogPrefetcherAllocate(void);
+extern void XLogPrefetcherFree(XLogPrefetcher *prefetcher);
+extern void XLogPrefetcherReadAhead(XLogPrefetcher *prefetcher,
+									XLogRecPtr replaying_lsn);
+
+#endif							/* XLOGPREFETCH_H */
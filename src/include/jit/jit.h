@@ -22,6 +22,7 @@
 #define PGJIT_INLINE   (1 << 2)
 #define PGJIT_EXPR	   (1 << 3)
 #define PGJIT_DEFORM   (1 << 4)
+#define PGJIT_DEFER    (1 << 5)
 
 
 typedef struct JitInstrumentation
@@ -29,6 +30,9 @@ typedef struct JitInstrumentation
 	/* number of emitted functions */
 	size_t		created_functions;
 
+	/* number of expressions compiled after reaching jit_expr_threshold */
+	size_t		deferred_exprs;
+
 	/* accumulated time to generate code */
 	instr_time	generation_counter;
 
@@ -86,9 +90,11 @@ extern bool jit_dump_bitcode;
 extern bool jit_expressions;
 extern bool jit_profiling_support;
 extern bool jit_tuple_deforming;
+extern bool jit_deform_cache;
 extern double jit_above_cost;
 extern double jit_inline_above_cost;
 extern double jit_optimize_above_cost;
+extern int	jit_expr_threshold;
 
 
 extern void jit_reset_after_error(void);
@@ -99,6 +105,7 @@ extern void jit_release_context(JitContext *context);
  * not be able to perform JIT (i.e. return false).
  */
 extern bool jit_compile_expr(struct ExprState *state);
+extern bool jit_defer_expr(struct ExprState *state);
 extern void InstrJitAgg(JitInstrumentation *dst, JitInstrumentation *add);
 
 
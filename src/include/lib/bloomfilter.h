@@ -17,6 +17,10 @@ typedef struct bloom_filter bloom_filter;
 
 extern bloom_filter *bloom_create(int64 total_elems, int bloom_work_mem,
 								  uint64 seed);
+extern bloom_filter *bloom_create_fixed(uint64 bitset_bits, int64 total_elems,
+										uint64 seed);
+extern Size bloom_size(bloom_filter *filter);
+extern bool bloom_union(bloom_filter *dst, bloom_filter *src);
 extern void bloom_free(bloom_filter *filter);
 extern void bloom_add_element(bloom_filter *filter, unsigned char *elem,
 							  size_t len);
@@ -96,6 +96,9 @@ typedef struct ExprState
 	/* private state for an evalfunc */
 	void	   *evalfunc_private;
 
+	/* evaluations left until deferred JIT compilation, see ExecReadyExpr */
+	int			jit_countdown;
+
 	/*
 	 * XXX: following fields only needed during "compilation" (ExecInitExpr);
 	 * could be thrown away afterwards.
@@ -1978,6 +1981,23 @@ typedef struct SharedSortInfo
 	TuplesortInstrumentation sinstrument[FLEXIBLE_ARRAY_MEMBER];
 } SharedSortInfo;
 
+/* ----------------
+ *	 Shared memory state for a parallel-aware sort
+ *
+ * Each participant sorts the tuples it reads into a single run on shared
+ * tapes, and the leader merges all the runs to produce the output.  The
+ * Sharedsort follows this struct (at a MAXALIGN'd offset), and then the
+ * SharedSortInfo, if instrumentation is enabled.
+ * ----------------
+ */
+typedef struct ParallelSortState
+{
+	slock_t		mutex;			/* protects nparticipantsdone */
+	int			nparticipantsdone;	/* # of participants done with input */
+	ConditionVariable workersdonecv;	/* signaled as participants finish */
+	Size		instr_offset;	/* offset of SharedSortInfo, or 0 */
+} ParallelSortState;
+
 /* ----------------
  *	 SortState information
  * ----------------
@@ -1994,6 +2014,9 @@ typedef struct SortState
 	void	   *tuplesortstate; /* private state of tuplesort.c */
 	bool		am_worker;		/* are we a worker? */
 	SharedSortInfo *shared_info;	/* one entry per worker */
+	ParallelSortState *pstate;	/* shared state for parallel-aware sort */
+	Sharedsort *sharedsort;		/* shared tuplesort state, ditto */
+	struct ParallelContext *pcxt;	/* leader's parallel context, ditto */
 } SortState;
 
 /* ---------------------
@@ -2076,6 +2099,7 @@ typedef struct AggState
 	AggStatePerGroup *all_pergroups;	/* array of first ->pergroups, than
 										 * ->hash_pergroup */
 	ProjectionInfo *combinedproj;	/* projection machinery */
+	MemoryContext hash_tablecxt;	/* memory for hash table entries */
 } AggState;
 
 /* ----------------
@@ -2245,6 +2269,8 @@ typedef struct HashInstrumentation
 	int			nbatch;			/* number of batches at end of execution */
 	int			nbatch_original;	/* planned number of batches */
 	size_t		space_peak;		/* peak memory usage in bytes */
+	uint64		bloom_probes;	/* # outer tuples checked by Bloom filter */
+	uint64		bloom_rejected; /* # outer tuples it rejected */
 } HashInstrumentation;
 
 /* ----------------
@@ -64,7 +64,8 @@ typedef enum StatMsgType
 	PGSTAT_MTYPE_RECOVERYCONFLICT,
 	PGSTAT_MTYPE_TEMPFILE,
 	PGSTAT_MTYPE_DEADLOCK,
-	PGSTAT_MTYPE_CHECKSUMFAILURE
+	PGSTAT_MTYPE_CHECKSUMFAILURE,
+	PGSTAT_MTYPE_WAL
 } StatMsgType;
 
 /* ----------
@@ -92,6 +93,11 @@ typedef int64 PgStat_Counter;
  * regardless of whether the transaction committed.  delta_live_tuples,
  * delta_dead_tuples, and changed_tuples are set depending on commit or abort.
  * Note that delta_live_tuples and delta_dead_tuples can be negative!
+ *
+ * For a BRIN index, delta_unsummarized_ranges counts page ranges that filled
+ * up without being summarized, less those summarized since; it can be
+ * negative too.  unsummarized_reset means every range was summarized, so
+ * the collector should start over from zero before applying the delta.
  * ----------
  */
 typedef struct PgStat_TableCounts
@@ -113,13 +119,17 @@ typedef struct PgStat_TableCounts
 
 	PgStat_Counter t_blocks_fetched;
 	PgStat_Counter t_blocks_hit;
+
+	PgStat_Counter t_delta_unsummarized_ranges;
+	bool		t_unsummarized_reset;
 } PgStat_TableCounts;
 
 /* Possible targets for resetting cluster-wide shared values */
 typedef enum PgStat_Shared_Reset_Target
 {
 	RESET_ARCHIVER,
-	RESET_BGWRITER
+	RESET_BGWRITER,
+	RESET_WAL
 } PgStat_Shared_Reset_Target;
 
 /* Possible object types for resetting single counters */
@@ -422,6 +432,35 @@ typedef struct PgStat_MsgBgWriter
 	PgStat_Counter m_checkpoint_sync_time;
 } PgStat_MsgBgWriter;
 
+/* ----------
+ * PgStat_WalCounts			WAL activity counters, as sent in PgStat_MsgWal
+ *							and accumulated per backend type.
+ * ----------
+ */
+typedef struct PgStat_WalCounts
+{
+	PgStat_Counter wal_records;
+	PgStat_Counter wal_fpi;
+	PgStat_Counter wal_bytes;
+	PgStat_Counter wal_buffers_full;
+	PgStat_Counter wal_write;
+	PgStat_Counter wal_sync;
+	PgStat_Counter wal_write_time;	/* times in microseconds */
+	PgStat_Counter wal_sync_time;
+} PgStat_WalCounts;
+
+/* ----------
+ * PgStat_MsgWal			Sent by backends and background processes to
+ *							update WAL statistics.
+ * ----------
+ */
+typedef struct PgStat_MsgWal
+{
+	PgStat_MsgHdr m_hdr;
+	int			m_backend_type; /* BackendType of the sender */
+	PgStat_WalCounts m_counts;
+} PgStat_MsgWal;
+
 /* ----------
  * PgStat_MsgRecoveryConflict	Sent by the backend upon recovery conflict
  * ----------
@@ -570,6 +609,7 @@ typedef union PgStat_Msg
 	PgStat_MsgDeadlock msg_deadlock;
 	PgStat_MsgTempFile msg_tempfile;
 	PgStat_MsgChecksumFailure msg_checksumfailure;
+	PgStat_MsgWal msg_wal;
 } PgStat_Msg;
 
 
@@ -581,7 +621,7 @@ typedef union PgStat_Msg
  * ------------------------------------------------------------
  */
 
-#define PGSTAT_FILE_FORMAT_ID	0x01A5BC9D
+#define PGSTAT_FILE_FORMAT_ID	0x01A5BC9F
 
 /* ----------
  * PgStat_StatDBEntry			The collector's data per database
@@ -650,6 +690,8 @@ typedef struct PgStat_StatTabEntry
 	PgStat_Counter blocks_fetched;
 	PgStat_Counter blocks_hit;
 
+	PgStat_Counter n_unsummarized_ranges;	/* BRIN indexes only */
+
 	TimestampTz vacuum_timestamp;	/* user initiated vacuum */
 	PgStat_Counter vacuum_count;
 	TimestampTz autovac_vacuum_timestamp;	/* autovacuum initiated */
@@ -730,6 +772,18 @@ typedef enum BackendType
 	B_WAL_WRITER
 } BackendType;
 
+#define BACKEND_NUM_TYPES	(B_WAL_WRITER + 1)
+
+/*
+ * WAL statistics kept in the stats collector, broken down by the type of
+ * process that generated or wrote the WAL
+ */
+typedef struct PgStat_WalStats
+{
+	PgStat_WalCounts counts[BACKEND_NUM_TYPES];
+	TimestampTz stat_reset_timestamp;
+} PgStat_WalStats;
+
 
 /* ----------
  * Backend states
@@ -848,6 +902,7 @@ typedef enum
 	WAIT_EVENT_PARALLEL_BITMAP_SCAN,
 	WAIT_EVENT_PARALLEL_CREATE_INDEX_SCAN,
 	WAIT_EVENT_PARALLEL_FINISH,
+	WAIT_EVENT_PARALLEL_SORT,
 	WAIT_EVENT_PROCARRAY_GROUP_UPDATE,
 	WAIT_EVENT_PROMOTE,
 	WAIT_EVENT_REPLICATION_ORIGIN_DROP,
@@ -1222,6 +1277,12 @@ extern char *pgstat_stat_filename;
  */
 extern PgStat_MsgBgWriter BgWriterStats;
 
+/*
+ * WAL write and sync counters are updated directly by xlog.c; the record
+ * counts are taken from pgWalUsage when the message is sent
+ */
+extern PgStat_MsgWal WalStats;
+
 /*
  * Updated by pgstat_count_buffer_*_time macros
  */
@@ -1391,6 +1452,19 @@ pgstat_report_wait_end(void)
 		if ((rel)->pgstat_info != NULL)								\
 			(rel)->pgstat_info->t_counts.t_blocks_hit++;			\
 	} while (0)
+#define pgstat_count_unsummarized_ranges(rel, n)					\
+	do {															\
+		if ((rel)->pgstat_info != NULL)								\
+			(rel)->pgstat_info->t_counts.t_delta_unsummarized_ranges += (n); \
+	} while (0)
+#define pgstat_reset_unsummarized_ranges(rel)						\
+	do {															\
+		if ((rel)->pgstat_info != NULL)								\
+		{															\
+			(rel)->pgstat_info->t_counts.t_delta_unsummarized_ranges = 0; \
+			(rel)->pgstat_info->t_counts.t_unsummarized_reset = true;	\
+		}															\
+	} while (0)
 #define pgstat_count_buffer_read_time(n)							\
 	(pgStatBlockReadTime += (n))
 #define pgstat_count_buffer_write_time(n)							\
@@ -1421,6 +1495,7 @@ extern void pgstat_twophase_postabort(TransactionId xid, uint16 info,
 
 extern void pgstat_send_archiver(const char *xlog, bool failed);
 extern void pgstat_send_bgwriter(void);
+extern void pgstat_send_wal(void);
 
 /* ----------
  * Support functions for the SQL-callable functions to
@@ -1434,6 +1509,7 @@ extern LocalPgBackendStatus *pgstat_fetch_stat_local_beentry(int beid);
 extern PgStat_StatFuncEntry *pgstat_fetch_stat_funcentry(Oid funcid);
 extern int	pgstat_fetch_stat_numbackends(void);
 extern PgStat_ArchiverStats *pgstat_fetch_stat_archiver(void);
+extern PgStat_WalStats *pgstat_fetch_stat_wal(void);
 extern PgStat_GlobalStats *pgstat_fetch_global(void);
 
 #endif							/* PGSTAT_H */
@@ -20,6 +20,25 @@
 #define MAX_RATE_LOWER	32
 #define MAX_RATE_UPPER	1048576
 
+/*
+ * In an incremental backup, a relation file that has changed only partly
+ * since the earlier backup is sent as INCREMENTAL.<filename>.  Such a file
+ * starts with an IncrementalFileHeader, followed by num_blocks block numbers
+ * (as uint32) and then by the contents of those blocks, in the same order.
+ * truncation_block_length is the length of the relation file, in blocks, at
+ * the time it was read.
+ */
+#define INCREMENTAL_PREFIX			"INCREMENTAL."
+#define INCREMENTAL_PREFIX_LENGTH	(sizeof(INCREMENTAL_PREFIX) - 1)
+#define INCREMENTAL_MAGIC			0xd3ae1f0d
+
+typedef struct IncrementalFileHeader
+{
+	uint32		magic;
+	uint32		num_blocks;
+	uint32		truncation_block_length;
+} IncrementalFileHeader;
+
 
 typedef struct
 {
@@ -198,6 +198,8 @@ extern void ReplicationSlotsComputeRequiredLSN(void);
 extern XLogRecPtr ReplicationSlotsComputeLogicalRestartLSN(void);
 extern bool ReplicationSlotsCountDBSlots(Oid dboid, int *nslots, int *nactive);
 extern void ReplicationSlotsDropDBSlots(Oid dboid);
+extern void InvalidateConflictingLogicalReplicationSlots(Oid dboid,
+														 TransactionId xid);
 
 extern void StartupReplicationSlots(void);
 extern void CheckPointReplicationSlots(void);
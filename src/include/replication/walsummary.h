@@ -0,0 +1,40 @@
+/*-------------------------------------------------------------------------
+ *
+ * walsummary.h
+ *	  Summarize the blocks modified by a range of WAL
+ *
+ * Portions Copyright (c) 2010-2020, PostgreSQL Global Development Group
+ *
+ * src/include/replication/walsummary.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef _WALSUMMARY_H
+#define _WALSUMMARY_H
+
+#include "access/xlogdefs.h"
+#include "nodes/bitmapset.h"
+#include "storage/block.h"
+#include "storage/relfilenode.h"
+
+typedef struct WalSummary WalSummary;
+
+/*
+ * What a WAL summary knows about one segment file of a relation's main fork.
+ */
+typedef enum WalSummaryFileStatus
+{
+	WALSUMMARY_FILE_BLOCKS,		/* only the listed blocks were modified */
+	WALSUMMARY_FILE_CREATED,	/* the file was created, or its database
+								 * copied, within the range */
+	WALSUMMARY_FILE_TRUNCATED	/* the relation was truncated within the
+								 * range */
+} WalSummaryFileStatus;
+
+extern WalSummary *SummarizeWAL(XLogRecPtr start_lsn, XLogRecPtr end_lsn);
+extern WalSummaryFileStatus WalSummaryGetFile(WalSummary *summary,
+											  RelFileNode rnode,
+											  BlockNumber segno,
+											  Bitmapset **blocks);
+
+#endif							/* _WALSUMMARY_H */
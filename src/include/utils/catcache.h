@@ -103,6 +103,12 @@ typedef struct catctup
 	 */
 	dlist_node	cache_elem;		/* list member of per-bucket list */
 
+	/*
+	 * Each tuple is also a member of a single LRU list spanning all caches,
+	 * which is used to evict entries when catalog_cache_max_size is exceeded.
+	 */
+	dlist_node	lru_elem;		/* list member of global LRU list */
+
 	/*
 	 * A tuple marked "dead" must not be returned by subsequent searches.
 	 * However, it won't be physically deleted from the cache until its
@@ -183,9 +189,15 @@ typedef struct catcacheheader
 {
 	slist_head	ch_caches;		/* head of list of CatCache structs */
 	int			ch_ntup;		/* # of tuples in all caches */
+	Size		ch_size;		/* memory used by tuples in all caches */
+	dlist_head	ch_lru;			/* all tuples, most recently used first */
 } CatCacheHeader;
 
 
+/* GUC parameter */
+extern int	catalog_cache_max_size;
+
+
 /* this extern duplicates utils/memutils.h... */
 extern PGDLLIMPORT MemoryContext CacheMemoryContext;
 
@@ -217,6 +229,7 @@ extern CatCList *SearchCatCacheList(CatCache *cache, int nkeys,
 									Datum v3);
 extern void ReleaseCatCacheList(CatCList *list);
 
+extern Size CatalogCacheMemoryUsed(void);
 extern void ResetCatalogCaches(void);
 extern void CatalogCacheFlushCatalog(Oid catId);
 extern void CatCacheInvalidate(CatCache *cache, uint32 hashValue);
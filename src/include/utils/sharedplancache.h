@@ -0,0 +1,53 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedplancache.h
+ *	  Cluster-wide cache of generic plans, in shared memory.
+ *
+ * See sharedplancache.c for comments.
+ *
+ * Portions Copyright (c) 1996-2020, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/utils/sharedplancache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SHAREDPLANCACHE_H
+#define SHAREDPLANCACHE_H
+
+/*
+ * Number of partitions of the relation and object invalidation counters.
+ * Must be at most 64, since sets of partitions are kept in a uint64 bitmask.
+ */
+#define SHARED_PLAN_CACHE_PARTITIONS	64
+
+/* Invalidation generations, as read by SharedPlanCacheGetGeneration */
+typedef struct SharedPlanCacheGeneration
+{
+	uint64		global;			/* advanced by events not in a partition */
+	uint64		part[SHARED_PLAN_CACHE_PARTITIONS];	/* by the others */
+} SharedPlanCacheGeneration;
+
+/* GUC parameter */
+extern int	shared_plan_cache_size;
+
+#define SharedPlanCacheEnabled() (shared_plan_cache_size > 0)
+
+extern Size SharedPlanCacheShmemSize(void);
+extern void SharedPlanCacheShmemInit(void);
+
+extern void SharedPlanCacheGetGeneration(SharedPlanCacheGeneration *generation);
+extern bool SharedPlanCacheIsCurrent(const SharedPlanCacheGeneration *generation,
+									 uint64 depmask);
+extern int	SharedPlanCacheRelationPartition(Oid relid);
+extern int	SharedPlanCacheObjectPartition(int cacheid, uint32 hashvalue);
+extern void SharedPlanCacheInvalidate(void);
+extern void SharedPlanCacheInvalidatePartition(int partition);
+extern char *SharedPlanCacheLookup(const char *querystr, int cursor_options,
+								   const SharedPlanCacheGeneration *generation);
+extern void SharedPlanCacheInsert(const char *querystr, int cursor_options,
+								  const char *planstr, uint64 depmask,
+								  TransactionId checkxmin,
+								  const SharedPlanCacheGeneration *generation);
+
+#endif							/* SHAREDPLANCACHE_H */
@@ -34,6 +34,9 @@
 typedef struct Tuplesortstate Tuplesortstate;
 typedef struct Sharedsort Sharedsort;
 
+/* Defined in access/gin_private.h */
+struct GinBuildTuple;
+
 /*
  * Tuplesort parallel coordination state, allocated by each participant in
  * local memory.  Participant caller initializes everything.  See usage notes
@@ -153,6 +156,10 @@ typedef struct TuplesortInstrumentation
  *    tuplesort turns out to be unnecessary.
  * 9. Call tuplesort_end() in leader.
  *
+ * The shared state can be reused for another parallel sort once all of the
+ * above steps are done, by calling tuplesort_reset_shared() in the leader
+ * before relaunching workers.
+ *
  * This division of labor assumes nothing about how input tuples are produced,
  * but does require that caller combine the state of multiple tuplesorts for
  * any purpose other than producing the final output.  For example, callers
@@ -208,6 +215,14 @@ extern Tuplesortstate *tuplesort_begin_index_hash(Relation heapRel,
 												  uint32 max_buckets,
 												  int workMem, SortCoordinate coordinate,
 												  bool randomAccess);
+extern Tuplesortstate *tuplesort_begin_index_gist(Relation heapRel,
+												  Relation indexRel,
+												  int workMem, SortCoordinate coordinate,
+												  bool randomAccess);
+extern Tuplesortstate *tuplesort_begin_index_gin(Relation heapRel,
+												 Relation indexRel,
+												 int workMem, SortCoordinate coordinate,
+												 bool randomAccess);
 extern Tuplesortstate *tuplesort_begin_datum(Oid datumType,
 											 Oid sortOperator, Oid sortCollation,
 											 bool nullsFirstFlag,
@@ -224,6 +239,8 @@ extern void tuplesort_putindextuplevalues(Tuplesortstate *state,
 										  Datum *values, bool *isnull);
 extern void tuplesort_putdatum(Tuplesortstate *state, Datum val,
 							   bool isNull);
+extern void tuplesort_putgintuple(Tuplesortstate *state,
+								  struct GinBuildTuple *tuple);
 
 extern void tuplesort_performsort(Tuplesortstate *state);
 
@@ -231,6 +248,8 @@ extern bool tuplesort_gettupleslot(Tuplesortstate *state, bool forward,
 								   bool copy, TupleTableSlot *slot, Datum *abbrev);
 extern HeapTuple tuplesort_getheaptuple(Tuplesortstate *state, bool forward);
 extern IndexTuple tuplesort_getindextuple(Tuplesortstate *state, bool forward);
+extern struct GinBuildTuple *tuplesort_getgintuple(Tuplesortstate *state,
+												   bool forward);
 extern bool tuplesort_getdatum(Tuplesortstate *state, bool forward,
 							   Datum *val, bool *isNull, Datum *abbrev);
 
@@ -250,6 +269,7 @@ extern Size tuplesort_estimate_shared(int nworkers);
 extern void tuplesort_initialize_shared(Sharedsort *shared, int nWorkers,
 										dsm_segment *seg);
 extern void tuplesort_attach_shared(Sharedsort *shared, dsm_segment *seg);
+extern void tuplesort_reset_shared(Sharedsort *shared);
 
 /*
  * These routines may only be called if randomAccess was specified 'true'.
@@ -0,0 +1,47 @@
+# Generic plans shared between sessions
+#
+# A plan made in a transaction with uncommitted catalog changes must not be
+# handed to other sessions, and a session must not pick up a plan that was
+# made under different planner settings.  Catalog churn on objects a plan
+# does not depend on must not throw it out.
+
+setup
+{
+  CREATE TABLE spc_tab (a int, b int);
+  INSERT INTO spc_tab SELECT g, g FROM generate_series(1, 1000) g;
+  ANALYZE spc_tab;
+  CREATE TABLE spc_stats (hits bigint, misses bigint);
+  INSERT INTO spc_stats VALUES (0, 0);
+}
+
+teardown
+{
+  DROP TABLE spc_tab;
+  DROP TABLE spc_stats;
+}
+
+session "s1"
+setup		{ SET plan_cache_mode = force_generic_plan; }
+step "s1_begin"		{ BEGIN; }
+step "s1_index"		{ CREATE INDEX spc_tab_a_idx ON spc_tab (a); }
+step "s1_plan"		{ DEALLOCATE ALL; PREPARE q(int) AS SELECT b FROM spc_tab WHERE a = $1; EXPLAIN (COSTS OFF) EXECUTE q(42); }
+step "s1_commit"	{ COMMIT; }
+step "s1_noindex"	{ SET enable_indexscan = off; SET enable_bitmapscan = off; }
+step "s1_domain"	{ CREATE DOMAIN spc_dom AS int; DROP DOMAIN spc_dom; }
+
+session "s2"
+setup		{ SET plan_cache_mode = force_generic_plan; }
+step "s2_plan"		{ DEALLOCATE ALL; PREPARE q(int) AS SELECT b FROM spc_tab WHERE a = $1; EXPLAIN (COSTS OFF) EXECUTE q(42); }
+
+# The counters are cluster-wide, so only check that they moved.
+session "s3"
+step "s3_snap"		{ UPDATE spc_stats SET (hits, misses) = (SELECT hits, misses FROM pg_shared_plan_cache_stats()); }
+step "s3_check"		{ SELECT s.hits > spc_stats.hits AS hit FROM pg_shared_plan_cache_stats() s, spc_stats; }
+
+# s2 must not see the index before s1 commits; afterwards its own plan is
+# shared, but not with s1 once s1 has disabled index scans.
+permutation "s1_begin" "s1_index" "s1_plan" "s2_plan" "s1_commit" "s2_plan" "s3_snap" "s1_plan" "s3_check" "s1_noindex" "s1_plan"
+
+# Creating and dropping a type sends invalidations for objects the plan does
+# not use; s1 still gets the plan s2 made.
+permutation "s2_plan" "s1_domain" "s3_snap" "s1_plan" "s3_check"
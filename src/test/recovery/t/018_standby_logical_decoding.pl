@@ -0,0 +1,114 @@
+# Test logical decoding on a hot standby, and invalidation of standby
+# slots when the primary removes catalog rows they still need.
+use strict;
+use warnings;
+
+use PostgresNode;
+use TestLib;
+use Test::More tests => 6;
+use IPC::Run ();
+
+my ($stdout, $stderr, $ret);
+
+# Initialize master node
+my $node_master = get_new_node('master');
+$node_master->init(allows_streaming => 1);
+$node_master->append_conf(
+	'postgresql.conf', q[
+wal_level = 'logical'
+max_replication_slots = 4
+max_wal_senders = 4
+]);
+$node_master->start;
+
+$node_master->safe_psql('postgres', 'CREATE TABLE decoding_test(x integer);');
+
+my $backup_name = 'b1';
+$node_master->backup($backup_name);
+
+# hot_standby_feedback stays off, so that the master is free to remove
+# catalog rows the standby's slot still needs later on.
+my $node_standby = get_new_node('standby');
+$node_standby->init_from_backup($node_master, $backup_name,
+	has_streaming => 1);
+$node_standby->start;
+
+$node_master->wait_for_catchup($node_standby, 'replay',
+	$node_master->lsn('insert'));
+
+# Creating a logical slot on a standby waits for the master to log a
+# snapshot of running transactions, so run it in the background and log
+# one once the slot has reserved WAL.
+my $create = IPC::Run::start(
+	[
+		'psql', '-XAtq', '-d', $node_standby->connstr('postgres'), '-c',
+		"SELECT slot_name FROM pg_create_logical_replication_slot('standby_slot', 'test_decoding')"
+	],
+	'>', \$stdout, '2>', \$stderr);
+
+$node_standby->poll_query_until(
+	'postgres', q[
+	SELECT restart_lsn IS NOT NULL
+	FROM pg_replication_slots
+	WHERE slot_name = 'standby_slot'
+	]) or die "standby slot never reserved WAL";
+
+$node_master->safe_psql('postgres', 'SELECT pg_log_standby_snapshot()');
+$create->finish;
+chomp($stdout);
+is($stdout, 'standby_slot', 'logical slot created on standby');
+
+# Changes made on the master can be decoded on the standby once replayed.
+$node_master->safe_psql('postgres',
+	'INSERT INTO decoding_test(x) SELECT s FROM generate_series(1,3) s;');
+$node_master->wait_for_catchup($node_standby, 'replay',
+	$node_master->lsn('insert'));
+
+my $expected = q{BEGIN
+table public.decoding_test: INSERT: x[integer]:1
+table public.decoding_test: INSERT: x[integer]:2
+table public.decoding_test: INSERT: x[integer]:3
+COMMIT};
+
+$stdout = $node_standby->safe_psql('postgres',
+	qq[SELECT data FROM pg_logical_slot_get_changes('standby_slot', NULL, NULL, 'include-xids', '0', 'skip-empty-xacts', '1');]
+);
+is($stdout, $expected, 'got expected output from decoding on standby');
+
+# Slot creation and decoding need the master's wal_level to be logical,
+# which is checked on the standby too.
+($ret, $stdout, $stderr) = $node_standby->psql('postgres',
+	"SELECT pg_log_standby_snapshot()");
+isnt($ret, 0, 'cannot log a standby snapshot during recovery');
+
+# Remove catalog rows the slot needs on the master.  Replaying that
+# invalidates the standby's slot.
+$node_master->safe_psql('postgres', 'CREATE TABLE dropme(x integer);');
+$node_master->safe_psql('postgres', 'DROP TABLE dropme;');
+$node_master->safe_psql('postgres', 'VACUUM pg_class;');
+$node_master->wait_for_catchup($node_standby, 'replay',
+	$node_master->lsn('insert'));
+
+ok( $node_standby->poll_query_until(
+		'postgres', q[
+	SELECT restart_lsn IS NULL AND catalog_xmin IS NULL
+	FROM pg_replication_slots
+	WHERE slot_name = 'standby_slot'
+	]),
+	'standby slot invalidated after catalog rows were removed');
+
+($ret, $stdout, $stderr) = $node_standby->psql('postgres',
+	qq[SELECT data FROM pg_logical_slot_get_changes('standby_slot', NULL, NULL);]
+);
+like(
+	$stderr,
+	qr/This slot has been invalidated because it was conflicting with recovery/,
+	'invalidated slot cannot be used for decoding');
+
+# An invalidated slot can still be dropped.
+$node_standby->safe_psql('postgres',
+	"SELECT pg_drop_replication_slot('standby_slot')");
+is( $node_standby->safe_psql(
+		'postgres', 'SELECT count(*) FROM pg_replication_slots'),
+	'0',
+	'invalidated slot dropped on standby');
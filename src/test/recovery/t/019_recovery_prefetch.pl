@@ -0,0 +1,86 @@
+# Checks for max_recovery_prefetch_distance and pg_stat_prefetch_recovery
+use strict;
+use warnings;
+
+use PostgresNode;
+use TestLib;
+use Test::More;
+
+# Initialize master node.  Without full page images, replay has to read
+# every block it modifies.
+my $node_master = get_new_node('master');
+$node_master->init(allows_streaming => 1);
+$node_master->append_conf('postgresql.conf', 'full_page_writes = off');
+$node_master->start;
+
+# Prefetching is disabled by default where posix_fadvise() is missing
+if ($node_master->safe_psql('postgres', 'SHOW max_recovery_prefetch_distance')
+	eq '-1')
+{
+	plan skip_all => 'prefetching is not supported on this platform';
+}
+else
+{
+	plan tests => 4;
+}
+
+$node_master->safe_psql('postgres',
+	"CREATE TABLE tab_int AS SELECT a, 0 AS b FROM generate_series(1, 10000) a;"
+	  . "CREATE INDEX ON tab_int (a);");
+
+my $backup_name = 'my_backup';
+$node_master->backup($backup_name);
+
+my $node_standby = get_new_node('standby');
+$node_standby->init_from_backup($node_master, $backup_name,
+	has_streaming => 1);
+$node_standby->append_conf('postgresql.conf',
+	'max_recovery_prefetch_distance = 1MB');
+$node_standby->start;
+
+# Update rows on random pages, so that replay reads blocks that aren't in
+# shared buffers and don't follow each other
+sub update_random_rows
+{
+	$node_master->safe_psql(
+		'postgres', q{
+DO $$
+BEGIN
+  FOR i IN 1..200 LOOP
+    UPDATE tab_int SET b = b + 1 WHERE a = 1 + (random() * 9999)::int;
+  END LOOP;
+END $$});
+	$node_master->wait_for_catchup($node_standby, 'replay',
+		$node_master->lsn('insert'));
+	return;
+}
+
+update_random_rows();
+
+my $prefetch = $node_standby->safe_psql('postgres',
+	'SELECT prefetch FROM pg_stat_prefetch_recovery');
+ok($prefetch > 0, 'blocks are prefetched during replay');
+
+# The statistics start from zero on restart, and stay there while
+# prefetching is disabled
+$node_standby->append_conf('postgresql.conf',
+	'max_recovery_prefetch_distance = -1');
+$node_standby->restart;
+
+update_random_rows();
+
+is( $node_standby->safe_psql(
+		'postgres',
+		'SELECT prefetch + skip_hit + skip_new + skip_fpw + skip_seq FROM pg_stat_prefetch_recovery'
+	),
+	'0',
+	'no blocks are looked at with prefetching disabled');
+is( $node_standby->safe_psql(
+		'postgres', 'SELECT distance FROM pg_stat_prefetch_recovery'),
+	'0',
+	'no distance is reported with prefetching disabled');
+
+my $query = 'SELECT sum(b) FROM tab_int';
+is($node_standby->safe_psql('postgres', $query),
+	$node_master->safe_psql('postgres', $query),
+	'standby has replayed all updates');
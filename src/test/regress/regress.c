@@ -35,6 +35,7 @@
 #include "optimizer/plancat.h"
 #include "port/atomics.h"
 #include "utils/builtins.h"
+#include "utils/catcache.h"
 #include "utils/geo_decls.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
@@ -808,6 +809,13 @@ test_atomic_ops(PG_FUNCTION_ARGS)
 	PG_RETURN_BOOL(true);
 }
 
+PG_FUNCTION_INFO_V1(test_catcache_size);
+Datum
+test_catcache_size(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_INT64((int64) CatalogCacheMemoryUsed());
+}
+
 PG_FUNCTION_INFO_V1(test_fdw_handler);
 Datum
 test_fdw_handler(PG_FUNCTION_ARGS)
@@ -460,3 +460,34 @@ VACUUM ANALYZE brin_test;
 EXPLAIN (COSTS OFF) SELECT * FROM brin_test WHERE a = 1;
 -- Ensure brin index is not used when values are not correlated
 EXPLAIN (COSTS OFF) SELECT * FROM brin_test WHERE b = 1;
+
+-- Test the bloom and minmax-multi operator classes
+CREATE TABLE brin_test_multi (a int, b text, c timestamp) WITH (fillfactor=10);
+INSERT INTO brin_test_multi
+  SELECT CASE WHEN i % 100 = 0 THEN 1000000 + i ELSE i END, md5(i::text),
+         timestamp '2000-01-01' + i * interval '1 hour'
+  FROM generate_series(1, 2000) i;
+CREATE INDEX brin_test_multi_a_idx ON brin_test_multi
+  USING brin (a int4_minmax_multi_ops) WITH (pages_per_range = 2);
+CREATE INDEX brin_test_multi_b_idx ON brin_test_multi
+  USING brin (b text_bloom_ops) WITH (pages_per_range = 2);
+CREATE INDEX brin_test_multi_c_idx ON brin_test_multi
+  USING brin (c timestamp_minmax_multi_ops, a int4_bloom_ops);
+SET enable_seqscan = off;
+SELECT count(*) FROM brin_test_multi WHERE a = 500;
+SELECT count(*) FROM brin_test_multi WHERE a = 1000500;
+SELECT count(*) FROM brin_test_multi WHERE a BETWEEN 1000 AND 1100;
+SELECT count(*) FROM brin_test_multi WHERE a > 1000000;
+SELECT count(*) FROM brin_test_multi WHERE a < 0;
+SELECT count(*) FROM brin_test_multi WHERE b = md5('42');
+SELECT count(*) FROM brin_test_multi WHERE b = 'nonexistent';
+SELECT count(*) FROM brin_test_multi WHERE c = '2000-01-02 18:00:00';
+SELECT count(*) FROM brin_test_multi WHERE c >= '2000-03-01';
+-- Check that minmax-multi actually excludes page ranges: with plain minmax,
+-- every range holding one of the outliers would match these.
+DROP INDEX brin_test_multi_c_idx;
+EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF)
+  SELECT * FROM brin_test_multi WHERE a = 1050;
+EXPLAIN (ANALYZE, COSTS OFF, TIMING OFF, SUMMARY OFF)
+  SELECT * FROM brin_test_multi WHERE a = 500;
+RESET enable_seqscan;
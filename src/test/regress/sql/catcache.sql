@@ -0,0 +1,20 @@
+--
+-- Catalog cache eviction
+--
+
+-- Look up the signature of every built-in function, which loads catalog
+-- cache entries for all of them and for the types they use
+SELECT md5(string_agg(oid::regprocedure::text, ',' ORDER BY oid)) AS sigs
+  FROM pg_proc WHERE oid < 16384 \gset
+SELECT test_catcache_size() > 256 * 1024 AS filled;
+
+-- With a small limit the same lookups must evict entries as they go, and
+-- give the same answers from entries loaded again
+SET catalog_cache_max_size = '64kB';
+SELECT md5(string_agg(oid::regprocedure::text, ',' ORDER BY oid)) = :'sigs' AS same
+  FROM pg_proc WHERE oid < 16384;
+SELECT test_catcache_size() < 96 * 1024 AS evicted;
+SELECT md5(string_agg(oid::regprocedure::text, ',' ORDER BY oid)) = :'sigs' AS same
+  FROM pg_proc WHERE oid < 16384;
+SELECT test_catcache_size() < 96 * 1024 AS evicted;
+RESET catalog_cache_max_size;
@@ -34,3 +34,40 @@ insert into gin_test_tbl select array[1, 3, g] from generate_series(1, 1000) g;
 
 delete from gin_test_tbl where i @> array[2];
 vacuum gin_test_tbl;
+
+-- Test handing the pending list cleanup over to autovacuum.  The result
+-- must not depend on whether the cleanup has happened yet.
+alter index gin_test_idx set (fastupdate = on, autocleanup = on);
+
+insert into gin_test_tbl select array[-1, g] from generate_series(1, 1000) g;
+
+select count(*) from gin_test_tbl where i @> array[-1];
+
+select gin_clean_pending_list('gin_test_idx') >= 0 as ok;
+
+-- nothing is left in the pending list afterwards
+select gin_clean_pending_list('gin_test_idx') = 0 as flushed;
+
+alter index gin_test_idx reset (autocleanup);
+
+-- Test parallel index build.  The results must not depend on whether
+-- workers could be launched.
+create table gin_test_tbl_p(i int4[])
+  with (autovacuum_enabled = off, parallel_workers = 2);
+insert into gin_test_tbl_p select array[g % 10, g % 100, g] from generate_series(1, 10000) g;
+insert into gin_test_tbl_p select null from generate_series(1, 100);
+insert into gin_test_tbl_p select '{}' from generate_series(1, 100);
+set max_parallel_maintenance_workers = 2;
+create index gin_test_idx_p on gin_test_tbl_p using gin (i);
+reset max_parallel_maintenance_workers;
+
+set enable_seqscan = off;
+set enable_bitmapscan = on;
+select count(*) from gin_test_tbl_p where i @> array[5];
+select count(*) from gin_test_tbl_p where i @> array[5, 55];
+select count(*) from gin_test_tbl_p where i && array[7, 9999];
+select count(*) from gin_test_tbl_p where i = '{}';
+reset enable_seqscan;
+reset enable_bitmapscan;
+
+drop table gin_test_tbl_p;
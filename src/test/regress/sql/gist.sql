@@ -37,6 +37,12 @@ vacuum analyze gist_point_tbl;
 alter index gist_pointidx SET (fillfactor = 40);
 reindex index gist_pointidx;
 
+-- the rebuilt index was built by sorting; check that it returns correct results
+set enable_seqscan=off;
+select count(*) from gist_point_tbl where p <@ box(point(0,0), point(10000,10000));
+select p from gist_point_tbl order by p <-> point(1001,1001) limit 3;
+reset enable_seqscan;
+
 --
 -- Test Index-only plans on GiST indexes
 --
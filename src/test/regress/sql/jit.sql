@@ -0,0 +1,81 @@
+--
+-- JIT compilation
+--
+-- The results depend on whether the server was built with LLVM support; see
+-- jit_1.out for the output without it.
+--
+select pg_jit_available();
+
+create table jit_tab as select g as a, g::text as b from generate_series(1, 1000) g;
+analyze jit_tab;
+
+-- Return the number of functions EXPLAIN ANALYZE reports as JIT compiled,
+-- or null if nothing was compiled.
+create function jit_functions(query text) returns int language plpgsql as
+$$
+declare
+  plan json;
+begin
+  execute 'explain (analyze, costs off, timing off, summary off, format json) '
+    || query into plan;
+  return (plan->0->'JIT'->>'Functions')::int;
+end;
+$$;
+
+set jit = on;
+set jit_above_cost = 0;
+set jit_optimize_above_cost = -1;
+set jit_inline_above_cost = -1;
+set max_parallel_workers_per_gather = 0;
+
+-- The first query emits the function deforming jit_tab's tuples, the second
+-- one takes it from the session's cache.
+select jit_functions('select sum(a) from jit_tab') -
+       jit_functions('select sum(a) from jit_tab') as cached;
+
+-- Without the cache, both compile it.
+set jit_deform_cache = off;
+select jit_functions('select sum(a) from jit_tab') -
+       jit_functions('select sum(a) from jit_tab') as cached;
+reset jit_deform_cache;
+
+-- Nor is the cache used when the code is optimized.
+set jit_optimize_above_cost = 0;
+select jit_functions('select sum(a) from jit_tab') -
+       jit_functions('select sum(a) from jit_tab') as cached;
+reset jit_optimize_above_cost;
+
+-- Return the number of expressions EXPLAIN ANALYZE reports as compiled
+-- after jit_expr_threshold evaluations, or 0 if nothing was compiled.
+create function jit_deferred(query text) returns int language plpgsql as
+$$
+declare
+  plan json;
+begin
+  execute 'explain (analyze, costs off, timing off, summary off, format json) '
+    || query into plan;
+  return coalesce((plan->0->'JIT'->>'Deferred Expressions')::int, 0);
+end;
+$$;
+
+-- The aggregate's transition expression is evaluated once per row, so it
+-- gets compiled after 100 evaluations, but not if it never gets that far.
+set jit_expr_threshold = 100;
+select jit_deferred('select sum(a) from jit_tab') > 0 as deferred;
+set jit_expr_threshold = 1000000;
+select jit_deferred('select sum(a) from jit_tab') > 0 as deferred;
+
+-- The query still has to be expensive enough to be JIT compiled at all.
+set jit_expr_threshold = 100;
+set jit_above_cost = 1000000000;
+select jit_deferred('select sum(a) from jit_tab') > 0 as deferred;
+reset jit_expr_threshold;
+
+reset jit_inline_above_cost;
+reset jit_above_cost;
+reset jit;
+reset max_parallel_workers_per_gather;
+
+drop function jit_functions(text);
+drop function jit_deferred(text);
+drop table jit_tab;
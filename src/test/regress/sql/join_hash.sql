@@ -418,7 +418,16 @@ explain (costs off)
 select  count(*) from simple r full outer join simple s using (id);
 rollback to settings;
 
--- parallelism not possible with parallel-oblivious outer hash join
+-- parallelism not possible with parallel-oblivious full hash join
+savepoint settings;
+set enable_parallel_hash = off;
+set local max_parallel_workers_per_gather = 2;
+explain (costs off)
+     select  count(*) from simple r full outer join simple s using (id);
+select  count(*) from simple r full outer join simple s using (id);
+rollback to settings;
+
+-- parallelism is possible with parallel-aware full hash join
 savepoint settings;
 set local max_parallel_workers_per_gather = 2;
 explain (costs off)
@@ -436,12 +445,63 @@ explain (costs off)
 select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
 rollback to settings;
 
--- parallelism not possible with parallel-oblivious outer hash join
+-- parallelism not possible with parallel-oblivious full hash join
+savepoint settings;
+set enable_parallel_hash = off;
+set local max_parallel_workers_per_gather = 2;
+explain (costs off)
+     select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
+select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
+rollback to settings;
+
+-- parallelism is possible with parallel-aware full hash join
+savepoint settings;
+set local max_parallel_workers_per_gather = 2;
+explain (costs off)
+     select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
+select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
+rollback to settings;
+
+-- A full outer join whose inner side has been HOT-updated.  The new row
+-- versions are heap-only tuples, and HEAP_ONLY_TUPLE is the same bit as
+-- the hash join match flag, so loading them must clear it or the inner
+-- rows that have no match would be lost.
 savepoint settings;
 set local max_parallel_workers_per_gather = 2;
+create table join_hot (id int, t text) with (fillfactor = 50);
+insert into join_hot select generate_series(19501, 20500), 'x';
+update join_hot set t = 'y';
+analyze join_hot;
+explain (costs off)
+     select  count(*), count(r.id), count(s.id) from simple r full outer join join_hot s using (id);
+select  count(*), count(r.id), count(s.id) from simple r full outer join join_hot s using (id);
+rollback to settings;
+
+-- A right outer join where only some records are matched; the unmatched
+-- ones are emitted by the PHJ_BATCH_SCANNING phase.
+
+-- parallelism is possible with parallel-aware right hash join
+savepoint settings;
+set local max_parallel_workers_per_gather = 2;
+explain (costs off)
+     select  count(*), count(r.id) from simple r right outer join bigger_than_it_looks s on (r.id = s.id * 2);
+select  count(*), count(r.id) from simple r right outer join bigger_than_it_looks s on (r.id = s.id * 2);
+rollback to settings;
+
+-- multi-batch parallel-aware full hash join, without the leader, so that
+-- the scan for unmatched tuples is done by a worker for every batch
+savepoint settings;
+set local max_parallel_workers_per_gather = 2;
+set local work_mem = '128kB';
+set local parallel_leader_participation = off;
 explain (costs off)
      select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
 select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
+select final > 1 as multibatch
+  from hash_join_batches(
+$$
+  select  count(*) from simple r full outer join simple s on (r.id = 0 - s.id);
+$$);
 rollback to settings;
 
 -- exercise special code paths for huge tuples (note use of non-strict
@@ -467,6 +527,84 @@ $$
 $$);
 rollback to settings;
 
+-- A Bloom filter built over the inner side's hash values lets a
+-- parallel-oblivious join skip probing for outer tuples that can't
+-- match.  Only every third outer tuple has a match, so the filter must
+-- reject some of the others, but never one that matches.
+create or replace function hash_join_bloom(query text)
+returns table (probes bigint, rejections bigint) language plpgsql
+as
+$$
+declare
+  whole_plan json;
+  hash_node json;
+begin
+  for whole_plan in
+    execute 'explain (analyze, format ''json'') ' || query
+  loop
+    hash_node := find_hash(json_extract_path(whole_plan, '0', 'Plan'));
+    probes := hash_node->>'Bloom Filter Probes';
+    rejections := hash_node->>'Bloom Filter Rejections';
+    return next;
+  end loop;
+end;
+$$;
+create table bloom_probe as
+  select case when i % 3 = 0 then i / 3 else -i end as id, repeat('x', 100) as t
+  from generate_series(1, 60000) i;
+analyze bloom_probe;
+
+-- left join, single batch
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local enable_mergejoin = off;
+set local work_mem = '4MB';
+explain (costs off)
+  select count(*) from bloom_probe p left join simple s using (id);
+select count(*), count(s.id) from bloom_probe p left join simple s using (id);
+select probes, rejections between 1 and 40000 as rejected
+  from hash_join_bloom(
+$$
+  select count(*) from bloom_probe p left join simple s using (id);
+$$);
+rollback to settings;
+
+-- anti join, single batch
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local enable_mergejoin = off;
+set local work_mem = '4MB';
+explain (costs off)
+  select count(*) from bloom_probe p where not exists (select 1 from simple s where s.id = p.id);
+select count(*) from bloom_probe p where not exists (select 1 from simple s where s.id = p.id);
+select probes, rejections between 1 and 40000 as rejected
+  from hash_join_bloom(
+$$
+  select count(*) from bloom_probe p where not exists (select 1 from simple s where s.id = p.id);
+$$);
+rollback to settings;
+
+-- left join, multi-batch: outer tuples rejected while the first batch is
+-- processed are null-extended right away, instead of being written out
+savepoint settings;
+set local max_parallel_workers_per_gather = 0;
+set local enable_mergejoin = off;
+set local work_mem = '128kB';
+explain (costs off)
+  select count(*) from bloom_probe p left join simple s using (id);
+select count(*), count(s.id) from bloom_probe p left join simple s using (id);
+select final > 1 as multibatch
+  from hash_join_batches(
+$$
+  select count(*) from bloom_probe p left join simple s using (id);
+$$);
+select probes, rejections between 1 and 40000 as rejected
+  from hash_join_bloom(
+$$
+  select count(*) from bloom_probe p left join simple s using (id);
+$$);
+rollback to settings;
+
 rollback;
 
 
@@ -328,6 +328,21 @@ explain (costs off)
 
 select fivethous from tenk1 order by fivethous limit 4;
 
+-- parallel-aware sort, with the leader merging the workers' sorted runs
+set work_mem = '64kB';
+set parallel_tuple_cost = 0.1;
+explain (costs off)
+  select four, unique1 from tenk1 order by four, unique1 offset 9995;
+select four, unique1 from tenk1 order by four, unique1 offset 9995;
+
+-- same, with parallel leader participation disabled
+set parallel_leader_participation = off;
+select four, unique1 from tenk1 order by four, unique1 offset 9995;
+
+reset parallel_leader_participation;
+set parallel_tuple_cost = 0;
+reset work_mem;
+
 -- gather merge test with 0 worker
 set max_parallel_workers = 0;
 explain (costs off)
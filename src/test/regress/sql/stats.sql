@@ -19,10 +19,13 @@ CREATE TABLE prevstats AS
 SELECT t.seq_scan, t.seq_tup_read, t.idx_scan, t.idx_tup_fetch,
        (b.heap_blks_read + b.heap_blks_hit) AS heap_blks,
        (b.idx_blks_read + b.idx_blks_hit) AS idx_blks,
-       pg_stat_get_snapshot_timestamp() as snap_ts
+       pg_stat_get_snapshot_timestamp() as snap_ts,
+       w.wal_records
   FROM pg_catalog.pg_stat_user_tables AS t,
-       pg_catalog.pg_statio_user_tables AS b
- WHERE t.relname='tenk2' AND b.relname='tenk2';
+       pg_catalog.pg_statio_user_tables AS b,
+       pg_catalog.pg_stat_wal AS w
+ WHERE t.relname='tenk2' AND b.relname='tenk2'
+   AND w.backend_type='client backend';
 
 -- function to wait for counters to advance
 create function wait_for_stats() returns void as $$
@@ -32,6 +35,7 @@ declare
   updated2 bool;
   updated3 bool;
   updated4 bool;
+  updated5 bool;
 begin
   -- we don't want to wait forever; loop will exit after 30 seconds
   for i in 1 .. 300 loop
@@ -61,7 +65,12 @@ begin
     SELECT (pr.snap_ts < pg_stat_get_snapshot_timestamp()) INTO updated4
       FROM prevstats AS pr;
 
-    exit when updated1 and updated2 and updated3 and updated4;
+    -- check to see if the WAL we generated has been sensed
+    SELECT (w.wal_records > pr.wal_records) INTO updated5
+      FROM pg_stat_wal AS w, prevstats AS pr
+     WHERE w.backend_type='client backend';
+
+    exit when updated1 and updated2 and updated3 and updated4 and updated5;
 
     -- wait a little
     perform pg_sleep_for('100 milliseconds');
@@ -143,6 +152,28 @@ SET enable_bitmapscan TO off;
 SELECT count(*) FROM tenk2 WHERE unique1 = 1;
 RESET enable_bitmapscan;
 
+-- EXPLAIN (ANALYZE, WAL) reports the WAL generated by each plan node
+CREATE TABLE wal_usage_test (a int);
+create function explain_wal(query text, out records bigint, out bytes_ok bool)
+as $$
+declare
+  whole_plan json;
+  node json;
+begin
+  execute 'explain (analyze, wal, costs off, timing off, summary off, format ''json'') '
+          || query into strict whole_plan;
+  node := whole_plan->0->'Plan';
+  records := node->>'WAL Records';
+  bytes_ok := (node->>'WAL Bytes')::numeric > 0;
+end
+$$ language plpgsql;
+SELECT * FROM explain_wal('INSERT INTO wal_usage_test SELECT g FROM generate_series(1, 10) g');
+-- nothing is shown for nodes that generate no WAL
+EXPLAIN (ANALYZE, WAL, COSTS OFF, TIMING OFF, SUMMARY OFF) SELECT 1;
+EXPLAIN (WAL) SELECT 1;  -- fail, requires ANALYZE
+DROP FUNCTION explain_wal(text);
+DROP TABLE wal_usage_test;
+
 -- We can't just call wait_for_stats() at this point, because we only
 -- transmit stats when the session goes idle, and we probably didn't
 -- transmit the last couple of counts yet thanks to the rate-limiting logic
@@ -174,6 +205,31 @@ SELECT st.heap_blks_read + st.heap_blks_hit >= pr.heap_blks + cl.relpages,
 SELECT pr.snap_ts < pg_stat_get_snapshot_timestamp() as snapshot_newer
 FROM prevstats AS pr;
 
+-- check that the WAL generated above has been counted
+SELECT w.wal_records > pr.wal_records AS wal_records_advanced,
+       w.wal_bytes > 0 AS wal_bytes_positive
+  FROM pg_stat_wal AS w, prevstats AS pr
+ WHERE w.backend_type='client backend';
+
+-- WAL statistics can be reset separately
+SELECT pg_stat_reset_shared('wal');
+SELECT pg_stat_reset_shared('unknown');  -- fail
+
+-- group commit statistics are kept in shared memory, so a commit made with
+-- synchronous_commit on is counted at once
+SELECT flush_requests AS prev_flush_requests FROM pg_stat_group_commit \gset
+SET commit_delay = -1;
+INSERT INTO trunc_stats_test DEFAULT VALUES;
+SELECT flush_requests > :prev_flush_requests AS flush_requests_advanced,
+       flushes > 0 AS flushes_positive,
+       avg_batch_size >= 1 AS avg_batch_size_ok,
+       commit_delay BETWEEN 0 AND 10000 AS commit_delay_ok
+  FROM pg_stat_group_commit;
+-- the delay shown is the server's, not this session's setting
+SET commit_delay = 12345;
+SELECT commit_delay <> 12345 AS commit_delay_not_local FROM pg_stat_group_commit;
+RESET commit_delay;
+
 DROP TABLE trunc_stats_test, trunc_stats_test1, trunc_stats_test2, trunc_stats_test3, trunc_stats_test4;
 DROP TABLE prevstats;
 -- End of Stats Test
@@ -296,3 +296,103 @@ EXPLAIN (COSTS OFF) :qry;
 :qry;
 
 COMMIT;
+
+
+----
+-- test radix sort of integer and timestamp keys
+----
+
+-- Check that an array is in the given order, without sorting anything.
+CREATE FUNCTION radix_sorted(a anyarray, descending bool, nulls_first bool)
+RETURNS bool LANGUAGE sql AS $$
+  SELECT NOT EXISTS (
+    SELECT FROM unnest(a) WITH ORDINALITY p(v, n)
+      JOIN unnest(a) WITH ORDINALITY q(v, n) ON q.n = p.n + 1
+    WHERE CASE WHEN p.v IS NULL OR q.v IS NULL
+               THEN (p.v IS NULL AND q.v IS NOT NULL AND NOT nulls_first) OR
+                    (p.v IS NOT NULL AND q.v IS NULL AND nulls_first)
+               WHEN descending THEN p.v < q.v
+               ELSE p.v > q.v END)
+$$;
+
+-- Enough rows for radix sort, with NULLs, duplicates of values on either
+-- side of the byte boundaries of the keys, and the extremes of int4.
+CREATE TEMP TABLE radix_sort_keys AS
+  SELECT i4, i4::int8 * 4294967295 + i4 AS i8,
+         timestamp '2000-01-01' + i4 * interval '1 second' AS ts,
+         date '2000-01-01' + i4 / 100 AS d
+  FROM (
+    SELECT CASE WHEN g % 500 = 0 THEN NULL ELSE (g * 7919) % 100003 - 50000 END
+    FROM generate_series(1, 20000) g
+    UNION ALL
+    SELECT b + o
+    FROM unnest(ARRAY[0, 256, -256, 65536, -65536, 16777216, -16777216]) b,
+         generate_series(-2, 2) o, generate_series(1, 3) r
+    UNION ALL
+    SELECT unnest(ARRAY[2147483647, '-2147483648', 2147483647, '-2147483648', NULL]::int[])
+  ) s(i4);
+
+-- Datum sorts, of int4 and date (int32 keys) and of int8 and timestamp
+-- (int64 keys, where those are passed by value)
+SELECT
+    radix_sorted(array_agg(i4 ORDER BY i4), false, false) AS asc,
+    radix_sorted(array_agg(i4 ORDER BY i4 DESC), true, true) AS desc,
+    radix_sorted(array_agg(i4 ORDER BY i4 NULLS FIRST), false, true) AS asc_nulls_first,
+    radix_sorted(array_agg(i4 ORDER BY i4 DESC NULLS LAST), true, false) AS desc_nulls_last
+FROM radix_sort_keys;
+SELECT
+    radix_sorted(array_agg(i8 ORDER BY i8), false, false) AS asc,
+    radix_sorted(array_agg(i8 ORDER BY i8 DESC), true, true) AS desc,
+    radix_sorted(array_agg(i8 ORDER BY i8 NULLS FIRST), false, true) AS asc_nulls_first,
+    radix_sorted(array_agg(i8 ORDER BY i8 DESC NULLS LAST), true, false) AS desc_nulls_last
+FROM radix_sort_keys;
+SELECT
+    radix_sorted(array_agg(d ORDER BY d), false, false) AS asc,
+    radix_sorted(array_agg(d ORDER BY d DESC), true, true) AS desc,
+    radix_sorted(array_agg(d ORDER BY d NULLS FIRST), false, true) AS asc_nulls_first,
+    radix_sorted(array_agg(d ORDER BY d DESC NULLS LAST), true, false) AS desc_nulls_last
+FROM radix_sort_keys;
+SELECT
+    radix_sorted(array_agg(ts ORDER BY ts), false, false) AS asc,
+    radix_sorted(array_agg(ts ORDER BY ts DESC), true, true) AS desc,
+    radix_sorted(array_agg(ts ORDER BY ts NULLS FIRST), false, true) AS asc_nulls_first,
+    radix_sorted(array_agg(ts ORDER BY ts DESC NULLS LAST), true, false) AS desc_nulls_last
+FROM radix_sort_keys;
+
+-- no rows get lost or duplicated
+SELECT
+    (SELECT sum(v) FROM unnest(array_agg(i4 ORDER BY i4 DESC)) v) = sum(i4) AS i4_sum,
+    (SELECT sum(v) FROM unnest(array_agg(i8 ORDER BY i8)) v) = sum(i8) AS i8_sum,
+    (SELECT count(v) FROM unnest(array_agg(ts ORDER BY ts NULLS FIRST)) v) = count(ts) AS ts_count
+FROM radix_sort_keys;
+
+-- Sort node, single key
+SELECT radix_sorted(array_agg(i4), true, false)
+FROM (SELECT i4 FROM radix_sort_keys ORDER BY i4 DESC NULLS LAST) s;
+SELECT radix_sorted(array_agg(i8), false, true)
+FROM (SELECT i8 FROM radix_sort_keys ORDER BY i8 NULLS FIRST) s;
+SELECT radix_sorted(array_agg(ts), true, true)
+FROM (SELECT ts FROM radix_sort_keys ORDER BY ts DESC) s;
+
+-- Sort node, leading key compared inline, ties broken by the other key
+SELECT radix_sorted(array_agg(i4), true, false), radix_sorted(array_agg(i8), true, false)
+FROM (SELECT i4, i8 FROM radix_sort_keys ORDER BY i4 DESC NULLS LAST, i8 DESC NULLS LAST) s;
+
+-- too few tuples for radix sort, so quicksort is used
+SELECT radix_sorted(array_agg(i4), false, false)
+FROM (SELECT i4 FROM radix_sort_keys WHERE i4 BETWEEN -300 AND 300 OR i4 IS NULL ORDER BY i4) s;
+
+-- not enough memory left for radix sort, so quicksort is used to form runs
+BEGIN;
+SET LOCAL work_mem = '100kB';
+SELECT radix_sorted(array_agg(i4), false, true)
+FROM (SELECT i4 FROM radix_sort_keys ORDER BY i4 NULLS FIRST) s;
+SELECT radix_sorted(array_agg(i8), true, false)
+FROM (SELECT i8 FROM radix_sort_keys ORDER BY i8 DESC NULLS LAST) s;
+SELECT
+    radix_sorted(array_agg(i4 ORDER BY i4), false, false) AS asc,
+    radix_sorted(array_agg(i4 ORDER BY i4 DESC), true, true) AS desc,
+    radix_sorted(array_agg(i4 ORDER BY i4 NULLS FIRST), false, true) AS asc_nulls_first,
+    radix_sorted(array_agg(i4 ORDER BY i4 DESC NULLS LAST), true, false) AS desc_nulls_last
+FROM radix_sort_keys;
+ROLLBACK;